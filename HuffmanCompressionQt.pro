@@ -22,27 +22,97 @@ DEFINES += QT_DEPRECATED_WARNINGS
 # You can also select to disable deprecated APIs only up to a certain version of Qt.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
-CONFIG += c++17
+CONFIG += c++17 thread
+
+# per stage timings (see stats.hpp), remove to compile the timers out
+CONFIG += huffman_stats
+huffman_stats: DEFINES += HUFFMAN_ENABLE_STATS
+
+# allocations of the codec structures by subsystem and process RSS in the stats (see allocstats.hpp),
+# for profiling builds: every allocation of them updates shared counters
+#CONFIG += huffman_alloc_stats
+huffman_alloc_stats: DEFINES += HUFFMAN_ENABLE_ALLOC_STATS
+
+# code for the CPU of the build machine (BMI2 bit packing in bits_utils.hpp),
+# the other kernels are selected at run time anyway (see kernels.hpp)
+#CONFIG += huffman_native
+huffman_native: QMAKE_CXXFLAGS += -march=native
 
 SOURCES += \
+        allocstats.cpp \
+        analysis.cpp \
+        autotune.cpp \
+        benchmark.cpp \
+        blockcodec.cpp \
+        bufferalloc.cpp \
+        bwt.cpp \
+        cli.cpp \
+        decodetable.cpp \
+        decodetree.cpp \
+        dedup.cpp \
+        encodetable.cpp \
         htree.cpp \
+        huffmandevice.cpp \
         huffmanencoding.cpp \
+        iouring.cpp \
+        kernels.cpp \
+        lz77.cpp \
         main.cpp \
-        mainwindow.cpp
+        mainwindow.cpp \
+        memorybudget.cpp \
+        paralleldecoder.cpp \
+        pipeline.cpp \
+        search.cpp \
+        sha256.cpp \
+        stats.cpp \
+        streamcodec.cpp \
+        trace.cpp \
+        verify.cpp \
+        wordcodec.cpp
 
 HEADERS += \
+        allocstats.hpp \
+        analysis.hpp \
+        autotune.hpp \
+        benchmark.hpp \
+        bitreader.hpp \
         bits_array.hpp \
         bits_utils.hpp \
+        bitwriter.hpp \
+        blockcodec.hpp \
+        bounded_queue.hpp \
+        bufferalloc.hpp \
+        bwt.hpp \
+        cli.hpp \
+        decodetable.hpp \
+        decodetree.hpp \
+        dedup.hpp \
+        encodetable.hpp \
         globalconstants.hpp \
         htree.hpp \
+        huffmandevice.hpp \
         huffmanencoding.hpp \
+        iouring.hpp \
         istreambitsiterator.hpp \
+        kernels.hpp \
+        lz77.hpp \
         mainwindow.hpp \
         memory_facilities.hpp \
+        memorybitsiterator.hpp \
+        memorybudget.hpp \
         ostreambitsiterator.hpp \
         packagedtask.hpp \
+        paralleldecoder.hpp \
+        pipeline.hpp \
         priority_queue.hpp \
-        utils.hpp
+        search.hpp \
+        sha256.hpp \
+        stats.hpp \
+        streamcodec.hpp \
+        trace.hpp \
+        utils.hpp \
+        verify.hpp \
+        wordcodec.hpp
 
 FORMS += \
         mainwindow.ui
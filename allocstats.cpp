@@ -0,0 +1,115 @@
+#include "allocstats.hpp"
+
+#include <atomic>
+#include <fstream>
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/resource.h>
+#endif
+
+
+namespace {
+
+struct AllocCounters {
+    std::atomic<std::uint64_t> allocations{0};
+    std::atomic<std::uint64_t> bytes{0};
+    std::atomic<std::uint64_t> liveBytes{0};
+    std::atomic<std::uint64_t> peakBytes{0};
+};
+
+std::array<AllocCounters, ALLOC_SUBSYSTEMS_COUNT> counters;
+AllocCounters totalCounters; // only live and peak bytes
+
+AllocCounters& counters_of(AllocSubsystem subsystem) { return counters[static_cast<std::size_t>(subsystem)]; }
+
+void update_peak(AllocCounters& subsystemCounters, std::uint64_t liveBytes)
+{
+    auto peak = subsystemCounters.peakBytes.load(std::memory_order_relaxed);
+    while(peak < liveBytes && !subsystemCounters.peakBytes.compare_exchange_weak(peak, liveBytes, std::memory_order_relaxed)) {
+    }
+}
+
+}
+
+const char* alloc_subsystem_name(AllocSubsystem subsystem)
+{
+    switch(subsystem) {
+    case AllocSubsystem::Tree: return "tree";
+    case AllocSubsystem::Dict: return "dict";
+    case AllocSubsystem::Tables: return "tables";
+    case AllocSubsystem::Buffers: return "buffers";
+    case AllocSubsystem::Count: break;
+    }
+    return "unknown";
+}
+
+void record_allocation(AllocSubsystem subsystem, std::size_t bytes)
+{
+    auto& subsystemCounters = counters_of(subsystem);
+    subsystemCounters.allocations.fetch_add(1, std::memory_order_relaxed);
+    subsystemCounters.bytes.fetch_add(bytes, std::memory_order_relaxed);
+    const auto liveBytes = subsystemCounters.liveBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    update_peak(subsystemCounters, liveBytes);
+    update_peak(totalCounters, totalCounters.liveBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes);
+}
+
+void record_deallocation(AllocSubsystem subsystem, std::size_t bytes)
+{
+    counters_of(subsystem).liveBytes.fetch_sub(bytes, std::memory_order_relaxed);
+    totalCounters.liveBytes.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+void reset_allocation_peaks()
+{
+    for(auto& subsystemCounters : counters) {
+        subsystemCounters.peakBytes.store(subsystemCounters.liveBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    totalCounters.peakBytes.store(totalCounters.liveBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+AllocSnapshot allocation_snapshot()
+{
+    AllocSnapshot result;
+    for(std::size_t subsystemIndex = 0; subsystemIndex < ALLOC_SUBSYSTEMS_COUNT; ++subsystemIndex) {
+        result[subsystemIndex].allocations = counters[subsystemIndex].allocations.load(std::memory_order_relaxed);
+        result[subsystemIndex].bytes = counters[subsystemIndex].bytes.load(std::memory_order_relaxed);
+        result[subsystemIndex].peakBytes = counters[subsystemIndex].peakBytes.load(std::memory_order_relaxed);
+    }
+    return result;
+}
+
+std::uint64_t allocation_peak()
+{
+    return totalCounters.peakBytes.load(std::memory_order_relaxed);
+}
+
+std::uint64_t current_rss()
+{
+#ifdef __linux__
+    // size and resident pages
+    std::ifstream statm("/proc/self/statm");
+    std::uint64_t sizePages = 0;
+    std::uint64_t residentPages = 0;
+    if(!(statm >> sizePages >> residentPages)) {
+        return 0;
+    }
+    const auto pageSize = sysconf(_SC_PAGESIZE);
+    return pageSize > 0 ? residentPages * static_cast<std::uint64_t>(pageSize) : 0;
+#else
+    return 0;
+#endif
+}
+
+std::uint64_t max_rss()
+{
+#ifdef __linux__
+    rusage usage{};
+    if(getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+    return static_cast<std::uint64_t>(usage.ru_maxrss) * 1024; // in KiB on Linux
+#else
+    return 0;
+#endif
+}
@@ -0,0 +1,90 @@
+#ifndef ALLOCSTATS_HPP
+#define ALLOCSTATS_HPP
+
+#include <array>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+
+// Build with HUFFMAN_ENABLE_ALLOC_STATS defined (CONFIG += huffman_alloc_stats) to count the allocations
+// of the codec structures by subsystem, otherwise tracked_allocator is its Base allocator and costs nothing.
+// The counters are process wide, concurrent operations see the allocations of each other.
+
+enum class AllocSubsystem : std::uint8_t {
+    Tree,    // HTree nodes
+    Dict,    // HuffmanDict
+    Tables,  // encode and decode tables
+    Buffers, // BytesBuffer: blocks, streams, I/O
+    Count
+};
+
+constexpr auto ALLOC_SUBSYSTEMS_COUNT = static_cast<std::size_t>(AllocSubsystem::Count);
+const char* alloc_subsystem_name(AllocSubsystem subsystem);
+
+struct AllocStats {
+    std::uint64_t allocations = 0;
+    std::uint64_t bytes = 0;     // выделено всего
+    std::uint64_t peakBytes = 0; // максимум живых одновременно
+};
+
+using AllocSnapshot = std::array<AllocStats, ALLOC_SUBSYSTEMS_COUNT>;
+
+void record_allocation(AllocSubsystem subsystem, std::size_t bytes);
+void record_deallocation(AllocSubsystem subsystem, std::size_t bytes);
+// the peaks start again from the live bytes, so the next snapshot has the peaks since now
+void reset_allocation_peaks();
+AllocSnapshot allocation_snapshot();
+// the most live bytes of all subsystems together
+std::uint64_t allocation_peak();
+
+// resident set size of the process, 0 if unknown (only Linux is supported)
+std::uint64_t current_rss();
+// the largest resident set size of the process so far, 0 if unknown (only Linux is supported)
+std::uint64_t max_rss();
+
+#ifdef HUFFMAN_ENABLE_ALLOC_STATS
+
+// Base is stateless
+template<class T, AllocSubsystem Subsystem, class Base = std::allocator<T>>
+class TrackingAllocator {
+public:
+    using value_type = T;
+
+    template<class U>
+    struct rebind { using other = TrackingAllocator<U, Subsystem, typename std::allocator_traits<Base>::template rebind_alloc<U>>; };
+
+    TrackingAllocator() noexcept = default;
+    template<class U, class OtherBase>
+    TrackingAllocator(const TrackingAllocator<U, Subsystem, OtherBase>&) noexcept {}
+
+    T* allocate(std::size_t count)
+    {
+        auto* result = Base().allocate(count);
+        record_allocation(Subsystem, count * sizeof(T));
+        return result;
+    }
+
+    void deallocate(T* pointer, std::size_t count) noexcept
+    {
+        record_deallocation(Subsystem, count * sizeof(T));
+        Base().deallocate(pointer, count);
+    }
+
+    template<class U, class OtherBase>
+    bool operator==(const TrackingAllocator<U, Subsystem, OtherBase>&) const noexcept { return true; }
+    template<class U, class OtherBase>
+    bool operator!=(const TrackingAllocator<U, Subsystem, OtherBase>&) const noexcept { return false; }
+};
+
+template<class T, AllocSubsystem Subsystem, class Base = std::allocator<T>>
+using tracked_allocator = TrackingAllocator<T, Subsystem, Base>;
+
+#else
+
+template<class T, AllocSubsystem, class Base = std::allocator<T>>
+using tracked_allocator = Base;
+
+#endif // HUFFMAN_ENABLE_ALLOC_STATS
+
+#endif // ALLOCSTATS_HPP
@@ -0,0 +1,108 @@
+#include "analysis.hpp"
+#include "blockcodec.hpp"
+#include "kernels.hpp"
+
+#include <fstream>
+#include <iomanip>
+#include <numeric>
+#include <cassert>
+#include <cmath>
+
+
+double entropy(const CharFrequencies& frequencies)
+{
+    const auto total = std::accumulate(std::cbegin(frequencies), std::cend(frequencies), std::uint64_t{0});
+    if(total == 0) {
+        return 0.0;
+    }
+
+    double result = 0.0;
+    for(const auto frequency : frequencies) {
+        if(frequency == 0) {
+            continue;
+        }
+
+        const double probability = static_cast<double>(frequency) / static_cast<double>(total);
+        result -= probability * std::log2(probability);
+    }
+    return result;
+}
+
+BlockAnalysis analyze_block(const CharFrequencies& frequencies, std::uint64_t offset)
+{
+    HTree tree;
+    tree.setFrequencies(frequencies);
+
+    BlockAnalysis result;
+    result.offset = offset;
+    result.size = tree.dataSize();
+    result.encodedSize = sizeof(BlockHeader) + huffman_payload_size(tree);
+    result.entropy = entropy(frequencies);
+    result.stored = result.encodedSize >= sizeof(BlockHeader) + result.size;
+    return result;
+}
+
+std::vector<BlockAnalysis> analyze_data(std::istream& inputStream, std::size_t blockSize)
+{
+    assert(blockSize > 0);
+
+    std::vector<BlockAnalysis> result;
+    std::vector<char> buffer(blockSize);
+    std::uint64_t offset = 0;
+    while(inputStream) {
+        inputStream.read(buffer.data(), std::streamsize(buffer.size()));
+        const auto countRead = static_cast<std::size_t>(inputStream.gcount());
+        if(countRead == 0) {
+            break;
+        }
+
+        CharFrequencies frequencies{0};
+        count_bytes(reinterpret_cast<const std::uint8_t*>(buffer.data()), countRead, frequencies.data());
+        result.push_back(analyze_block(frequencies, offset));
+        offset += countRead;
+    }
+    return result;
+}
+
+std::vector<BlockAnalysis> analyze_file(const std::string& from, std::size_t blockSize)
+{
+    std::ifstream from_file(from, std::ios::in | std::ios::binary);
+    if(!from_file) {
+        throw std::runtime_error{"Unable to open file: \"" + from + "\" to read"};
+    }
+
+    return analyze_data(from_file, blockSize);
+}
+
+void print_analysis(const std::vector<BlockAnalysis>& blocks, std::ostream& outputStream)
+{
+    outputStream << std::setw(8) << "block"
+                 << std::setw(14) << "offset"
+                 << std::setw(12) << "size"
+                 << std::setw(12) << "encoded"
+                 << std::setw(10) << "entropy"
+                 << std::setw(8) << "mode" << '\n';
+
+    std::uint64_t totalSize = 0;
+    std::uint64_t totalEncoded = sizeof(BlocksHeader);
+    for(std::size_t blockIndex = 0; blockIndex < blocks.size(); ++blockIndex) {
+        const auto& block = blocks[blockIndex];
+        const auto blockEncoded = block.stored ? sizeof(BlockHeader) + block.size : block.encodedSize;
+        totalSize += block.size;
+        totalEncoded += blockEncoded;
+
+        outputStream << std::setw(8) << blockIndex
+                     << std::setw(14) << block.offset
+                     << std::setw(12) << block.size
+                     << std::setw(12) << blockEncoded
+                     << std::setw(10) << std::fixed << std::setprecision(3) << block.entropy
+                     << std::setw(8) << (block.stored ? "stored" : "huffman") << '\n';
+    }
+
+    outputStream << "total: " << totalSize << " -> " << totalEncoded << " bytes";
+    if(totalSize > 0) {
+        outputStream << " (" << std::fixed << std::setprecision(2)
+                     << 100.0 * static_cast<double>(totalEncoded) / static_cast<double>(totalSize) << "%)";
+    }
+    outputStream << '\n';
+}
@@ -0,0 +1,27 @@
+#ifndef ANALYSIS_HPP
+#define ANALYSIS_HPP
+
+#include "htree.hpp"
+
+#include <vector>
+#include <string>
+#include <iostream>
+
+
+struct BlockAnalysis {
+    std::uint64_t offset = 0;       // offset of the block in source data
+    std::uint64_t size = 0;         // size of the block in bytes
+    std::uint64_t encodedSize = 0;  // exact size of the Huffman encoded block with its header
+    double entropy = 0.0;           // order-0 entropy, bits per byte
+    bool stored = false;            // block wouldn't shrink and would be stored as is
+};
+
+double entropy(const CharFrequencies& frequencies);
+BlockAnalysis analyze_block(const CharFrequencies& frequencies, std::uint64_t offset);
+
+std::vector<BlockAnalysis> analyze_data(std::istream& inputStream, std::size_t blockSize);
+std::vector<BlockAnalysis> analyze_file(const std::string& from, std::size_t blockSize = DEFAULT_BLOCK_SIZE);
+
+void print_analysis(const std::vector<BlockAnalysis>& blocks, std::ostream& outputStream);
+
+#endif // ANALYSIS_HPP
@@ -0,0 +1,257 @@
+#include "autotune.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <thread>
+#include <atomic>
+#include <exception>
+#include <algorithm>
+#include <stdexcept>
+
+
+namespace {
+
+// the sample is about 1/SAMPLE_FRACTION of the file, so the tuning costs a fraction of the compression,
+// it is taken in SAMPLE_SLICES slices, a file of up to MIN_SAMPLE_SIZE bytes is the sample itself
+constexpr std::uint64_t SAMPLE_FRACTION = 32;
+constexpr std::uint64_t MIN_SAMPLE_SIZE = 1024 * 1024;
+constexpr std::size_t SAMPLE_SLICES = 2;
+constexpr std::size_t MAX_SLICE_SIZE = 4 * 1024 * 1024;
+
+// besides DEFAULT_BLOCK_SIZE
+constexpr std::size_t TUNE_BLOCK_SIZES[] = {256 * 1024, 4 * 1024 * 1024};
+
+struct TuneMode {
+    CompressionLevel level;
+    BlockTransform transform;
+};
+
+constexpr TuneMode TUNE_MODES[] = {
+    {CompressionLevel::Fast, BlockTransform::None},
+    {CompressionLevel::Default, BlockTransform::None},
+    {CompressionLevel::Max, BlockTransform::None},
+    {CompressionLevel::Default, BlockTransform::Lz77},
+    {CompressionLevel::Default, BlockTransform::Bwt},
+    {CompressionLevel::Default, BlockTransform::Words}
+};
+
+const char* level_name(CompressionLevel level)
+{
+    switch(level) {
+    case CompressionLevel::Fast: return "fast";
+    case CompressionLevel::Default: return "default";
+    case CompressionLevel::Max: return "max";
+    }
+    return "unknown";
+}
+
+const char* transform_name(BlockTransform transform)
+{
+    switch(transform) {
+    case BlockTransform::None: return "none";
+    case BlockTransform::Bwt: return "bwt";
+    case BlockTransform::Lz77: return "lz77";
+    case BlockTransform::Words: return "words";
+    }
+    return "unknown";
+}
+
+double to_megabytes(std::uint64_t bytes) { return static_cast<double>(bytes) / (1024.0 * 1024.0); }
+
+std::vector<BytesBuffer> read_sample(const std::string& path, std::uint64_t& fileSize)
+{
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    if(!file) {
+        throw std::runtime_error{"Unable to open file: \"" + path + "\" to read"};
+    }
+    fileSize = static_cast<std::uint64_t>(file.seekg(0, std::ios::end).tellg());
+
+    const auto sampleSize = std::max(fileSize / SAMPLE_FRACTION, MIN_SAMPLE_SIZE);
+    const bool isWhole = fileSize <= sampleSize;
+    const auto slicesCount = isWhole ? std::size_t{1} : SAMPLE_SLICES;
+    const auto sliceSize = isWhole ? static_cast<std::size_t>(fileSize) : static_cast<std::size_t>(std::min<std::uint64_t>(sampleSize / SAMPLE_SLICES, MAX_SLICE_SIZE));
+
+    // the slices are in the middles of equal parts of the file
+    std::vector<BytesBuffer> result(slicesCount, BytesBuffer(sliceSize));
+    for(std::size_t sliceIndex = 0; sliceIndex < slicesCount; ++sliceIndex) {
+        const auto offset = (fileSize - sliceSize) * (2 * sliceIndex + 1) / (2 * slicesCount);
+        file.seekg(static_cast<std::streamoff>(isWhole ? 0 : offset));
+        file.read(reinterpret_cast<char*>(result[sliceIndex].data()), static_cast<std::streamsize>(sliceSize));
+        if(!file) {
+            throw std::runtime_error{"Unable to read file: \"" + path + "\""};
+        }
+    }
+    return result;
+}
+
+// as compress_blocks would encode it
+std::uint64_t compress_sample(const std::vector<BytesBuffer>& sample, const CodecOptions& options)
+{
+    const auto split = (options.level == CompressionLevel::Max && options.transform == BlockTransform::None && options.dedupIndex.empty());
+
+    std::uint64_t result = 0;
+    BytesBuffer block;
+    BytesBuffer output;
+    for(const auto& slice : sample) {
+        for(std::size_t offset = 0; offset < slice.size(); offset += options.blockSize) {
+            const auto* data = slice.data() + offset;
+            const auto size = std::min(options.blockSize, slice.size() - offset);
+            block.assign(data, data + size);
+            const auto parts = split ? split_block(block) : std::vector<std::size_t>{size};
+            for(const auto partSize : parts) {
+                const auto header = encode_part(data, partSize, output, options);
+                result += sizeof(BlockHeader) + header.packedSize;
+                data += partSize;
+            }
+        }
+    }
+    return result;
+}
+
+// every candidate on one of threadsCount threads
+template<class Evaluate>
+void evaluate_candidates(std::vector<TuneCandidate>& candidates, std::size_t first, unsigned threadsCount, const Evaluate& evaluate)
+{
+    std::vector<std::exception_ptr> exceptions(candidates.size());
+    std::atomic<std::size_t> nextCandidate{first};
+    const auto evaluateNext = [&]() {
+        for(auto candidateIndex = nextCandidate++; candidateIndex < candidates.size(); candidateIndex = nextCandidate++) {
+            try { evaluate(candidates[candidateIndex]); }
+            catch(...) { exceptions[candidateIndex] = std::current_exception(); }
+        }
+    };
+
+    const auto count = std::min<std::size_t>(threadsCount, candidates.size() - first);
+    std::vector<std::thread> threads;
+    for(std::size_t threadIndex = 1; threadIndex < count; ++threadIndex) {
+        threads.emplace_back(evaluateNext);
+    }
+    evaluateNext();
+    for(auto& thread : threads) {
+        thread.join();
+    }
+
+    for(const auto& exception : exceptions) {
+        if(exception != nullptr) {
+            std::rethrow_exception(exception);
+        }
+    }
+}
+
+bool is_better(const TuneCandidate& candidate, const TuneCandidate& other, const CodecOptions& options)
+{
+    if(options.tuneGoal == TuneGoal::Speed) {
+        return candidate.megabytesPerSecond > other.megabytesPerSecond;
+    }
+
+    const auto isFast = candidate.megabytesPerSecond >= options.tuneMinSpeed;
+    const auto isOtherFast = other.megabytesPerSecond >= options.tuneMinSpeed;
+    if(isFast != isOtherFast) {
+        return isFast;
+    }
+    // none is fast enough - the closest to it
+    if(!isFast) {
+        return candidate.megabytesPerSecond > other.megabytesPerSecond;
+    }
+    return candidate.compressedSize < other.compressedSize;
+}
+
+std::size_t best_candidate(const std::vector<TuneCandidate>& candidates, const CodecOptions& options)
+{
+    std::size_t result = 0;
+    for(std::size_t candidateIndex = 1; candidateIndex < candidates.size(); ++candidateIndex) {
+        if(is_better(candidates[candidateIndex], candidates[result], options)) {
+            result = candidateIndex;
+        }
+    }
+    return result;
+}
+
+}
+
+TuneResult auto_tune(const std::string& path, const CodecOptions& options)
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    TuneResult result;
+    result.options = options;
+    result.options.tuneGoal = TuneGoal::None;
+
+    std::uint64_t fileSize = 0;
+    const auto sample = read_sample(path, fileSize);
+    for(const auto& slice : sample) {
+        result.sampleSize += slice.size();
+    }
+
+    const auto coresCount = (options.threadsCount != 0) ? options.threadsCount : std::max(1u, std::thread::hardware_concurrency());
+    const auto threadsFor = [&](std::size_t blockSize) {
+        const auto blocksCount = std::max<std::uint64_t>((fileSize + blockSize - 1) / blockSize, 1);
+        return static_cast<unsigned>(std::min<std::uint64_t>(coresCount, blocksCount));
+    };
+
+    const auto evaluate = [&](TuneCandidate& candidate) {
+        StatsScope statsScope{nullptr}; // the stages of the compression only
+
+        CodecOptions candidateOptions = options;
+        candidateOptions.blockSize = candidate.blockSize;
+        candidateOptions.level = candidate.level;
+        candidateOptions.transform = candidate.transform;
+
+        const auto startCpu = thread_cpu_time_ns();
+        candidate.compressedSize = compress_sample(sample, candidateOptions);
+        const auto cpuNs = std::max<std::uint64_t>(thread_cpu_time_ns() - startCpu, 1);
+        candidate.megabytesPerSecond = to_megabytes(result.sampleSize) / (static_cast<double>(cpuNs) / 1e9) * threadsFor(candidate.blockSize);
+    };
+
+    if(result.sampleSize != 0) {
+        // the chunks of deduplication are blocks, their limit isn't tuned
+        const auto deduplication = !options.dedupIndex.empty();
+        const auto modesBlockSize = deduplication ? options.blockSize : static_cast<std::size_t>(DEFAULT_BLOCK_SIZE);
+        for(const auto& mode : TUNE_MODES) {
+            result.candidates.push_back(TuneCandidate{modesBlockSize, mode.level, mode.transform});
+        }
+        evaluate_candidates(result.candidates, 0, coresCount, evaluate);
+        result.chosen = best_candidate(result.candidates, options);
+
+        if(!deduplication) {
+            const auto modesCount = result.candidates.size();
+            const auto best = result.candidates[result.chosen];
+            for(const auto blockSize : TUNE_BLOCK_SIZES) {
+                // larger blocks than the slices would be judged by smaller ones
+                if(blockSize <= sample.front().size()) {
+                    result.candidates.push_back(TuneCandidate{blockSize, best.level, best.transform});
+                }
+            }
+            evaluate_candidates(result.candidates, modesCount, coresCount, evaluate);
+            result.chosen = best_candidate(result.candidates, options);
+        }
+
+        const auto& chosen = result.candidates[result.chosen];
+        result.options.blockSize = chosen.blockSize;
+        result.options.level = chosen.level;
+        result.options.transform = chosen.transform;
+        result.options.threadsCount = threadsFor(chosen.blockSize);
+    }
+
+    const auto wall = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    result.wallNs = static_cast<std::uint64_t>(wall.count());
+    return result;
+}
+
+std::string format_tuning(const TuneResult& result)
+{
+    if(result.candidates.empty()) {
+        return "nothing to sample, settings as given";
+    }
+
+    const auto& chosen = result.candidates[result.chosen];
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1)
+        << "block " << chosen.blockSize / 1024 << " KiB, level " << level_name(chosen.level)
+        << ", transform " << transform_name(chosen.transform) << ", " << result.options.threadsCount << " threads: "
+        << 100.0 * static_cast<double>(chosen.compressedSize) / static_cast<double>(result.sampleSize) << "% of "
+        << to_megabytes(result.sampleSize) << " MB sample, ~" << chosen.megabytesPerSecond << " MB/s ("
+        << result.candidates.size() << " candidates in " << std::setprecision(3) << static_cast<double>(result.wallNs) / 1e9 << " s)";
+    return out.str();
+}
@@ -0,0 +1,37 @@
+#ifndef AUTOTUNE_HPP
+#define AUTOTUNE_HPP
+
+#include "huffmanencoding.hpp"
+
+#include <string>
+#include <vector>
+
+
+// Choice of the block size, level and transform for a file by options.tuneGoal.
+// A few slices spread over the file (about 1/32 of it) are compressed by every candidate, the candidates run concurrently
+// and their speed is taken by CPU time, so it doesn't depend on how many of them share the cores.
+// First the modes (level and transform) compete with the default block size, then the block sizes with the best mode.
+// The threads are the cores (or options.threadsCount), but not more than the blocks of the file.
+
+struct TuneCandidate {
+    std::size_t blockSize = 0;
+    CompressionLevel level = CompressionLevel::Default;
+    BlockTransform transform = BlockTransform::None;
+    std::uint64_t compressedSize = 0; // сжатой выборки, с заголовками блоков
+    double megabytesPerSecond = 0.0;  // оценка для всех потоков
+};
+
+struct TuneResult {
+    CodecOptions options;                  // с выбранными параметрами
+    std::vector<TuneCandidate> candidates; // в порядке проверки
+    std::size_t chosen = 0;                // индекс выбранного в candidates
+    std::uint64_t sampleSize = 0;
+    std::uint64_t wallNs = 0;              // время автонастройки
+};
+
+TuneResult auto_tune(const std::string& path, const CodecOptions& options);
+
+// the chosen settings in one line
+std::string format_tuning(const TuneResult& result);
+
+#endif // AUTOTUNE_HPP
@@ -0,0 +1,115 @@
+#include "benchmark.hpp"
+#include "kernels.hpp"
+#include "bits_array.hpp"
+
+#include <chrono>
+#include <random>
+#include <iomanip>
+#include <cstring>
+#include <cassert>
+
+
+namespace {
+
+constexpr std::uint64_t BYTES_TO_PROCESS = 512 * 1024 * 1024;
+
+// skewed distribution of printable bytes, roughly as in text
+std::vector<std::uint8_t> make_data(std::size_t size)
+{
+    std::mt19937 generator{42};
+    std::geometric_distribution<int> distribution{0.08};
+    std::vector<std::uint8_t> result(size);
+    for(auto& byte : result) {
+        byte = static_cast<std::uint8_t>(' ' + distribution(generator) % 95);
+    }
+    return result;
+}
+
+template<class Function>
+double measure(std::size_t size, Function function)
+{
+    const auto repeats = std::max<std::uint64_t>(1, BYTES_TO_PROCESS / std::max<std::size_t>(size, 1));
+    const auto start = std::chrono::steady_clock::now();
+    for(std::uint64_t repeat = 0; repeat < repeats; ++repeat) {
+        function();
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() > 0.0 ? static_cast<double>(repeats * size) / elapsed.count() / 1e6 : 0.0;
+}
+
+template<class Function, class Run>
+void benchmark_kernel(const char* kernelName, const std::vector<Kernel<Function>>& variants, const Kernel<Function>& selected,
+                      std::size_t size, Run run, std::vector<KernelBenchmark>& results)
+{
+    assert(!variants.empty());
+    const auto expected = run(variants.front().function);
+    for(const auto& variant : variants) {
+        KernelBenchmark result;
+        result.kernel = kernelName;
+        result.name = variant.name;
+        result.supported = variant.supported;
+        result.selected = variant.function == selected.function;
+        if(variant.supported) {
+            result.matches = run(variant.function) == expected;
+            result.megabytesPerSecond = measure(size, [&run, &variant]{ run(variant.function); });
+        }
+        results.push_back(result);
+    }
+}
+
+}
+
+std::vector<KernelBenchmark> benchmark_kernels(std::size_t size)
+{
+    const auto data = make_data(size);
+    std::vector<KernelBenchmark> results;
+
+    benchmark_kernel("histogram", histogram_kernels(), kernels().histogram, size, [&data](HistogramKernel function){
+        std::vector<std::size_t> counts(256, 0);
+        function(data.data(), data.size(), counts.data());
+        return counts;
+    }, results);
+
+    benchmark_kernel("checksum", checksum_kernels(), kernels().checksum, size, [&data](ChecksumKernel function){
+        return function(0, data.data(), data.size());
+    }, results);
+
+    // bit packing is chosen at compile time (see bits_utils.hpp), only its speed is measured
+    KernelBenchmark bits;
+    bits.kernel = "bits";
+    bits.name = HUFFMAN_HAS_BMI2_BITS ? "bmi2" : "portable";
+    bits.supported = bits.selected = bits.matches = true;
+    bits.megabytesPerSecond = measure(size, [&data]{
+        bits_array<std::uint32_t> code;
+        std::uint32_t sum = 0;
+        for(const auto byte : data) {
+            if(code.size() == code.max_size) {
+                sum += code.size();
+                code.clear();
+            }
+            code.push_back(byte & 1);
+        }
+        volatile auto result = sum + code.size();
+        (void)result;
+    });
+    results.push_back(bits);
+
+    return results;
+}
+
+void print_kernels_benchmark(const std::vector<KernelBenchmark>& results, std::ostream& outputStream)
+{
+    outputStream << "cpu: " << format_cpu_features(cpu_features()) << '\n'
+                 << std::left << std::setw(12) << "kernel" << std::setw(12) << "variant"
+                 << std::right << std::setw(12) << "MB/s" << "  state\n";
+
+    for(const auto& result : results) {
+        outputStream << std::left << std::setw(12) << result.kernel << std::setw(12) << result.name << std::right;
+        if(!result.supported) {
+            outputStream << std::setw(12) << "-" << "  unsupported\n";
+            continue;
+        }
+        outputStream << std::setw(12) << std::fixed << std::setprecision(0) << result.megabytesPerSecond
+                     << "  " << (result.matches ? "ok" : "MISMATCH") << (result.selected ? ", selected" : "") << '\n';
+    }
+}
@@ -0,0 +1,24 @@
+#ifndef BENCHMARK_HPP
+#define BENCHMARK_HPP
+
+#include <vector>
+#include <string>
+#include <iostream>
+#include <cstdint>
+
+
+struct KernelBenchmark {
+    std::string kernel;             // histogram, checksum, bits
+    std::string name;               // implementation
+    bool supported = false;         // by this CPU
+    bool selected = false;          // used by the codec
+    bool matches = false;           // gives the same result as the portable implementation
+    double megabytesPerSecond = 0.0;
+};
+
+// runs every supported implementation of the hot kernels on size bytes of text-like data
+std::vector<KernelBenchmark> benchmark_kernels(std::size_t size);
+
+void print_kernels_benchmark(const std::vector<KernelBenchmark>& results, std::ostream& outputStream);
+
+#endif // BENCHMARK_HPP
@@ -0,0 +1,89 @@
+#ifndef BITREADER_HPP
+#define BITREADER_HPP
+
+#include "globalconstants.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <cassert>
+
+
+// Reads bits (most significant first) from memory through 64-bit buffer.
+// Bits after the end of data are read as zeros, consumedBits() tells if they were used.
+class BitReader {
+public:
+    static constexpr unsigned MAX_PEEK_BITS = 56;
+
+    explicit BitReader(const std::uint8_t* first, const std::uint8_t* last)
+        : data_{ first }
+        , size_{ static_cast<std::size_t>(last - first) }
+    { assert(first <= last); }
+
+    // after refill at least MAX_PEEK_BITS bits are available for peek/skip
+    void refill()
+    {
+        if (pos_ + 8 <= size_) {
+            buffer_ |= load_big_endian(data_ + pos_) >> bitsCount_;
+            pos_ += (63 - bitsCount_) / BITS_IN_BYTE;
+            bitsCount_ |= MAX_PEEK_BITS;
+            return;
+        }
+
+        while (bitsCount_ <= MAX_PEEK_BITS) {
+            const std::uint64_t byte = (pos_ < size_) ? data_[pos_] : 0;
+            buffer_ |= byte << (64 - BITS_IN_BYTE - bitsCount_);
+            ++pos_;
+            bitsCount_ += BITS_IN_BYTE;
+        }
+    }
+
+    std::uint32_t peek(unsigned count) const
+    {
+        assert(count > 0 && count <= bitsCount_);
+        return static_cast<std::uint32_t>(buffer_ >> (64 - count));
+    }
+    void skip(unsigned count)
+    {
+        assert(count <= bitsCount_);
+        buffer_ <<= count;
+        bitsCount_ -= count;
+    }
+    bool readBit()
+    {
+        if (bitsCount_ == 0) {
+            refill();
+        }
+        const bool result = buffer_ >> 63;
+        skip(1);
+        return result;
+    }
+
+    std::uint64_t consumedBits() const { return static_cast<std::uint64_t>(pos_) * BITS_IN_BYTE - bitsCount_; }
+    std::uint64_t totalBits() const { return static_cast<std::uint64_t>(size_) * BITS_IN_BYTE; }
+
+private:
+    static std::uint64_t load_big_endian(const std::uint8_t* ptr)
+    {
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+        std::uint64_t result = 0;
+        std::memcpy(&result, ptr, sizeof(result));
+        return __builtin_bswap64(result);
+#else
+        std::uint64_t result = 0;
+        for (int i = 0; i < 8; ++i) {
+            result = (result << BITS_IN_BYTE) | ptr[i];
+        }
+        return result;
+#endif
+    }
+
+private:
+    const std::uint8_t* data_ = nullptr;
+    std::size_t size_ = 0;
+    std::size_t pos_ = 0;
+    std::uint64_t buffer_ = 0;
+    unsigned bitsCount_ = 0;
+};
+
+#endif // BITREADER_HPP
@@ -4,6 +4,12 @@
 #include "globalconstants.hpp"
 
 #include <type_traits>
+#include <cstdint>
+#include <cstddef>
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
 
 
 template<typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
@@ -62,16 +68,56 @@ constexpr T insert_bits(T bits, std::size_t index, std::size_t count, bool value
 */
 
 
+// mask of count most significant bits, count may be 0 and sizeof(T) * 8
+template<typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
+constexpr inline T high_bits_mask(std::size_t count) noexcept
+{
+    constexpr auto bits_count = BITS_IN_BYTE * sizeof(T);
+    constexpr T mask = static_cast<T>(~T{0});
+    return count == 0 ? T{0} : static_cast<T>(mask << (bits_count - count));
+}
+
+// shift which gives 0 instead of UB when all the bits are shifted out
+template<typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
+constexpr inline T shift_right(T bits, std::size_t count) noexcept
+{
+    return count < BITS_IN_BYTE * sizeof(T) ? static_cast<T>(bits >> count) : T{0};
+}
+template<typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
+constexpr inline T shift_left(T bits, std::size_t count) noexcept
+{
+    return count < BITS_IN_BYTE * sizeof(T) ? static_cast<T>(bits << count) : T{0};
+}
+
+// BMI2 versions are compiled in only for the CPUs having them (-mbmi2, -march=native):
+// the functions are too small to be selected by a pointer at run time
+#if defined(__BMI2__) && defined(__GNUC__)
+#define HUFFMAN_HAS_BMI2_BITS 1
+#else
+#define HUFFMAN_HAS_BMI2_BITS 0
+#endif
+
 // optimized version of insert_bits function
 template<typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
 constexpr inline T insert_bits(T bits, std::size_t index, std::size_t count, bool value) noexcept
 {
-    constexpr auto bits_count = BITS_IN_BYTE * sizeof(T);
-    const auto last_inserted_index = index + count;
+    const T kept_mask = high_bits_mask<T>(index);
+    const T inserted_mask = static_cast<T>(high_bits_mask<T>(index + count) & ~kept_mask);
+    const T values = value ? inserted_mask : T{0};
+
+#if HUFFMAN_HAS_BMI2_BITS
+    if constexpr (sizeof(T) == sizeof(std::uint32_t) || sizeof(T) == sizeof(std::uint64_t)) {
+        if (!__builtin_is_constant_evaluated()) {
+            // the rest of bits are deposited around the inserted ones
+            const T deposited = (sizeof(T) == sizeof(std::uint32_t))
+                ? static_cast<T>(_pdep_u32(static_cast<std::uint32_t>(shift_right(bits, count)), static_cast<std::uint32_t>(~inserted_mask)))
+                : static_cast<T>(_pdep_u64(static_cast<std::uint64_t>(shift_right(bits, count)), static_cast<std::uint64_t>(~inserted_mask)));
+            return static_cast<T>(deposited | values);
+        }
+    }
+#endif
 
-    constexpr T mask = ~0;
-    return value ? (((bits >> count) | ((mask << (bits_count - last_inserted_index)))) & (bits | ((mask >> index))))
-        : ((bits >> count) & (mask >> last_inserted_index)) | (bits & (mask << (bits_count - index)));
+    return static_cast<T>((bits & kept_mask) | (shift_right(bits, count) & ~(kept_mask | inserted_mask)) | values);
 }
 
 
@@ -100,8 +146,22 @@ constexpr T erase_bits(T bits, std::size_t index, std::size_t count) noexcept
 template<typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
 constexpr inline T erase_bits(T bits, std::size_t index, std::size_t count) noexcept
 {
-    constexpr T mask = ~0;
-    return (bits & (mask << ((BITS_IN_BYTE * sizeof(T)) - index))) | ((bits << count) & (mask >> index));
+    const T kept_mask = high_bits_mask<T>(index);
+
+#if HUFFMAN_HAS_BMI2_BITS
+    if constexpr (sizeof(T) == sizeof(std::uint32_t) || sizeof(T) == sizeof(std::uint64_t)) {
+        if (!__builtin_is_constant_evaluated()) {
+            // the rest of bits are extracted without the erased ones
+            const T erased_mask = static_cast<T>(high_bits_mask<T>(index + count) & ~kept_mask);
+            const T extracted = (sizeof(T) == sizeof(std::uint32_t))
+                ? static_cast<T>(_pext_u32(static_cast<std::uint32_t>(bits), static_cast<std::uint32_t>(~erased_mask)))
+                : static_cast<T>(_pext_u64(static_cast<std::uint64_t>(bits), static_cast<std::uint64_t>(~erased_mask)));
+            return shift_left(extracted, count);
+        }
+    }
+#endif
+
+    return static_cast<T>((bits & kept_mask) | (shift_left(bits, count) & ~kept_mask));
 }
 
 
@@ -0,0 +1,69 @@
+#ifndef BITWRITER_HPP
+#define BITWRITER_HPP
+
+#include "globalconstants.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <cassert>
+
+
+// Writes bits (most significant first) to memory through 64-bit buffer.
+// Stores whole 8 bytes at a time, so the destination must have 8 spare bytes after the data.
+class BitWriter {
+public:
+    static constexpr unsigned MAX_PUT_BITS = 56;
+
+    explicit BitWriter(std::uint8_t* out) : out_{ out } { assert(out != nullptr); }
+
+    // count low bits of code
+    void put(std::uint64_t code, unsigned count)
+    {
+        assert(count > 0 && count <= MAX_PUT_BITS);
+        assert(bitsCount_ < BITS_IN_BYTE);
+
+        buffer_ |= code << (64 - bitsCount_ - count);
+        bitsCount_ += count;
+
+        // whole bytes are stored, at most 7 bits stay in the buffer
+        store_big_endian(out_, buffer_);
+        const unsigned bytesCount = bitsCount_ / BITS_IN_BYTE;
+        out_ += bytesCount;
+        buffer_ <<= bytesCount * BITS_IN_BYTE;
+        bitsCount_ %= BITS_IN_BYTE;
+    }
+
+    // the first byte not written completely
+    std::uint8_t* position() const { return out_; }
+
+    // writes the last not full byte padded by zeros, returns the end of written data
+    std::uint8_t* finish()
+    {
+        if (bitsCount_ > 0) {
+            *out_++ = static_cast<std::uint8_t>(buffer_ >> (64 - BITS_IN_BYTE));
+            buffer_ = 0;
+            bitsCount_ = 0;
+        }
+        return out_;
+    }
+
+private:
+    static void store_big_endian(std::uint8_t* ptr, std::uint64_t value)
+    {
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+        value = __builtin_bswap64(value);
+        std::memcpy(ptr, &value, sizeof(value));
+#else
+        for (int i = 7; i >= 0; --i, value >>= BITS_IN_BYTE) {
+            ptr[i] = static_cast<std::uint8_t>(value);
+        }
+#endif
+    }
+
+private:
+    std::uint8_t* out_ = nullptr;
+    std::uint64_t buffer_ = 0;
+    unsigned bitsCount_ = 0;
+};
+
+#endif // BITWRITER_HPP
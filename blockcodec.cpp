@@ -0,0 +1,598 @@
+#include "blockcodec.hpp"
+#include "huffmanencoding.hpp"
+#include "memorybitsiterator.hpp"
+#include "htree.hpp"
+#include "decodetable.hpp"
+#include "encodetable.hpp"
+#include "bitwriter.hpp"
+#include "bwt.hpp"
+#include "lz77.hpp"
+#include "wordcodec.hpp"
+#include "kernels.hpp"
+#include "stats.hpp"
+
+#include <stdexcept>
+#include <algorithm>
+#include <limits>
+#include <cstring>
+#include <cassert>
+#include <cmath>
+#include <iterator>
+
+
+namespace {
+
+void throw_corrupted() { throw std::runtime_error{"Corrupted block"}; }
+
+void write_table(const HTree& tree, BytesBuffer& output)
+{
+    const auto& dict = tree.huffmanDict();
+
+    std::vector<SymbolEntry> entries;
+    for(std::size_t byteIndex = 0; byteIndex < dict.size(); ++byteIndex) {
+        const auto& codeBits = dict[byteIndex];
+        if(!codeBits.empty()) {
+            entries.push_back(SymbolEntry{static_cast<std::uint8_t>(byteIndex), static_cast<std::uint8_t>(codeBits.size())});
+        }
+    }
+
+    const auto countEntries = static_cast<std::uint16_t>(entries.size());
+    const auto countPos = output.size();
+    output.resize(countPos + sizeof(countEntries) + sizeof(SymbolEntry) * entries.size());
+    std::memcpy(output.data() + countPos, &countEntries, sizeof(countEntries));
+    std::memcpy(output.data() + countPos + sizeof(countEntries), entries.data(), sizeof(SymbolEntry) * entries.size());
+
+    BufferBitsInserter outIt(output);
+    for(const auto& bitCode : dict) {
+        std::copy(std::cbegin(bitCode), std::cend(bitCode), outIt);
+    }
+    outIt.flush();
+}
+
+const std::uint8_t* read_table(const std::uint8_t* first, const std::uint8_t* last, HuffmanDict& dict)
+{
+    std::uint16_t countEntries = 0;
+    if(last - first < std::ptrdiff_t(sizeof(countEntries))) {
+        throw_corrupted();
+    }
+    std::memcpy(&countEntries, first, sizeof(countEntries));
+    first += sizeof(countEntries);
+
+    if(countEntries == 0 || countEntries > COUNT_FREQUENCIES || last - first < std::ptrdiff_t(sizeof(SymbolEntry) * countEntries)) {
+        throw_corrupted();
+    }
+    std::vector<SymbolEntry> entries(countEntries);
+    std::memcpy(entries.data(), first, sizeof(SymbolEntry) * countEntries);
+    first += sizeof(SymbolEntry) * countEntries;
+
+    std::size_t countCodeBits = 0;
+    for(const auto& entry : entries) {
+        if(entry.count == 0 || entry.count > BitsBuffer::max_size) {
+            throw_corrupted();
+        }
+        countCodeBits += entry.count;
+    }
+
+    const auto countCodeBytes = (countCodeBits + BITS_IN_BYTE - 1) / BITS_IN_BYTE;
+    if(std::size_t(last - first) < countCodeBytes) {
+        throw_corrupted();
+    }
+
+    dict.assign(COUNT_FREQUENCIES, BitsBuffer());
+    MemoryBitsIterator it(first, first + countCodeBytes);
+    for(const auto& entry : entries) {
+        auto& currBitCode = dict.at(entry.symbol);
+        for(std::size_t bitIndex = 0; bitIndex < entry.count; ++bitIndex, ++it) {
+            currBitCode.push_back(*it);
+        }
+    }
+
+    return first + countCodeBytes;
+}
+
+// appends table and data encoded by counted frequencies of the tree
+void write_huffman_payload(const HTree& tree, const std::uint8_t* data, std::size_t size, BytesBuffer& output)
+{
+    write_table(tree, output);
+
+    // the writer stores whole 64-bit words, so there is room for the last one
+    const auto dataPos = output.size();
+    const auto dataSize = (tree.encodedBitsCount() + BITS_IN_BYTE - 1) / BITS_IN_BYTE;
+    output.resize(dataPos + dataSize + sizeof(std::uint64_t));
+
+    const EncodeTable table{tree.huffmanDict(), size};
+    BitWriter writer(output.data() + dataPos);
+    table.encode(data, data + size, writer);
+    output.resize(static_cast<std::size_t>(writer.finish() - output.data()));
+    assert(output.size() == dataPos + dataSize);
+}
+
+HTree make_tree(const std::uint8_t* data, std::size_t size)
+{
+    CharFrequencies frequencies{0};
+    {
+        StageTimer timer{Stage::Histogram};
+        count_bytes(data, size, frequencies.data());
+    }
+
+    HTree tree;
+    tree.setFrequencies(frequencies);
+    return tree;
+}
+
+// the least size of the block without a transform
+std::uint64_t plain_block_size(const std::uint8_t* data, std::size_t size)
+{
+    return std::min<std::uint64_t>(size, huffman_payload_size(make_tree(data, size)));
+}
+
+// false (output is undefined) if the transformed block isn't smaller than Huffman or stored one
+bool encode_bwt_payload(const std::uint8_t* data, std::size_t size, BytesBuffer& output)
+{
+    std::uint32_t primaryIndex = 0;
+    BytesBuffer transformed;
+    {
+        StageTimer timer{Stage::Transform};
+        BytesBuffer lastColumn(size);
+        primaryIndex = bwt_forward(data, size, lastColumn.data());
+        mtf_encode(lastColumn.data(), lastColumn.size());
+        zero_rle_encode(lastColumn.data(), lastColumn.size(), transformed);
+    }
+
+    const auto transformedTree = make_tree(transformed.data(), transformed.size());
+    const auto transformedSize = sizeof(std::uint32_t) * 2 + huffman_payload_size(transformedTree);
+    if(transformedSize >= plain_block_size(data, size)) {
+        return false;
+    }
+
+    StageTimer timer{Stage::Encode};
+    const auto transformedCount = static_cast<std::uint32_t>(transformed.size());
+    output.resize(sizeof(primaryIndex) + sizeof(transformedCount));
+    std::memcpy(output.data(), &primaryIndex, sizeof(primaryIndex));
+    std::memcpy(output.data() + sizeof(primaryIndex), &transformedCount, sizeof(transformedCount));
+    write_huffman_payload(transformedTree, transformed.data(), transformed.size(), output);
+    return true;
+}
+
+LzEffort lz_effort(CompressionLevel level)
+{
+    switch(level) {
+    case CompressionLevel::Fast: return LzEffort{4, 32, false};
+    case CompressionLevel::Default: return LzEffort{32, 128, true};
+    case CompressionLevel::Max: return LzEffort{256, 258, true};
+    }
+    return LzEffort{};
+}
+
+bool encode_lz_payload(const std::uint8_t* data, std::size_t size, CompressionLevel level, BytesBuffer& output)
+{
+    LzStreams streams;
+    {
+        StageTimer timer{Stage::Transform};
+        lz_encode(data, size, lz_effort(level), streams);
+    }
+
+    const BytesBuffer* streamsData[] = {&streams.literals, &streams.literalCodes, &streams.lengthCodes, &streams.distanceCodes};
+    std::vector<HTree> trees;
+    std::uint32_t header[6] = {static_cast<std::uint32_t>(streams.matchesCount()), static_cast<std::uint32_t>(streams.literals.size())};
+    std::uint64_t payloadSize = sizeof(header) + streams.extraBits.size();
+    for(std::size_t streamIndex = 0; streamIndex < std::size(streamsData); ++streamIndex) {
+        const auto& stream = *streamsData[streamIndex];
+        trees.push_back(make_tree(stream.data(), stream.size()));
+        const auto streamSize = stream.empty() ? 0 : huffman_payload_size(trees.back());
+        header[2 + streamIndex] = static_cast<std::uint32_t>(streamSize);
+        payloadSize += streamSize;
+    }
+    if(payloadSize >= plain_block_size(data, size)) {
+        return false;
+    }
+
+    StageTimer timer{Stage::Encode};
+    output.resize(sizeof(header));
+    std::memcpy(output.data(), header, sizeof(header));
+    for(std::size_t streamIndex = 0; streamIndex < std::size(streamsData); ++streamIndex) {
+        const auto& stream = *streamsData[streamIndex];
+        if(!stream.empty()) {
+            write_huffman_payload(trees[streamIndex], stream.data(), stream.size(), output);
+        }
+    }
+    output.insert(output.end(), streams.extraBits.cbegin(), streams.extraBits.cend());
+    assert(output.size() == payloadSize);
+    return true;
+}
+
+bool encode_words_payload(const std::uint8_t* data, std::size_t size, BytesBuffer& output)
+{
+    const auto wordsCount = size / 2;
+    if(wordsCount == 0) {
+        return false;
+    }
+
+    WordFrequencies frequencies;
+    {
+        StageTimer timer{Stage::Histogram};
+        count_words(data, wordsCount, frequencies);
+    }
+
+    CodeLengths lengths;
+    BytesBuffer lengthsRle;
+    {
+        StageTimer timer{Stage::BuildTree};
+        lengths = build_code_lengths(frequencies);
+        while(lengths.back() == 0) {
+            lengths.pop_back();
+        }
+        zero_rle_encode(lengths.data(), lengths.size(), lengthsRle);
+    }
+
+    const WordEncoder encoder{lengths};
+    const auto lengthsTree = make_tree(lengthsRle.data(), lengthsRle.size());
+    const std::uint32_t header[3] = {static_cast<std::uint32_t>(lengths.size()), static_cast<std::uint32_t>(lengthsRle.size()),
+                                     static_cast<std::uint32_t>(huffman_payload_size(lengthsTree))};
+    const auto dataSize = (encoder.encodedBitsCount(frequencies) + BITS_IN_BYTE - 1) / BITS_IN_BYTE;
+    const auto payloadSize = sizeof(header) + size % 2 + header[2] + dataSize;
+    if(payloadSize >= plain_block_size(data, size)) {
+        return false;
+    }
+
+    StageTimer timer{Stage::Encode};
+    output.resize(sizeof(header));
+    std::memcpy(output.data(), header, sizeof(header));
+    if(size % 2 != 0) {
+        output.push_back(data[size - 1]);
+    }
+    write_huffman_payload(lengthsTree, lengthsRle.data(), lengthsRle.size(), output);
+
+    const auto dataPos = output.size();
+    output.resize(dataPos + dataSize + sizeof(std::uint64_t));
+    BitWriter writer(output.data() + dataPos);
+    encoder.encode(data, wordsCount, writer);
+    output.resize(static_cast<std::size_t>(writer.finish() - output.data()));
+    assert(output.size() == payloadSize);
+    return true;
+}
+
+// Fast level: every SAMPLE_STEP bytes SAMPLE_SIZE of them are counted
+constexpr std::size_t SAMPLE_SIZE = 4 * 1024;
+constexpr std::size_t SAMPLE_STEP = 32 * 1024;
+// sampled codes are checked to shrink the block after every piece of this size
+constexpr std::size_t SAMPLED_ENCODE_STEP = 64 * 1024;
+
+void sample_frequencies(const std::uint8_t* data, std::size_t size, CharFrequencies& frequencies)
+{
+    for(std::size_t first = 0; first < size; first += SAMPLE_STEP) {
+        count_bytes(data + first, std::min(SAMPLE_SIZE, size - first), frequencies.data());
+    }
+
+    // bytes missed by the sample still need codes
+    for(auto& frequency : frequencies) {
+        ++frequency;
+    }
+}
+
+// Max level: blocks are made of whole segments, the search is quadratic in their count,
+// so the segments of large blocks are larger
+constexpr std::size_t SPLIT_SEGMENT_SIZE = 16 * 1024;
+constexpr std::size_t SPLIT_MAX_SEGMENTS = 256;
+
+std::size_t split_segment_size(std::size_t size)
+{
+    return std::max(SPLIT_SEGMENT_SIZE, (size + SPLIT_MAX_SEGMENTS - 1) / SPLIT_MAX_SEGMENTS);
+}
+
+// order-0 entropy of the data plus the table and the block header, the block is stored if it is less
+double estimate_block_size(const CharFrequencies& first, const CharFrequencies& last)
+{
+    std::uint64_t total = 0;
+    std::size_t symbolsCount = 0;
+    double bits = 0.0;
+    for(std::size_t symbol = 0; symbol < COUNT_FREQUENCIES; ++symbol) {
+        const auto count = last[symbol] - first[symbol];
+        if(count > 0) {
+            total += count;
+            ++symbolsCount;
+            bits -= static_cast<double>(count) * std::log2(static_cast<double>(count));
+        }
+    }
+    if(total == 0) {
+        return sizeof(BlockHeader);
+    }
+    bits += static_cast<double>(total) * std::log2(static_cast<double>(total));
+
+    // table: count, symbol entries and about log2(symbols) + 1 bits of each code
+    const double tableSize = sizeof(std::uint16_t) + symbolsCount * (sizeof(SymbolEntry) + (std::log2(symbolsCount) + 1) / BITS_IN_BYTE);
+    return sizeof(BlockHeader) + std::min(bits / BITS_IN_BYTE + tableSize, static_cast<double>(total));
+}
+
+// decodes exactly count symbols of Huffman payload
+void decode_huffman_payload(const std::uint8_t* first, const std::uint8_t* last, std::size_t count, std::uint8_t* output)
+{
+    HuffmanDict dict;
+    first = read_table(first, last, dict);
+
+    const auto consumedBits = (count < DecodeTable::MIN_SYMBOLS)
+        ? DecodeTree{dict}.decode(first, last, count, output)
+        : DecodeTable{dict}.decode(first, last, count, output);
+
+    // only the padding of the last byte may remain
+    const auto totalBits = static_cast<std::uint64_t>(last - first) * BITS_IN_BYTE;
+    if(consumedBits > totalBits || totalBits - consumedBits >= BITS_IN_BYTE) {
+        throw_corrupted();
+    }
+}
+
+void decode_bwt_payload(const BlockHeader& header, const BytesBuffer& input, BytesBuffer& output)
+{
+    std::uint32_t primaryIndex = 0;
+    std::uint32_t transformedSize = 0;
+    if(input.size() < sizeof(primaryIndex) + sizeof(transformedSize)) {
+        throw_corrupted();
+    }
+    std::memcpy(&primaryIndex, input.data(), sizeof(primaryIndex));
+    std::memcpy(&transformedSize, input.data() + sizeof(primaryIndex), sizeof(transformedSize));
+    if(primaryIndex > header.rawSize || transformedSize > zero_rle_max_size(header.rawSize)) {
+        throw_corrupted();
+    }
+
+    BytesBuffer transformed(transformedSize);
+    {
+        StageTimer timer{Stage::Decode};
+        decode_huffman_payload(input.data() + sizeof(primaryIndex) + sizeof(transformedSize), input.data() + input.size(),
+                               transformed.size(), transformed.data());
+    }
+
+    StageTimer timer{Stage::Transform};
+    BytesBuffer lastColumn(header.rawSize);
+    zero_rle_decode(transformed.data(), transformed.size(), lastColumn.data(), lastColumn.size());
+    mtf_decode(lastColumn.data(), lastColumn.size());
+    output.resize(header.rawSize);
+    bwt_inverse(lastColumn.data(), lastColumn.size(), primaryIndex, output.data());
+}
+
+void decode_lz_payload(const BlockHeader& header, const BytesBuffer& input, BytesBuffer& output)
+{
+    std::uint32_t sizes[6] = {0};
+    if(input.size() < sizeof(sizes)) {
+        throw_corrupted();
+    }
+    std::memcpy(sizes, input.data(), sizeof(sizes));
+
+    LzStreams streams;
+    BytesBuffer* streamsData[] = {&streams.literals, &streams.literalCodes, &streams.lengthCodes, &streams.distanceCodes};
+    const std::size_t counts[] = {sizes[1], sizes[0], sizes[0], sizes[0]};
+    if(sizes[1] > header.rawSize || sizes[0] > header.rawSize / LZ_MIN_MATCH) {
+        throw_corrupted();
+    }
+
+    const auto* first = input.data() + sizeof(sizes);
+    const auto* last = input.data() + input.size();
+    {
+        StageTimer timer{Stage::Decode};
+        for(std::size_t streamIndex = 0; streamIndex < std::size(streamsData); ++streamIndex) {
+            const auto streamSize = sizes[2 + streamIndex];
+            if(streamSize > static_cast<std::size_t>(last - first) || (streamSize == 0) != (counts[streamIndex] == 0)) {
+                throw_corrupted();
+            }
+            streamsData[streamIndex]->resize(counts[streamIndex]);
+            if(streamSize > 0) {
+                decode_huffman_payload(first, first + streamSize, counts[streamIndex], streamsData[streamIndex]->data());
+            }
+            first += streamSize;
+        }
+    }
+    streams.extraBits.assign(first, last);
+
+    StageTimer timer{Stage::Transform};
+    output.resize(header.rawSize);
+    lz_decode(streams, output.data(), output.size());
+}
+
+void decode_words_payload(const BlockHeader& header, const BytesBuffer& input, BytesBuffer& output)
+{
+    std::uint32_t sizes[3] = {0};
+    const auto tailSize = header.rawSize % 2;
+    if(input.size() < sizeof(sizes) + tailSize) {
+        throw_corrupted();
+    }
+    std::memcpy(sizes, input.data(), sizeof(sizes));
+
+    const auto* first = input.data() + sizeof(sizes) + tailSize;
+    const auto* last = input.data() + input.size();
+    if(sizes[0] == 0 || sizes[0] > WORD_ALPHABET_SIZE || sizes[1] == 0 || sizes[1] > zero_rle_max_size(sizes[0]) ||
+       sizes[2] > static_cast<std::size_t>(last - first)) {
+        throw_corrupted();
+    }
+
+    StageTimer timer{Stage::Decode};
+    BytesBuffer lengthsRle(sizes[1]);
+    decode_huffman_payload(first, first + sizes[2], lengthsRle.size(), lengthsRle.data());
+    CodeLengths lengths(sizes[0]);
+    zero_rle_decode(lengthsRle.data(), lengthsRle.size(), lengths.data(), lengths.size());
+    first += sizes[2];
+
+    output.resize(header.rawSize);
+    const WordDecoder decoder{lengths};
+    const auto consumedBits = decoder.decode(first, last, header.rawSize / 2, output.data());
+
+    // only the padding of the last byte may remain
+    const auto totalBits = static_cast<std::uint64_t>(last - first) * BITS_IN_BYTE;
+    if(consumedBits > totalBits || totalBits - consumedBits >= BITS_IN_BYTE) {
+        throw_corrupted();
+    }
+    if(tailSize != 0) {
+        output.back() = input[sizeof(sizes)];
+    }
+}
+
+void decode_block_data(const BlockHeader& header, const BytesBuffer& input, BytesBuffer& output)
+{
+    if(input.size() != header.packedSize) {
+        throw_corrupted();
+    }
+
+    switch(header.type) {
+    case BlockType::Stored:
+        if(header.rawSize != header.packedSize) {
+            throw_corrupted();
+        }
+        output.assign(input.cbegin(), input.cend());
+        return;
+
+    case BlockType::Huffman: {
+        StageTimer timer{Stage::Decode};
+        output.resize(header.rawSize);
+        decode_huffman_payload(input.data(), input.data() + input.size(), output.size(), output.data());
+        return;
+    }
+
+    case BlockType::Bwt:
+        decode_bwt_payload(header, input, output);
+        return;
+
+    case BlockType::Lz77:
+        decode_lz_payload(header, input, output);
+        return;
+
+    case BlockType::Words:
+        decode_words_payload(header, input, output);
+        return;
+
+    case BlockType::Reference:
+        // resolved by decode_reference, it needs the directory of the archive
+        break;
+    }
+
+    throw_corrupted();
+}
+
+}
+
+std::uint64_t huffman_payload_size(const HTree& tree)
+{
+    return sizeof(std::uint16_t) + dict_size(tree) + (tree.encodedBitsCount() + BITS_IN_BYTE - 1) / BITS_IN_BYTE;
+}
+
+BlockType encode_block(const std::uint8_t* data, std::size_t size, BytesBuffer& output, CompressionLevel level, BlockTransform transform)
+{
+    if(transform == BlockTransform::Bwt && encode_bwt_payload(data, size, output)) {
+        return BlockType::Bwt;
+    }
+    if(transform == BlockTransform::Lz77 && encode_lz_payload(data, size, level, output)) {
+        return BlockType::Lz77;
+    }
+    if(transform == BlockTransform::Words && encode_words_payload(data, size, output)) {
+        return BlockType::Words;
+    }
+
+    const bool sampled = (level == CompressionLevel::Fast);
+    CharFrequencies frequencies{0};
+    {
+        StageTimer timer{Stage::Histogram};
+        if(sampled) {
+            sample_frequencies(data, size, frequencies);
+        }
+        else {
+            count_bytes(data, size, frequencies.data());
+        }
+    }
+
+    HTree tree;
+    tree.setFrequencies(frequencies);
+    if(!sampled) {
+        if(huffman_payload_size(tree) >= size) {
+            return BlockType::Stored;
+        }
+
+        StageTimer timer{Stage::Encode};
+        output.clear();
+        write_huffman_payload(tree, data, size, output);
+        return BlockType::Huffman;
+    }
+
+    StageTimer timer{Stage::Encode};
+    output.clear();
+    write_table(tree, output);
+
+    // codes from the sample may not shrink the block, it is seen only while encoding it piece by piece
+    const auto dataPos = output.size();
+    const EncodeTable table{tree.huffmanDict(), size};
+    const auto maxPieceSize = (SAMPLED_ENCODE_STEP * tree.maxCodeLength() + BITS_IN_BYTE - 1) / BITS_IN_BYTE;
+    output.resize(std::max(dataPos, size) + maxPieceSize + sizeof(std::uint64_t));
+
+    const auto limit = output.data() + size;
+    BitWriter writer(output.data() + dataPos);
+    for(std::size_t first = 0; first < size; first += SAMPLED_ENCODE_STEP) {
+        if(writer.position() >= limit) {
+            return BlockType::Stored;
+        }
+        table.encode(data + first, data + std::min(size, first + SAMPLED_ENCODE_STEP), writer);
+    }
+    output.resize(static_cast<std::size_t>(writer.finish() - output.data()));
+
+    return (output.size() >= size) ? BlockType::Stored : BlockType::Huffman;
+}
+
+std::vector<std::size_t> split_block(const BytesBuffer& input)
+{
+    StageTimer timer{Stage::Histogram};
+
+    const auto segmentSize = split_segment_size(input.size());
+    const auto segmentsCount = (input.size() + segmentSize - 1) / segmentSize;
+    if(segmentsCount < 2) {
+        return {input.size()};
+    }
+
+    // prefix sums of the segment histograms: any run of segments is a difference of two
+    std::vector<CharFrequencies> prefixes(segmentsCount + 1, CharFrequencies{0});
+    for(std::size_t segment = 0; segment < segmentsCount; ++segment) {
+        const auto first = segment * segmentSize;
+        const auto size = std::min(segmentSize, input.size() - first);
+        prefixes[segment + 1] = prefixes[segment];
+        count_bytes(input.data() + first, size, prefixes[segment + 1].data());
+    }
+
+    // costs[end] - the least size of segments [0, end) split to blocks, starts[end] - where the last block starts
+    std::vector<double> costs(segmentsCount + 1, 0.0);
+    std::vector<std::size_t> starts(segmentsCount + 1, 0);
+    for(std::size_t end = 1; end <= segmentsCount; ++end) {
+        costs[end] = std::numeric_limits<double>::max();
+        for(std::size_t start = 0; start < end; ++start) {
+            const auto cost = costs[start] + estimate_block_size(prefixes[start], prefixes[end]);
+            if(cost < costs[end]) {
+                costs[end] = cost;
+                starts[end] = start;
+            }
+        }
+    }
+
+    std::vector<std::size_t> sizes;
+    for(auto end = segmentsCount; end > 0; end = starts[end]) {
+        const auto first = starts[end] * segmentSize;
+        const auto last = std::min(end * segmentSize, input.size());
+        sizes.push_back(last - first);
+    }
+    std::reverse(sizes.begin(), sizes.end());
+    return sizes;
+}
+
+std::uint64_t split_block_scratch_size(std::size_t size)
+{
+    // the prefix histograms, costs and starts of the segments
+    const auto segmentSize = split_segment_size(size);
+    const auto segmentsCount = std::uint64_t{(size + segmentSize - 1) / segmentSize};
+    return (segmentsCount + 1) * (sizeof(CharFrequencies) + sizeof(double) + sizeof(std::size_t));
+}
+
+std::uint32_t block_checksum(const std::uint8_t* data, std::size_t size)
+{
+    StageTimer timer{Stage::Checksum};
+    return crc32c(data, size);
+}
+
+void decode_block(const BlockHeader& header, const BytesBuffer& input, BytesBuffer& output)
+{
+    decode_block_data(header, input, output);
+    if(block_checksum(output) != header.checksum) {
+        throw std::runtime_error{"Block checksum mismatch"};
+    }
+}
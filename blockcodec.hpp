@@ -0,0 +1,131 @@
+#ifndef BLOCKCODEC_HPP
+#define BLOCKCODEC_HPP
+
+#include "bufferalloc.hpp"
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+
+static_assert (sizeof(char) == sizeof(std::uint8_t), "");
+
+
+enum class CompressionLevel {
+    Fast,    // frequencies from a sample of the block, all symbols get codes
+    Default, // exact frequencies
+    Max      // chunks are split to blocks with the least estimated encoded size (see split_block) unless transformed
+};
+
+enum class BlockTransform {
+    None,
+    Bwt,     // BWT + MTF + zero runs before Huffman coding (see bwt.hpp), if it makes the block smaller
+    Lz77,    // dictionary matches before Huffman coding (see lz77.hpp), the level sets the effort of the search
+    Words    // Huffman coding of 16-bit symbols (see wordcodec.hpp), if it makes the block smaller than of bytes
+};
+
+enum class BlockType : std::uint8_t {
+    Stored = 0,
+    Huffman = 1,
+    Bwt = 2,
+    Lz77 = 3,
+    Reference = 4, // the same data as a block written before (see dedup.hpp)
+    Words = 5
+};
+
+// Blocks file
+// BlocksHeader
+// { BlockHeader, payload } ... до конца файла или до пустого блока (конец потока неизвестного размера, StreamEncoder)
+
+constexpr std::uint16_t BLOCKS_FORMAT_VERSION = 3;
+constexpr std::uint64_t UNKNOWN_SIZE = ~std::uint64_t{0};
+
+struct BlocksHeader {
+    std::uint8_t header[4]{'\0'};          // заголовок "HAFB"
+    std::uint16_t version = BLOCKS_FORMAT_VERSION;
+    std::uint16_t reserved = 0;
+    std::uint32_t blockSize = 0;           // максимальный размер несжатого блока
+    std::uint32_t flags = 0;               // BLOCKS_FLAG_*
+    std::uint64_t originalSize = UNKNOWN_SIZE; // размер несжатых данных
+    std::uint64_t payloadSize = UNKNOWN_SIZE;  // размер всех блоков с их заголовками
+};
+static_assert (sizeof(BlocksHeader) == 32, "");
+
+// the types of blocks in the file besides Stored and Huffman, so the reader knows the memory it needs
+constexpr std::uint32_t BLOCKS_FLAG_BWT = 1;
+constexpr std::uint32_t BLOCKS_FLAG_LZ77 = 2;
+constexpr std::uint32_t BLOCKS_FLAG_REFERENCES = 4;
+constexpr std::uint32_t BLOCKS_FLAG_WORDS = 8;
+
+struct BlockHeader {
+    std::uint32_t rawSize = 0;    // размер несжатого блока
+    std::uint32_t packedSize = 0; // размер payload
+    BlockType type = BlockType::Stored;
+    std::uint8_t reserved[3]{0};
+    std::uint32_t checksum = 0;   // CRC-32C несжатого блока
+};
+static_assert (sizeof(BlockHeader) == 16, "");
+
+inline bool is_end_mark(const BlockHeader& header) { return header.rawSize == 0; }
+
+// Huffman payload
+// std::uint16_t count;  // кол-во записей SymbolEntry
+// SymbolEntry[count]
+// BitsBuffer            // биты кодов символов (выровнены до байта)
+// BitsBuffer            // биты данных, ровно rawSize символов (выровнены до байта)
+
+// Bwt payload
+// std::uint32_t primaryIndex;    // строка BWT с маркером конца данных
+// std::uint32_t transformedSize; // размер данных после BWT + MTF + RLE
+// Huffman payload               // ровно transformedSize символов
+
+// Lz77 payload
+// std::uint32_t matchesCount;    // кол-во совпадений
+// std::uint32_t literalsCount;   // кол-во литералов
+// std::uint32_t streamSizes[4];  // размеры Huffman payload литералов, кодов длин литералов, длин и расстояний
+// Huffman payload[4]            // потоки подряд (поток без символов пустой)
+// BitsBuffer                    // дополнительные биты кодов (до конца блока)
+
+// Words payload
+// std::uint32_t lengthsCount;    // кол-во длин кодов (наибольший символ + 1)
+// std::uint32_t lengthsRleSize;  // размер длин после zero RLE (см. bwt.hpp)
+// std::uint32_t lengthsSize;     // размер Huffman payload длин
+// std::uint8_t tail[rawSize % 2]; // последний байт блока нечётного размера
+// Huffman payload               // длины кодов, ровно lengthsRleSize символов
+// BitsBuffer                    // канонические коды слов (см. wordcodec.hpp), ровно rawSize / 2 символов
+
+// Reference payload
+// std::uint8_t digest[32];       // SHA-256 исходных данных
+// std::uint64_t offset;          // смещение заголовка блока в архиве
+// std::uint16_t nameSize;
+// char name[nameSize];           // имя архива с блоком (в каталоге этого архива)
+
+// Stored payload
+// std::uint8_t[rawSize] // исходные байты
+
+class HTree;
+
+std::uint64_t huffman_payload_size(const HTree& tree);
+
+// encodes input to output (Huffman, Bwt, Lz77 or Words payload), returns BlockType::Stored if the block wouldn't shrink -
+// then the input itself is the payload (output is undefined)
+BlockType encode_block(const std::uint8_t* data, std::size_t size, BytesBuffer& output,
+                       CompressionLevel level = CompressionLevel::Default, BlockTransform transform = BlockTransform::None);
+inline BlockType encode_block(const BytesBuffer& input, BytesBuffer& output,
+                              CompressionLevel level = CompressionLevel::Default, BlockTransform transform = BlockTransform::None)
+{
+    return encode_block(input.data(), input.size(), output, level, transform);
+}
+
+// sizes of the parts input is better split to (by the estimated encoded size), one part if it is not worth it;
+// the parts are made of 16 KiB segments, of larger ones in blocks of more than 4 MiB
+std::vector<std::size_t> split_block(const BytesBuffer& input);
+// bytes split_block needs for the input of the size
+std::uint64_t split_block_scratch_size(std::size_t size);
+
+std::uint32_t block_checksum(const std::uint8_t* data, std::size_t size);
+inline std::uint32_t block_checksum(const BytesBuffer& data) { return block_checksum(data.data(), data.size()); }
+// checks the checksum of the decoded block too
+void decode_block(const BlockHeader& header, const BytesBuffer& input, BytesBuffer& output);
+
+#endif // BLOCKCODEC_HPP
@@ -0,0 +1,132 @@
+#pragma once
+#ifndef BOUNDED_QUEUE_HPP
+#define BOUNDED_QUEUE_HPP
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <chrono>
+#include <cstddef>
+#include <cassert>
+
+
+// Lock-free bounded multi-producer multi-consumer queue (D. Vyukov's algorithm).
+// Capacity is rounded up to the power of two.
+template<typename T>
+class bounded_queue {
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+
+    explicit bounded_queue(size_type capacity)
+    {
+        size_type real_capacity = 2;
+        while (real_capacity < capacity) {
+            real_capacity *= 2;
+        }
+
+        cells_ = std::make_unique<cell[]>(real_capacity);
+        mask_ = real_capacity - 1;
+        for (size_type i = 0; i < real_capacity; ++i) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bounded_queue(const bounded_queue&) = delete;
+    bounded_queue& operator=(const bounded_queue&) = delete;
+
+    size_type capacity() const noexcept { return mask_ + 1; }
+
+    bool try_push(T value)
+    {
+        size_type pos = enqueue_pos_.load(std::memory_order_relaxed);
+        cell* current = nullptr;
+        for (;;) {
+            current = &cells_[pos & mask_];
+            const size_type seq = current->sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            }
+            else if (diff < 0) {
+                return false; // full
+            }
+            else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+
+        current->value = std::move(value);
+        current->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool try_pop(T& value)
+    {
+        size_type pos = dequeue_pos_.load(std::memory_order_relaxed);
+        cell* current = nullptr;
+        for (;;) {
+            current = &cells_[pos & mask_];
+            const size_type seq = current->sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1);
+            if (diff == 0) {
+                if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            }
+            else if (diff < 0) {
+                return false; // empty
+            }
+            else {
+                pos = dequeue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+
+        value = std::move(current->value);
+        current->sequence.store(pos + mask_ + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    struct cell {
+        std::atomic<size_type> sequence{0};
+        T value{};
+    };
+
+    static constexpr size_type CACHE_LINE_SIZE = 64;
+
+private:
+    std::unique_ptr<cell[]> cells_;
+    size_type mask_ = 0;
+    alignas(CACHE_LINE_SIZE) std::atomic<size_type> enqueue_pos_{0};
+    alignas(CACHE_LINE_SIZE) std::atomic<size_type> dequeue_pos_{0};
+};
+
+
+// Spins a bit then yields and sleeps, used while waiting on the queues.
+class backoff {
+public:
+    void operator()()
+    {
+        if (count_ < SPIN_LIMIT) {
+            ++count_;
+        }
+        else if (count_ < YIELD_LIMIT) {
+            ++count_;
+            std::this_thread::yield();
+        }
+        else {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+    void reset() noexcept { count_ = 0; }
+
+private:
+    static constexpr int SPIN_LIMIT = 64;
+    static constexpr int YIELD_LIMIT = 256;
+    int count_ = 0;
+};
+
+#endif // !BOUNDED_QUEUE_HPP
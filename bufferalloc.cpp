@@ -0,0 +1,25 @@
+#include "bufferalloc.hpp"
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+
+void* allocate_cache_aligned(std::size_t size) { return ::operator new(size, std::align_val_t{CACHE_LINE_SIZE}); }
+
+void free_cache_aligned(void* pointer) { ::operator delete(pointer, std::align_val_t{CACHE_LINE_SIZE}); }
+
+void advise_huge_pages(void* pointer, std::size_t size)
+{
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    const auto first = (reinterpret_cast<std::uintptr_t>(pointer) + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    const auto last = (reinterpret_cast<std::uintptr_t>(pointer) + size) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    if(first < last) {
+        // without transparent huge pages the memory stays of small pages
+        madvise(reinterpret_cast<void*>(first), last - first, MADV_HUGEPAGE);
+    }
+#else
+    (void)pointer;
+    (void)size;
+#endif
+}
@@ -0,0 +1,49 @@
+#ifndef BUFFERALLOC_HPP
+#define BUFFERALLOC_HPP
+
+#include "allocstats.hpp"
+
+#include <new>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+
+// Memory of the hot data: the tables get whole cache lines, so an entry never straddles two
+// and SIMD loads are aligned. The block buffers of the pipeline live as long as it runs and are
+// reserved once, they are advised for transparent huge pages (see advise_huge_pages).
+
+constexpr std::size_t CACHE_LINE_SIZE = 64;
+constexpr std::size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+void* allocate_cache_aligned(std::size_t size);
+void free_cache_aligned(void* pointer);
+
+// asks the kernel to back the whole huge pages inside [pointer, pointer + size) with huge pages,
+// so a worker sweeping a block takes a TLB miss per 2 MiB instead of per 4 KiB; only a hint, no-op besides Linux
+void advise_huge_pages(void* pointer, std::size_t size);
+
+template<class T>
+class CacheAlignedAllocator {
+public:
+    using value_type = T;
+
+    CacheAlignedAllocator() noexcept = default;
+    template<class U>
+    CacheAlignedAllocator(const CacheAlignedAllocator<U>&) noexcept {}
+
+    T* allocate(std::size_t count) { return static_cast<T*>(allocate_cache_aligned(count * sizeof(T))); }
+    void deallocate(T* pointer, std::size_t) noexcept { free_cache_aligned(pointer); }
+
+    template<class U>
+    bool operator==(const CacheAlignedAllocator<U>&) const noexcept { return true; }
+    template<class U>
+    bool operator!=(const CacheAlignedAllocator<U>&) const noexcept { return false; }
+};
+
+template<class T>
+using TableBuffer = std::vector<T, tracked_allocator<T, AllocSubsystem::Tables, CacheAlignedAllocator<T>>>;
+
+using BytesBuffer = std::vector<std::uint8_t, tracked_allocator<std::uint8_t, AllocSubsystem::Buffers>>;
+
+#endif // BUFFERALLOC_HPP
@@ -0,0 +1,323 @@
+#include "bwt.hpp"
+
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <cstring>
+#include <cassert>
+
+
+namespace {
+
+// SA-IS suffix array construction (Nong, Zhang, Chan), linear time.
+// text has size symbols of [0, alphabetSize), the last one is the unique smallest.
+
+using Buckets = std::vector<std::int32_t>;
+
+void get_buckets(const std::int32_t* text, std::int32_t size, std::int32_t alphabetSize, Buckets& buckets, bool ends)
+{
+    buckets.assign(static_cast<std::size_t>(alphabetSize), 0);
+    for(std::int32_t index = 0; index < size; ++index) {
+        ++buckets[text[index]];
+    }
+
+    std::int32_t sum = 0;
+    for(auto& bucket : buckets) {
+        sum += bucket;
+        bucket = ends ? sum : sum - bucket;
+    }
+}
+
+void induce_l_types(const std::int32_t* text, std::int32_t* suffixes, std::int32_t size, std::int32_t alphabetSize,
+                    const std::vector<bool>& sTypes, Buckets& buckets)
+{
+    get_buckets(text, size, alphabetSize, buckets, false);
+    for(std::int32_t index = 0; index < size; ++index) {
+        const auto prev = suffixes[index] - 1;
+        if(prev >= 0 && !sTypes[prev]) {
+            suffixes[buckets[text[prev]]++] = prev;
+        }
+    }
+}
+
+void induce_s_types(const std::int32_t* text, std::int32_t* suffixes, std::int32_t size, std::int32_t alphabetSize,
+                    const std::vector<bool>& sTypes, Buckets& buckets)
+{
+    get_buckets(text, size, alphabetSize, buckets, true);
+    for(std::int32_t index = size - 1; index >= 0; --index) {
+        const auto prev = suffixes[index] - 1;
+        if(prev >= 0 && sTypes[prev]) {
+            suffixes[--buckets[text[prev]]] = prev;
+        }
+    }
+}
+
+void build_suffix_array(const std::int32_t* text, std::int32_t* suffixes, std::int32_t size, std::int32_t alphabetSize)
+{
+    assert(size > 0);
+    if(size == 1) {
+        suffixes[0] = 0;
+        return;
+    }
+
+    std::vector<bool> sTypes(static_cast<std::size_t>(size));
+    sTypes[size - 1] = true;
+    for(std::int32_t index = size - 2; index >= 0; --index) {
+        sTypes[index] = text[index] < text[index + 1] || (text[index] == text[index + 1] && sTypes[index + 1]);
+    }
+    const auto isLms = [&sTypes](std::int32_t index) { return index > 0 && sTypes[index] && !sTypes[index - 1]; };
+
+    // sorting LMS substrings: induced from their unsorted positions at the bucket ends
+    Buckets buckets;
+    get_buckets(text, size, alphabetSize, buckets, true);
+    std::fill(suffixes, suffixes + size, -1);
+    for(std::int32_t index = 1; index < size; ++index) {
+        if(isLms(index)) {
+            suffixes[--buckets[text[index]]] = index;
+        }
+    }
+    induce_l_types(text, suffixes, size, alphabetSize, sTypes, buckets);
+    induce_s_types(text, suffixes, size, alphabetSize, sTypes, buckets);
+
+    std::int32_t lmsCount = 0;
+    for(std::int32_t index = 0; index < size; ++index) {
+        if(isLms(suffixes[index])) {
+            suffixes[lmsCount++] = suffixes[index];
+        }
+    }
+
+    // naming: equal LMS substrings get the same name, names are stored by position / 2 (LMS are never adjacent)
+    std::fill(suffixes + lmsCount, suffixes + size, -1);
+    std::int32_t namesCount = 0;
+    std::int32_t prevPos = -1;
+    for(std::int32_t index = 0; index < lmsCount; ++index) {
+        const auto pos = suffixes[index];
+        bool differs = false;
+        for(std::int32_t offset = 0; offset < size; ++offset) {
+            if(prevPos == -1 || text[pos + offset] != text[prevPos + offset] || sTypes[pos + offset] != sTypes[prevPos + offset]) {
+                differs = true;
+                break;
+            }
+            if(offset > 0 && (isLms(pos + offset) || isLms(prevPos + offset))) {
+                break;
+            }
+        }
+        if(differs) {
+            ++namesCount;
+            prevPos = pos;
+        }
+        suffixes[lmsCount + pos / 2] = namesCount - 1;
+    }
+    for(std::int32_t index = size - 1, last = size - 1; index >= lmsCount; --index) {
+        if(suffixes[index] >= 0) {
+            suffixes[last--] = suffixes[index];
+        }
+    }
+
+    // order of LMS suffixes: by recursion if names repeat
+    auto* reduced = suffixes + size - lmsCount;
+    if(namesCount < lmsCount) {
+        build_suffix_array(reduced, suffixes, lmsCount, namesCount);
+    }
+    else {
+        for(std::int32_t index = 0; index < lmsCount; ++index) {
+            suffixes[reduced[index]] = index;
+        }
+    }
+
+    // sorted LMS suffixes at the bucket ends induce all the others
+    for(std::int32_t index = 1, lmsIndex = 0; index < size; ++index) {
+        if(isLms(index)) {
+            reduced[lmsIndex++] = index;
+        }
+    }
+    for(std::int32_t index = 0; index < lmsCount; ++index) {
+        suffixes[index] = reduced[suffixes[index]];
+    }
+    std::fill(suffixes + lmsCount, suffixes + size, -1);
+
+    get_buckets(text, size, alphabetSize, buckets, true);
+    for(std::int32_t index = lmsCount - 1; index >= 0; --index) {
+        const auto pos = suffixes[index];
+        suffixes[index] = -1;
+        suffixes[--buckets[text[pos]]] = pos;
+    }
+    induce_l_types(text, suffixes, size, alphabetSize, sTypes, buckets);
+    induce_s_types(text, suffixes, size, alphabetSize, sTypes, buckets);
+}
+
+constexpr std::uint8_t RUN_A = 0;
+constexpr std::uint8_t RUN_B = 1;
+constexpr std::uint8_t ESCAPE = 255;
+constexpr std::uint8_t FIRST_ESCAPED = ESCAPE - 1;
+
+void throw_corrupted() { throw std::runtime_error{"Corrupted transformed block"}; }
+
+}
+
+std::uint32_t bwt_forward(const std::uint8_t* data, std::size_t size, std::uint8_t* output)
+{
+    if(size > BWT_MAX_SIZE) {
+        throw std::invalid_argument{"Block of " + std::to_string(size) + " bytes is too large for BWT"};
+    }
+
+    // bytes are shifted by one to make room for the end marker 0
+    const auto textSize = static_cast<std::int32_t>(size + 1);
+    std::vector<std::int32_t> text(static_cast<std::size_t>(textSize));
+    for(std::size_t index = 0; index < size; ++index) {
+        text[index] = std::int32_t{data[index]} + 1;
+    }
+    text[size] = 0;
+
+    std::vector<std::int32_t> suffixes(text.size());
+    build_suffix_array(text.data(), suffixes.data(), textSize, 256 + 1);
+
+    // the last column without the marker
+    std::uint32_t primaryIndex = 0;
+    for(std::int32_t row = 0; row < textSize; ++row) {
+        if(suffixes[row] == 0) {
+            primaryIndex = static_cast<std::uint32_t>(row);
+            continue;
+        }
+        *output++ = data[suffixes[row] - 1];
+    }
+    return primaryIndex;
+}
+
+void bwt_inverse(const std::uint8_t* data, std::size_t size, std::uint32_t primaryIndex, std::uint8_t* output)
+{
+    if(primaryIndex > size) {
+        throw_corrupted();
+    }
+
+    // first rows of each byte: the marker row 0 goes before them
+    std::size_t firstRows[256]{0};
+    for(std::size_t index = 0; index < size; ++index) {
+        ++firstRows[data[index]];
+    }
+    std::size_t sum = 1;
+    for(auto& firstRow : firstRows) {
+        const auto count = firstRow;
+        firstRow = sum;
+        sum += count;
+    }
+
+    // LF mapping: row of the rotation starting with the last byte of this one
+    const auto rowOf = [primaryIndex](std::size_t index) { return index < primaryIndex ? index : index + 1; };
+    std::vector<std::uint32_t> next(size + 1, 0);
+    for(std::size_t index = 0; index < size; ++index) {
+        next[rowOf(index)] = static_cast<std::uint32_t>(firstRows[data[index]]++);
+    }
+
+    // from the marker row (the whole data follows the marker) backwards
+    std::size_t row = 0;
+    for(std::size_t pos = size; pos > 0; --pos) {
+        if(row == primaryIndex) {
+            throw_corrupted();
+        }
+        output[pos - 1] = data[row < primaryIndex ? row : row - 1];
+        row = next[row];
+    }
+}
+
+void mtf_encode(std::uint8_t* data, std::size_t size)
+{
+    std::uint8_t order[256];
+    std::iota(std::begin(order), std::end(order), 0);
+
+    for(std::size_t index = 0; index < size; ++index) {
+        const auto byte = data[index];
+        std::uint8_t pos = 0;
+        while(order[pos] != byte) {
+            ++pos;
+        }
+        std::memmove(order + 1, order, pos);
+        order[0] = byte;
+        data[index] = pos;
+    }
+}
+
+void mtf_decode(std::uint8_t* data, std::size_t size)
+{
+    std::uint8_t order[256];
+    std::iota(std::begin(order), std::end(order), 0);
+
+    for(std::size_t index = 0; index < size; ++index) {
+        const auto pos = data[index];
+        const auto byte = order[pos];
+        std::memmove(order + 1, order, pos);
+        order[0] = byte;
+        data[index] = byte;
+    }
+}
+
+void zero_rle_encode(const std::uint8_t* data, std::size_t size, BytesBuffer& output)
+{
+    output.clear();
+    output.reserve(size);
+
+    for(std::size_t index = 0; index < size;) {
+        if(data[index] == 0) {
+            std::size_t runLength = 0;
+            for(; index < size && data[index] == 0; ++index) {
+                ++runLength;
+            }
+
+            // runLength = sum of (1 for RUN_A or 2 for RUN_B) * 2^digit
+            for(auto rest = runLength - 1;; rest = (rest - 2) / 2) {
+                output.push_back((rest & 1) ? RUN_B : RUN_A);
+                if(rest < 2) {
+                    break;
+                }
+            }
+            continue;
+        }
+
+        const auto value = data[index++];
+        if(value >= FIRST_ESCAPED) {
+            output.push_back(ESCAPE);
+            output.push_back(static_cast<std::uint8_t>(value - FIRST_ESCAPED));
+        }
+        else {
+            output.push_back(static_cast<std::uint8_t>(value + 1));
+        }
+    }
+}
+
+void zero_rle_decode(const std::uint8_t* data, std::size_t size, std::uint8_t* output, std::size_t outputSize)
+{
+    std::size_t outputPos = 0;
+    for(std::size_t index = 0; index < size;) {
+        if(data[index] <= RUN_B) {
+            std::size_t runLength = 0;
+            for(std::size_t weight = 1; index < size && data[index] <= RUN_B; ++index, weight *= 2) {
+                runLength += (data[index] == RUN_A) ? weight : 2 * weight;
+                if(runLength > outputSize - outputPos) {
+                    throw_corrupted();
+                }
+            }
+            std::memset(output + outputPos, 0, runLength);
+            outputPos += runLength;
+            continue;
+        }
+
+        if(outputPos == outputSize) {
+            throw_corrupted();
+        }
+        if(data[index] == ESCAPE) {
+            if(index + 1 == size || data[index + 1] > ESCAPE - FIRST_ESCAPED) {
+                throw_corrupted();
+            }
+            output[outputPos++] = static_cast<std::uint8_t>(FIRST_ESCAPED + data[index + 1]);
+            index += 2;
+        }
+        else {
+            output[outputPos++] = static_cast<std::uint8_t>(data[index] - 1);
+            ++index;
+        }
+    }
+
+    if(outputPos != outputSize) {
+        throw_corrupted();
+    }
+}
@@ -0,0 +1,38 @@
+#ifndef BWT_HPP
+#define BWT_HPP
+
+#include "bufferalloc.hpp"
+
+#include <vector>
+#include <limits>
+#include <cstdint>
+#include <cstddef>
+
+
+// Block sorting transform in front of the Huffman coder (as in bzip2):
+// Burrows-Wheeler transform groups bytes with the same context, move-to-front turns them into
+// runs of small numbers, zero runs are coded by their length in bijective base 2.
+
+// the suffix sort indexes the data and the end marker by 32-bit signed integers
+constexpr std::size_t BWT_MAX_SIZE = std::numeric_limits<std::int32_t>::max() - 1;
+
+// Burrows-Wheeler transform of data with the virtual end of data marker (less than any byte),
+// output gets size bytes (without the marker), returns the row of the marker - primary index;
+// throws if size is more than BWT_MAX_SIZE
+std::uint32_t bwt_forward(const std::uint8_t* data, std::size_t size, std::uint8_t* output);
+void bwt_inverse(const std::uint8_t* data, std::size_t size, std::uint32_t primaryIndex, std::uint8_t* output);
+
+// in place
+void mtf_encode(std::uint8_t* data, std::size_t size);
+void mtf_decode(std::uint8_t* data, std::size_t size);
+
+// zero runs are written as digits 0 (RUNA) and 1 (RUNB), other values are shifted by one,
+// the values 254 and 255 which don't fit are escaped by 255
+void zero_rle_encode(const std::uint8_t* data, std::size_t size, BytesBuffer& output);
+// throws if the data doesn't decode to exactly size bytes
+void zero_rle_decode(const std::uint8_t* data, std::size_t size, std::uint8_t* output, std::size_t outputSize);
+
+// the upper bound of zero_rle_encode output
+constexpr std::size_t zero_rle_max_size(std::size_t size) { return 2 * size; }
+
+#endif // BWT_HPP
@@ -0,0 +1,200 @@
+#include "cli.hpp"
+#include "huffmanencoding.hpp"
+#include "search.hpp"
+#include "verify.hpp"
+#include "analysis.hpp"
+#include "benchmark.hpp"
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <stdexcept>
+
+
+namespace {
+
+using Arguments = std::vector<std::string>;
+
+void print_usage(std::ostream& outputStream)
+{
+    outputStream << "Usage:\n"
+                 << "  HuffmanCompressionQt compress [--block-size <bytes>] [--level fast|default|max] [--bwt | --lz77 | --words] [--auto speed|ratio[:<MB/s>]] [--dedup <index>] [--threads <count>] [--memory <bytes>] [--stats] [--trace <json>] [io options] <from> <to>\n"
+                 << "  HuffmanCompressionQt decompress [--threads <count>] [--memory <bytes>] [--stats] [--trace <json>] [io options] <from> <to>\n"
+                 << "  HuffmanCompressionQt search [--threads <count>] [--memory <bytes>] [--stats] <file> <pattern>\n"
+                 << "  HuffmanCompressionQt test [--threads <count>] [--memory <bytes>] [--stats] <file>...\n"
+                 << "  HuffmanCompressionQt analyze [--block-size <bytes>] <file>\n"
+                 << "  HuffmanCompressionQt bench [--block-size <bytes>]\n"
+                 << "  --auto chooses block size, level and transform (overriding them) by a sample of the file:\n"
+                 << "  speed - the fastest, ratio - the best compression, ratio:<MB/s> - the best at least that fast\n"
+                 << "io options:\n"
+                 << "  --io-uring               asynchronous io_uring I/O (Linux)\n"
+                 << "  --io-depth <count>       requests in flight\n"
+                 << "  --io-buffer <bytes>      size of one request\n"
+                 << "  --direct                 O_DIRECT\n"
+                 << "  --registered-buffers     register buffers in io_uring\n";
+}
+
+CompressionLevel parse_level(const std::string& value)
+{
+    if(value == "fast") {
+        return CompressionLevel::Fast;
+    }
+    if(value == "default") {
+        return CompressionLevel::Default;
+    }
+    if(value == "max") {
+        return CompressionLevel::Max;
+    }
+    throw std::invalid_argument{"Unknown compression level: " + value};
+}
+
+// speed | ratio | ratio:<MB/s>
+void parse_tune_goal(const std::string& value, CodecOptions& options)
+{
+    if(value == "speed") {
+        options.tuneGoal = TuneGoal::Speed;
+        return;
+    }
+
+    const std::string ratio = "ratio";
+    if(value.compare(0, ratio.size(), ratio) == 0 && (value.size() == ratio.size() || value[ratio.size()] == ':')) {
+        options.tuneGoal = TuneGoal::Ratio;
+        options.tuneMinSpeed = (value.size() > ratio.size()) ? std::stod(value.substr(ratio.size() + 1)) : 0.0;
+        return;
+    }
+    throw std::invalid_argument{"Unknown auto tune goal: " + value};
+}
+
+std::size_t parse_size(const std::string& value)
+{
+    const auto result = std::stoull(value);
+    if(result == 0) {
+        throw std::invalid_argument{"Size must be greater than zero: " + value};
+    }
+    return static_cast<std::size_t>(result);
+}
+
+int run_command(const std::string& command, const Arguments& args)
+{
+    Arguments files;
+    CodecOptions options;
+    bool printStats = false;
+    for(std::size_t argIndex = 0; argIndex < args.size(); ++argIndex) {
+        const auto& arg = args[argIndex];
+        if(arg == "--block-size" && argIndex + 1 < args.size()) {
+            options.blockSize = parse_size(args[++argIndex]);
+        }
+        else if(arg == "--level" && argIndex + 1 < args.size()) {
+            options.level = parse_level(args[++argIndex]);
+        }
+        else if(arg == "--bwt") {
+            options.transform = BlockTransform::Bwt;
+        }
+        else if(arg == "--lz77") {
+            options.transform = BlockTransform::Lz77;
+        }
+        else if(arg == "--words") {
+            options.transform = BlockTransform::Words;
+        }
+        else if(arg == "--auto" && argIndex + 1 < args.size()) {
+            parse_tune_goal(args[++argIndex], options);
+        }
+        else if(arg == "--dedup" && argIndex + 1 < args.size()) {
+            options.dedupIndex = args[++argIndex];
+        }
+        else if(arg == "--memory" && argIndex + 1 < args.size()) {
+            options.memoryBudget = parse_size(args[++argIndex]);
+        }
+        else if(arg == "--threads" && argIndex + 1 < args.size()) {
+            options.threadsCount = static_cast<unsigned>(parse_size(args[++argIndex]));
+        }
+        else if(arg == "--stats") {
+            printStats = true;
+        }
+        else if(arg == "--trace" && argIndex + 1 < args.size()) {
+            options.tracePath = args[++argIndex];
+        }
+        else if(arg == "--io-uring") {
+            options.ioBackend = IoBackend::IoUring;
+        }
+        else if(arg == "--io-depth" && argIndex + 1 < args.size()) {
+            options.ioUring.queueDepth = static_cast<unsigned>(parse_size(args[++argIndex]));
+        }
+        else if(arg == "--io-buffer" && argIndex + 1 < args.size()) {
+            options.ioUring.bufferSize = parse_size(args[++argIndex]);
+        }
+        else if(arg == "--direct") {
+            options.ioUring.directIo = true;
+        }
+        else if(arg == "--registered-buffers") {
+            options.ioUring.registeredBuffers = true;
+        }
+        else {
+            files.push_back(arg);
+        }
+    }
+
+    if((command == "compress" || command == "decompress") && files.size() == 2) {
+        const auto stats = (command == "compress")
+            ? compress_file(files[0], files[1], options)
+            : decompress_file(files[0], files[1], options);
+        if(printStats) {
+            std::cout << format_stats(stats);
+        }
+        return 0;
+    }
+    if(command == "search" && files.size() == 2) {
+        // uncompressed offsets of the matches, one per line
+        std::vector<std::uint64_t> offsets;
+        const auto stats = search_file(files[0], files[1], offsets, options);
+        for(const auto offset : offsets) {
+            std::cout << offset << '\n';
+        }
+        if(printStats) {
+            std::cerr << format_stats(stats);
+        }
+        return 0;
+    }
+    if(command == "test" && !files.empty()) {
+        // decodes without writing, a line per file
+        const auto report = verify_files(files, options);
+        std::cout << format_verify_report(report);
+        if(printStats) {
+            for(const auto& file : report.files) {
+                if(file.passed) {
+                    std::cerr << file.path << ":\n" << format_stats(file.stats);
+                }
+            }
+        }
+        return report.passed() ? 0 : 1;
+    }
+    if(command == "analyze" && files.size() == 1) {
+        print_analysis(analyze_file(files[0], options.blockSize), std::cout);
+        return 0;
+    }
+    if(command == "bench" && files.empty()) {
+        print_kernels_benchmark(benchmark_kernels(options.blockSize), std::cout);
+        return 0;
+    }
+
+    print_usage(std::cerr);
+    return 2;
+}
+
+}
+
+int run_cli(int argc, char* argv[])
+{
+    if(argc < 2) {
+        print_usage(std::cerr);
+        return 2;
+    }
+
+    try {
+        return run_command(argv[1], Arguments(argv + 2, argv + argc));
+    }
+    catch(const std::exception& exc) {
+        std::cerr << "Error: " << exc.what() << '\n';
+        return 1;
+    }
+}
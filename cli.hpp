@@ -0,0 +1,8 @@
+#ifndef CLI_HPP
+#define CLI_HPP
+
+// Command line mode: HuffmanCompressionQt <command> [options] <files...>
+// returns process exit code
+int run_cli(int argc, char* argv[]);
+
+#endif // CLI_HPP
@@ -0,0 +1,130 @@
+#include "decodetable.hpp"
+#include "bitreader.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+
+DecodeTable::DecodeTable(const HuffmanDict& dict) : DecodeTable(dict, chooseMode(dict)) {}
+
+DecodeTable::DecodeTable(const HuffmanDict& dict, Mode mode)
+    : tree_{dict}
+    , mode_{mode}
+    , entries_(std::size_t{1} << PEEK_BITS)
+{
+    build(dict);
+}
+
+DecodeTable::Mode DecodeTable::chooseMode(const HuffmanDict& dict)
+{
+    double expectedLength = 0.0;
+    for(const auto& bitCode : dict) {
+        if(!bitCode.empty()) {
+            expectedLength += bitCode.size() / static_cast<double>(std::uint64_t{1} << bitCode.size());
+        }
+    }
+
+    return (expectedLength > 0.0 && expectedLength * 2 <= PEEK_BITS) ? Mode::MultiSymbol : Mode::SingleSymbol;
+}
+
+void DecodeTable::build(const HuffmanDict& dict)
+{
+    // single symbol entries: every window starting with the code
+    for(std::size_t symbol = 0; symbol < dict.size(); ++symbol) {
+        const auto& bitCode = dict[symbol];
+        if(bitCode.empty() || bitCode.size() > PEEK_BITS) {
+            continue;
+        }
+
+        std::uint32_t code = 0;
+        for(const bool bit : bitCode) {
+            code = (code << 1) | static_cast<std::uint32_t>(bit);
+        }
+
+        const unsigned freeBits = PEEK_BITS - bitCode.size();
+        const std::uint32_t firstIndex = code << freeBits;
+        for(std::uint32_t suffix = 0; suffix < (std::uint32_t{1} << freeBits); ++suffix) {
+            auto& entry = entries_[firstIndex | suffix];
+            entry.symbols[0] = static_cast<std::uint8_t>(symbol);
+            entry.count = 1;
+            entry.bitsCount = bitCode.size();
+            entry.firstBitsCount = bitCode.size();
+        }
+    }
+
+    if(mode_ != Mode::MultiSymbol) {
+        return;
+    }
+
+    // appending the next codes which fit in the rest of the window
+    const auto single = entries_;
+    constexpr std::uint32_t mask = (std::uint32_t{1} << PEEK_BITS) - 1;
+    for(std::uint32_t window = 0; window <= mask; ++window) {
+        auto& entry = entries_[window];
+        while(entry.count > 0 && entry.count < MAX_SYMBOLS) {
+            const auto& next = single[(window << entry.bitsCount) & mask];
+            if(next.count == 0 || entry.bitsCount + next.bitsCount > PEEK_BITS) {
+                break;
+            }
+            entry.symbols[entry.count++] = next.symbols[0];
+            entry.bitsCount += next.bitsCount;
+        }
+    }
+}
+
+std::uint64_t DecodeTable::decode(const std::uint8_t* first, const std::uint8_t* last, std::size_t count, std::uint8_t* outFirst) const
+{
+    BitReader reader(first, last);
+
+    // whole entries while there is room for all of their symbols
+    while(count >= MAX_SYMBOLS) {
+        reader.refill();
+        const auto& entry = entries_[reader.peek(PEEK_BITS)];
+        if(entry.count == 0) {
+            *outFirst++ = tree_.decodeSymbol(reader);
+            --count;
+            continue;
+        }
+
+        std::memcpy(outFirst, entry.symbols, MAX_SYMBOLS);
+        outFirst += entry.count;
+        count -= entry.count;
+        reader.skip(entry.bitsCount);
+    }
+
+    // the tail symbol by symbol
+    for(; count > 0; --count) {
+        reader.refill();
+        *outFirst++ = decodeSymbol(reader);
+    }
+
+    return reader.consumedBits();
+}
+
+void DecodeTable::decodeBits(BitReader& reader, std::uint64_t bitsCount, BytesBuffer& output) const
+{
+    constexpr std::size_t GROW_SIZE = 64 * 1024;
+    auto outPos = output.size();
+    while(reader.consumedBits() < bitsCount) {
+        if(output.size() - outPos < MAX_SYMBOLS) {
+            output.resize(std::max(2 * output.size(), outPos + GROW_SIZE));
+        }
+
+        reader.refill();
+        const auto& entry = entries_[reader.peek(PEEK_BITS)];
+        if(entry.count == 0) {
+            output[outPos++] = tree_.decodeSymbol(reader);
+            continue;
+        }
+        // the next codes of the entry may start after the end
+        if(reader.consumedBits() + entry.bitsCount > bitsCount) {
+            output[outPos++] = entry.symbols[0];
+            reader.skip(entry.firstBitsCount);
+            continue;
+        }
+        std::memcpy(output.data() + outPos, entry.symbols, MAX_SYMBOLS);
+        outPos += entry.count;
+        reader.skip(entry.bitsCount);
+    }
+    output.resize(outPos);
+}
@@ -0,0 +1,71 @@
+#ifndef DECODETABLE_HPP
+#define DECODETABLE_HPP
+
+#include "decodetree.hpp"
+#include "bitreader.hpp"
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+
+// Table driven decoder: looks PEEK_BITS bits ahead and gets the symbol and its code length at once.
+// In MultiSymbol mode one entry holds up to MAX_SYMBOLS consecutive short codes fitting in the window,
+// so a single lookup emits several bytes. Codes longer than the window are decoded by DecodeTree.
+class DecodeTable {
+public:
+    static constexpr unsigned PEEK_BITS = 11;
+    static constexpr unsigned MAX_SYMBOLS = 4;
+    // for fewer symbols filling the table costs more than walking the tree
+    static constexpr std::size_t MIN_SYMBOLS = 4096;
+
+    enum class Mode {
+        SingleSymbol,
+        MultiSymbol
+    };
+
+public:
+    explicit DecodeTable(const HuffmanDict& dict);
+    explicit DecodeTable(const HuffmanDict& dict, Mode mode);
+
+    // MultiSymbol pays off when expected code length (by Kraft probabilities 2^-length)
+    // leaves room for at least two codes in the window
+    static Mode chooseMode(const HuffmanDict& dict);
+    Mode mode() const { return mode_; }
+
+    // decodes exactly count symbols, returns count of consumed bits
+    // (greater than (last - first) * 8 if the data is truncated)
+    std::uint64_t decode(const std::uint8_t* first, const std::uint8_t* last, std::size_t count, std::uint8_t* outFirst) const;
+    // decodes symbols while the reader has consumed fewer than bitsCount bits (the last code may cross it)
+    void decodeBits(BitReader& reader, std::uint64_t bitsCount, BytesBuffer& output) const;
+
+    // the reader must be refilled
+    std::uint8_t decodeSymbol(BitReader& reader) const
+    {
+        const auto& entry = entries_[reader.peek(PEEK_BITS)];
+        if(entry.count == 0) {
+            return tree_.decodeSymbol(reader);
+        }
+        reader.skip(entry.firstBitsCount);
+        return entry.symbols[0];
+    }
+
+private:
+    struct Entry {
+        std::uint8_t symbols[MAX_SYMBOLS]{0};
+        std::uint8_t count = 0;         // 0 - code is longer than the window
+        std::uint8_t bitsCount = 0;     // bits of all symbols in the entry
+        std::uint8_t firstBitsCount = 0;
+        std::uint8_t reserved = 0;
+    };
+    static_assert (sizeof(Entry) == 8, "");
+
+    void build(const HuffmanDict& dict);
+
+private:
+    DecodeTree tree_;
+    Mode mode_ = Mode::SingleSymbol;
+    TableBuffer<Entry> entries_;
+};
+
+#endif // DECODETABLE_HPP
@@ -0,0 +1,73 @@
+#include "decodetree.hpp"
+#include "bitreader.hpp"
+
+#include <deque>
+
+
+DecodeTree::DecodeTree(const HuffmanDict& dict)
+{
+    // codes are inserted in a temporary tree, links to leafs are final already
+    std::vector<Node> insertedNodes(1);
+    for(std::size_t symbol = 0; symbol < dict.size() && symbol < COUNT_FREQUENCIES; ++symbol) {
+        const auto& bitCode = dict[symbol];
+        if(bitCode.empty()) {
+            continue;
+        }
+
+        std::size_t nodeIndex = 0;
+        for(std::size_t bitIndex = 0; bitIndex < bitCode.size(); ++bitIndex) {
+            const bool bit = bitCode[bitIndex];
+            auto link = insertedNodes[nodeIndex].children[bit];
+            const bool isLastBit = bitIndex + 1 == bitCode.size();
+            if(link != NO_CHILD && ((link & LEAF_FLAG) || isLastBit)) {
+                throw std::runtime_error{"Invalid Huffman code"};
+            }
+
+            if(isLastBit) {
+                insertedNodes[nodeIndex].children[bit] = static_cast<std::uint16_t>(LEAF_FLAG | symbol);
+            }
+            else {
+                if(link == NO_CHILD) {
+                    link = static_cast<std::uint16_t>(insertedNodes.size());
+                    insertedNodes[nodeIndex].children[bit] = link;
+                    insertedNodes.emplace_back();
+                }
+                nodeIndex = link;
+            }
+        }
+    }
+
+    // breadth-first renumbering: the upper levels used by every symbol share cache lines
+    std::vector<std::uint16_t> newIndexes(insertedNodes.size());
+    std::deque<std::uint16_t> queue{0};
+    nodes_.reserve(insertedNodes.size());
+    while(!queue.empty()) {
+        const auto nodeIndex = queue.front();
+        queue.pop_front();
+
+        newIndexes[nodeIndex] = static_cast<std::uint16_t>(nodes_.size());
+        nodes_.push_back(insertedNodes[nodeIndex]);
+        for(const auto link : insertedNodes[nodeIndex].children) {
+            if(!(link & LEAF_FLAG)) {
+                queue.push_back(link);
+            }
+        }
+    }
+
+    for(auto& node : nodes_) {
+        for(auto& link : node.children) {
+            if(!(link & LEAF_FLAG)) {
+                link = newIndexes[link];
+            }
+        }
+    }
+}
+
+std::uint64_t DecodeTree::decode(const std::uint8_t* first, const std::uint8_t* last, std::size_t count, std::uint8_t* outFirst) const
+{
+    BitReader reader(first, last);
+    for(; count > 0; --count) {
+        *outFirst++ = decodeSymbol(reader);
+    }
+    return reader.consumedBits();
+}
@@ -0,0 +1,53 @@
+#ifndef DECODETREE_HPP
+#define DECODETREE_HPP
+
+#include "htree.hpp"
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <stdexcept>
+
+
+// Immutable tree for decoding: only internal nodes, laid out breadth-first, 4 bytes each.
+// A child link is either an index of the next node or a leaf symbol marked by LEAF_FLAG,
+// so the tree for 256 symbols takes about 1 KiB.
+class DecodeTree {
+public:
+    static constexpr std::uint16_t LEAF_FLAG = 0x8000;
+    static constexpr std::uint16_t NO_CHILD = 0xFFFF;
+
+    explicit DecodeTree(const HuffmanDict& dict);
+
+    std::size_t nodesCount() const { return nodes_.size(); }
+
+    // BitSource has bool readBit()
+    template<class BitSource>
+    std::uint8_t decodeSymbol(BitSource& bits) const
+    {
+        std::uint16_t link = 0;
+        do {
+            link = nodes_[link].children[bits.readBit()];
+        } while(!(link & LEAF_FLAG));
+
+        if(link == NO_CHILD) {
+            throw std::runtime_error{"Invalid Huffman code"};
+        }
+        return static_cast<std::uint8_t>(link);
+    }
+
+    // decodes exactly count symbols, returns count of consumed bits
+    // (greater than (last - first) * 8 if the data is truncated)
+    std::uint64_t decode(const std::uint8_t* first, const std::uint8_t* last, std::size_t count, std::uint8_t* outFirst) const;
+
+private:
+    struct Node {
+        std::uint16_t children[2]{NO_CHILD, NO_CHILD};
+    };
+    static_assert (sizeof(Node) == 4, "");
+
+private:
+    TableBuffer<Node> nodes_;
+};
+
+#endif // DECODETREE_HPP
@@ -0,0 +1,337 @@
+#include "dedup.hpp"
+#include "huffmanencoding.hpp"
+#include "utils.hpp"
+
+#include <array>
+#include <fstream>
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+
+
+namespace {
+
+constexpr std::array<std::uint8_t, 4> INDEX_HEADER = {'H', 'A', 'F', 'I'};
+
+constexpr std::uint64_t split_mix(std::uint64_t& state)
+{
+    auto result = (state += 0x9e3779b97f4a7c15ull);
+    result = (result ^ (result >> 30)) * 0xbf58476d1ce4e5b9ull;
+    result = (result ^ (result >> 27)) * 0x94d049bb133111ebull;
+    return result ^ (result >> 31);
+}
+
+constexpr std::array<std::uint64_t, 256> make_gear_table()
+{
+    std::array<std::uint64_t, 256> result{};
+    std::uint64_t state = 0;
+    for(auto& value : result) {
+        value = split_mix(state);
+    }
+    return result;
+}
+
+constexpr auto GEAR = make_gear_table();
+
+// the hash is shifted left on every byte, so its top bits depend on the last 64 bytes;
+// a cut before the average size is less likely than after it (normalized chunking)
+constexpr std::uint64_t top_bits_mask(unsigned count) { return ~std::uint64_t{0} << (64 - count); }
+constexpr std::uint64_t SMALL_CHUNK_MASK = top_bits_mask(18);
+constexpr std::uint64_t LARGE_CHUNK_MASK = top_bits_mask(14);
+
+void throw_reference_error(const std::string& message) { throw std::runtime_error{"Invalid block reference: " + message}; }
+
+}
+
+std::size_t find_chunk_boundary(const std::uint8_t* data, std::size_t size, std::size_t maxSize)
+{
+    const auto limit = std::min(size, maxSize);
+    if(limit <= CDC_MIN_SIZE) {
+        return limit;
+    }
+
+    std::uint64_t hash = 0;
+    std::size_t pos = CDC_MIN_SIZE;
+    for(const auto normalLimit = std::min(limit, CDC_AVERAGE_SIZE); pos < normalLimit; ++pos) {
+        hash = (hash << 1) + GEAR[data[pos]];
+        if((hash & SMALL_CHUNK_MASK) == 0) {
+            return pos + 1;
+        }
+    }
+    for(; pos < limit; ++pos) {
+        hash = (hash << 1) + GEAR[data[pos]];
+        if((hash & LARGE_CHUNK_MASK) == 0) {
+            return pos + 1;
+        }
+    }
+    return limit;
+}
+
+ChunkReader::ChunkReader(std::istream& inputStream, std::size_t maxSize)
+    : inputStream_{inputStream}
+    , maxSize_{maxSize}
+    , buffer_(bufferSize(maxSize))
+{}
+
+bool ChunkReader::read(BytesBuffer& chunk)
+{
+    // at least maxSize bytes are kept ahead, so the cuts don't depend on the reads
+    if(last_ - first_ < maxSize_ && !endOfStream_) {
+        std::memmove(buffer_.data(), buffer_.data() + first_, last_ - first_);
+        last_ -= first_;
+        first_ = 0;
+
+        inputStream_.read(reinterpret_cast<char*>(buffer_.data() + last_), std::streamsize(buffer_.size() - last_));
+        const auto countRead = static_cast<std::size_t>(inputStream_.gcount());
+        endOfStream_ = (countRead < buffer_.size() - last_);
+        last_ += countRead;
+    }
+    if(first_ == last_) {
+        return false;
+    }
+
+    const auto size = find_chunk_boundary(buffer_.data() + first_, last_ - first_, maxSize_);
+    chunk.assign(buffer_.cbegin() + std::ptrdiff_t(first_), buffer_.cbegin() + std::ptrdiff_t(first_ + size));
+    first_ += size;
+    return true;
+}
+
+std::size_t ChunkIndex::DigestHash::operator()(const Sha256Digest& digest) const
+{
+    std::size_t result = 0;
+    std::memcpy(&result, digest.data(), sizeof(result));
+    return result;
+}
+
+ChunkIndex::ChunkIndex(const std::string& path)
+    : path_{path}
+{
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    if(!file) {
+        return;
+    }
+
+    std::array<std::uint8_t, 4> header{};
+    std::uint32_t archivesCount = 0;
+    read(file, header);
+    read(file, archivesCount);
+    if(!file || header != INDEX_HEADER) {
+        throw std::runtime_error{"Invalid chunk index: \"" + path + "\""};
+    }
+
+    for(std::uint32_t archive = 0; archive < archivesCount && file; ++archive) {
+        std::uint16_t size = 0;
+        read(file, size);
+        std::string name(size, '\0');
+        file.read(&name[0], size);
+        archives_.push_back(std::move(name));
+    }
+
+    std::uint64_t chunksCount = 0;
+    read(file, chunksCount);
+    for(std::uint64_t chunk = 0; chunk < chunksCount && file; ++chunk) {
+        Sha256Digest digest;
+        Entry entry;
+        read(file, digest);
+        read(file, entry.archive);
+        read(file, entry.offset);
+        if(entry.archive >= archives_.size()) {
+            break;
+        }
+        chunks_[digest] = entry;
+    }
+
+    // the references are missing in the indexes written before them
+    std::uint64_t referencesCount = 0;
+    if(file && file.peek() != std::ifstream::traits_type::eof()) {
+        read(file, referencesCount);
+    }
+    for(std::uint64_t reference = 0; reference < referencesCount && file; ++reference) {
+        std::uint32_t referrer = 0;
+        std::uint32_t referenced = 0;
+        read(file, referrer);
+        read(file, referenced);
+        if(referrer >= archives_.size() || referenced >= archives_.size()) {
+            break;
+        }
+        references_.emplace(referrer, referenced);
+    }
+    if(!file) {
+        throw std::runtime_error{"Invalid chunk index: \"" + path + "\""};
+    }
+}
+
+void ChunkIndex::setArchive(const std::string& name)
+{
+    if(!is_plain_file_name(name)) {
+        throw std::runtime_error{"Invalid archive name for deduplication: \"" + name + "\""};
+    }
+
+    std::lock_guard<std::mutex> lock{mutex_};
+    const auto it = std::find(archives_.cbegin(), archives_.cend(), name);
+    const auto archive = static_cast<std::uint32_t>(it - archives_.cbegin());
+    if(it == archives_.cend()) {
+        archives_.push_back(name);
+        currentArchive_ = archive;
+        return;
+    }
+
+    // the blocks of the old archive would be lost for the archives with references to them
+    for(const auto& reference : references_) {
+        if(reference.second == archive && reference.first != archive) {
+            throw std::runtime_error{"Archive \"" + name + "\" can't be overwritten: \"" + archives_[reference.first] +
+                                     "\" has references to its blocks"};
+        }
+    }
+
+    // the archive is overwritten
+    currentArchive_ = archive;
+    for(auto chunkIt = chunks_.begin(); chunkIt != chunks_.end();) {
+        chunkIt = (chunkIt->second.archive == currentArchive_) ? chunks_.erase(chunkIt) : std::next(chunkIt);
+    }
+    for(auto referenceIt = references_.begin(); referenceIt != references_.end();) {
+        referenceIt = (referenceIt->first == currentArchive_) ? references_.erase(referenceIt) : std::next(referenceIt);
+    }
+}
+
+bool ChunkIndex::find(const Sha256Digest& digest, ChunkLocation& location) const
+{
+    std::lock_guard<std::mutex> lock{mutex_};
+    const auto it = chunks_.find(digest);
+    if(it == chunks_.cend()) {
+        return false;
+    }
+    location.archive = archives_[it->second.archive];
+    location.offset = it->second.offset;
+    return true;
+}
+
+void ChunkIndex::add(const Sha256Digest& digest, std::uint64_t offset)
+{
+    std::lock_guard<std::mutex> lock{mutex_};
+    chunks_.emplace(digest, Entry{currentArchive_, offset});
+}
+
+void ChunkIndex::addReference(const Sha256Digest& digest)
+{
+    std::lock_guard<std::mutex> lock{mutex_};
+    const auto it = chunks_.find(digest);
+    if(it != chunks_.cend() && it->second.archive != currentArchive_) {
+        references_.emplace(currentArchive_, it->second.archive);
+    }
+}
+
+std::size_t ChunkIndex::chunksCount() const
+{
+    std::lock_guard<std::mutex> lock{mutex_};
+    return chunks_.size();
+}
+
+void ChunkIndex::save() const
+{
+    std::lock_guard<std::mutex> lock{mutex_};
+
+    // written next to the old one and renamed, so a failure leaves the old index
+    const auto tempPath = path_ + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::out | std::ios::binary);
+        write(file, INDEX_HEADER);
+        write(file, static_cast<std::uint32_t>(archives_.size()));
+        for(const auto& name : archives_) {
+            write(file, static_cast<std::uint16_t>(name.size()));
+            file.write(name.data(), std::streamsize(name.size()));
+        }
+
+        write(file, static_cast<std::uint64_t>(chunks_.size()));
+        for(const auto& chunk : chunks_) {
+            write(file, chunk.first);
+            write(file, chunk.second.archive);
+            write(file, chunk.second.offset);
+        }
+
+        write(file, static_cast<std::uint64_t>(references_.size()));
+        for(const auto& reference : references_) {
+            write(file, reference.first);
+            write(file, reference.second);
+        }
+        if(!file) {
+            throw std::runtime_error{"Unable to write chunk index: \"" + tempPath + "\""};
+        }
+    }
+    if(std::rename(tempPath.c_str(), path_.c_str()) != 0) {
+        throw std::runtime_error{"Unable to write chunk index: \"" + path_ + "\""};
+    }
+}
+
+std::string file_name(const std::string& path)
+{
+    const auto separator = path.find_last_of("/\\");
+    return (separator == std::string::npos) ? path : path.substr(separator + 1);
+}
+
+std::string directory_of(const std::string& path)
+{
+    const auto separator = path.find_last_of("/\\");
+    return (separator == std::string::npos) ? std::string{"."} : path.substr(0, separator);
+}
+
+bool is_plain_file_name(const std::string& name)
+{
+    return !name.empty() && name.find_first_of(std::string{"/\\:\0", 4}) == std::string::npos && name.find("..") == std::string::npos;
+}
+
+void write_reference(const Sha256Digest& digest, const ChunkLocation& location, BytesBuffer& output)
+{
+    const auto nameSize = static_cast<std::uint16_t>(location.archive.size());
+    output.resize(digest.size() + sizeof(location.offset) + sizeof(nameSize) + nameSize);
+
+    auto* out = output.data();
+    std::memcpy(out, digest.data(), digest.size());
+    out += digest.size();
+    std::memcpy(out, &location.offset, sizeof(location.offset));
+    out += sizeof(location.offset);
+    std::memcpy(out, &nameSize, sizeof(nameSize));
+    out += sizeof(nameSize);
+    std::memcpy(out, location.archive.data(), nameSize);
+}
+
+void decode_reference(const BlockHeader& header, const BytesBuffer& input, const std::string& directory, BytesBuffer& output)
+{
+    ChunkLocation location;
+    std::uint16_t nameSize = 0;
+    constexpr auto fixedSize = sizeof(Sha256Digest) + sizeof(location.offset) + sizeof(nameSize);
+    if(input.size() < fixedSize) {
+        throw_reference_error("corrupted");
+    }
+    std::memcpy(&location.offset, input.data() + sizeof(Sha256Digest), sizeof(location.offset));
+    std::memcpy(&nameSize, input.data() + sizeof(Sha256Digest) + sizeof(location.offset), sizeof(nameSize));
+    if(input.size() != fixedSize + nameSize) {
+        throw_reference_error("corrupted");
+    }
+    location.archive.assign(reinterpret_cast<const char*>(input.data() + fixedSize), nameSize);
+    if(!is_plain_file_name(location.archive)) {
+        throw_reference_error("archive name \"" + location.archive + "\" isn't a file name");
+    }
+
+    const auto path = directory + '/' + location.archive;
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    if(!file) {
+        throw_reference_error("no archive \"" + path + "\"");
+    }
+    read_blocks_header(file);
+
+    BlockHeader referencedHeader;
+    file.seekg(std::streamoff(location.offset));
+    read(file, referencedHeader);
+    if(!file || referencedHeader.type == BlockType::Reference || referencedHeader.rawSize != header.rawSize ||
+       referencedHeader.checksum != header.checksum || referencedHeader.packedSize > referencedHeader.rawSize) {
+        throw_reference_error("no block at " + std::to_string(location.offset) + " of \"" + path + "\"");
+    }
+
+    BytesBuffer payload(referencedHeader.packedSize);
+    file.read(reinterpret_cast<char*>(payload.data()), std::streamsize(payload.size()));
+    if(!file) {
+        throw_reference_error("truncated archive \"" + path + "\"");
+    }
+    decode_block(referencedHeader, payload, output);
+}
@@ -0,0 +1,111 @@
+#ifndef DEDUP_HPP
+#define DEDUP_HPP
+
+#include "blockcodec.hpp"
+#include "sha256.hpp"
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <istream>
+#include <set>
+#include <unordered_map>
+#include <algorithm>
+
+
+// Deduplication of blocks across archives (nightly snapshots of mostly the same data).
+// Input is cut where the gear rolling hash of the last 64 bytes hits a mask (FastCDC with normalized chunking),
+// so an edit moves only the boundaries near it and the rest of the chunks repeat the ones of the old version.
+// Every chunk is a block identified by SHA-256 of its data. The index next to the archives maps the digests
+// to the blocks already written, a repeated chunk becomes a Reference block pointing to one of them.
+// Referenced archives are looked for in the directory of the archive being decompressed.
+
+constexpr std::size_t CDC_MIN_SIZE = 16 * 1024;
+constexpr std::size_t CDC_AVERAGE_SIZE = 64 * 1024;
+constexpr std::size_t CDC_MAX_SIZE = 256 * 1024;
+
+// size of the first chunk of data, size itself if there is no cut before maxSize
+std::size_t find_chunk_boundary(const std::uint8_t* data, std::size_t size, std::size_t maxSize = CDC_MAX_SIZE);
+
+// reads content defined chunks of at most maxSize bytes from the stream
+class ChunkReader {
+public:
+    explicit ChunkReader(std::istream& inputStream, std::size_t maxSize = CDC_MAX_SIZE);
+
+    static std::size_t bufferSize(std::size_t maxSize) { return std::max<std::size_t>(4 * 1024 * 1024, 2 * maxSize); }
+
+    // false at the end of the stream
+    bool read(BytesBuffer& chunk);
+
+private:
+    std::istream& inputStream_;
+    std::size_t maxSize_ = CDC_MAX_SIZE;
+    BytesBuffer buffer_;
+    std::size_t first_ = 0;
+    std::size_t last_ = 0;
+    bool endOfStream_ = false;
+};
+
+// Chunk index file
+// char header[4];               // "HAFI"
+// std::uint32_t archivesCount;
+// {std::uint16_t size; char name[size];}[archivesCount] // имена архивов
+// std::uint64_t chunksCount;
+// {std::uint8_t digest[32]; std::uint32_t archive; std::uint64_t offset;}[chunksCount] // где хранится фрагмент
+// std::uint64_t referencesCount;  // может отсутствовать в индексах без ссылок
+// {std::uint32_t referrer; std::uint32_t referenced;}[referencesCount] // архив со ссылками на блоки другого архива
+
+struct ChunkLocation {
+    std::string archive;      // file name of the archive
+    std::uint64_t offset = 0; // of the block header
+};
+
+// Thread safe
+class ChunkIndex {
+public:
+    // loads the index if the file exists
+    explicit ChunkIndex(const std::string& path);
+
+    // new chunks go to this archive, the chunks of the old archive with this name are forgotten;
+    // throws if the name isn't a plain file name or other archives have references to the old one
+    void setArchive(const std::string& name);
+    const std::string& archive() const { return archives_[currentArchive_]; }
+
+    bool find(const Sha256Digest& digest, ChunkLocation& location) const;
+    void add(const Sha256Digest& digest, std::uint64_t offset);
+    // the current archive has a reference to the chunk
+    void addReference(const Sha256Digest& digest);
+    std::size_t chunksCount() const;
+
+    void save() const;
+
+private:
+    struct Entry {
+        std::uint32_t archive = 0;
+        std::uint64_t offset = 0;
+    };
+    struct DigestHash {
+        std::size_t operator()(const Sha256Digest& digest) const;
+    };
+
+private:
+    std::string path_;
+    mutable std::mutex mutex_;
+    std::vector<std::string> archives_;
+    std::uint32_t currentArchive_ = 0;
+    std::unordered_map<Sha256Digest, Entry, DigestHash> chunks_;
+    std::set<std::pair<std::uint32_t, std::uint32_t>> references_; // referrer, referenced
+};
+
+std::string file_name(const std::string& path);
+std::string directory_of(const std::string& path);
+// a name of a file in the same directory: not empty, without separators, drives and ".."
+bool is_plain_file_name(const std::string& name);
+
+// Reference payload, see blockcodec.hpp
+void write_reference(const Sha256Digest& digest, const ChunkLocation& location, BytesBuffer& output);
+// decodes the referenced block of the archive in directory, checks it against the header of the reference,
+// throws if the name of the archive isn't a plain file name
+void decode_reference(const BlockHeader& header, const BytesBuffer& input, const std::string& directory, BytesBuffer& output);
+
+#endif // DEDUP_HPP
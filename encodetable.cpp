@@ -0,0 +1,68 @@
+#include "encodetable.hpp"
+
+#include <algorithm>
+
+
+EncodeTable::EncodeTable(const HuffmanDict& dict, std::size_t inputSize) : EncodeTable(dict, chooseMode(dict, inputSize)) {}
+
+EncodeTable::EncodeTable(const HuffmanDict& dict, Mode mode)
+    : mode_{mode}
+    , codes_(COUNT_FREQUENCIES, 0)
+{
+    for(std::size_t symbol = 0; symbol < dict.size() && symbol < COUNT_FREQUENCIES; ++symbol) {
+        std::uint64_t code = 0;
+        for(const bool bit : dict[symbol]) {
+            code = (code << 1) | static_cast<std::uint64_t>(bit);
+        }
+        codes_[symbol] = pack(code, dict[symbol].size());
+    }
+
+    if(mode_ != Mode::SymbolPairs) {
+        return;
+    }
+
+    // index is the first byte in the high half, as the bytes come in memory read big-endian
+    pairs_.resize(COUNT_FREQUENCIES * COUNT_FREQUENCIES);
+    for(std::size_t firstSymbol = 0; firstSymbol < COUNT_FREQUENCIES; ++firstSymbol) {
+        const auto firstEntry = codes_[firstSymbol];
+        if(count(firstEntry) == 0) {
+            continue;
+        }
+        for(std::size_t secondSymbol = 0; secondSymbol < COUNT_FREQUENCIES; ++secondSymbol) {
+            const auto secondEntry = codes_[secondSymbol];
+            pairs_[(firstSymbol << 8) | secondSymbol] = pack((code(firstEntry) << count(secondEntry)) | code(secondEntry),
+                                                              count(firstEntry) + count(secondEntry));
+        }
+    }
+}
+
+EncodeTable::Mode EncodeTable::chooseMode(const HuffmanDict& dict, std::size_t inputSize)
+{
+    std::size_t maxLength = 0;
+    for(const auto& bitCode : dict) {
+        maxLength = std::max<std::size_t>(maxLength, bitCode.size());
+    }
+
+    return (inputSize >= MIN_PAIRS_INPUT && maxLength * 2 <= MAX_PAIR_BITS) ? Mode::SymbolPairs : Mode::SingleSymbol;
+}
+
+std::size_t EncodeTable::tablesSize(std::size_t inputSize)
+{
+    const auto pairsCount = (inputSize >= MIN_PAIRS_INPUT) ? COUNT_FREQUENCIES * COUNT_FREQUENCIES : 0;
+    return (COUNT_FREQUENCIES + pairsCount) * sizeof(std::uint64_t);
+}
+
+void EncodeTable::encode(const std::uint8_t* first, const std::uint8_t* last, BitWriter& writer) const
+{
+    if(mode_ == Mode::SymbolPairs) {
+        for(; last - first >= 2; first += 2) {
+            const auto entry = pairs_[(std::size_t{first[0]} << 8) | first[1]];
+            writer.put(code(entry), count(entry));
+        }
+    }
+
+    for(; first != last; ++first) {
+        const auto entry = codes_[*first];
+        writer.put(code(entry), count(entry));
+    }
+}
@@ -0,0 +1,48 @@
+#ifndef ENCODETABLE_HPP
+#define ENCODETABLE_HPP
+
+#include "htree.hpp"
+#include "bitwriter.hpp"
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+
+// Flat encoding table: every entry keeps code and its length packed in one 64-bit word.
+// In SymbolPairs mode there is an entry for each pair of bytes, so one append writes two codes.
+class EncodeTable {
+public:
+    static constexpr unsigned MAX_PAIR_BITS = 56;
+    // building the pairs table doesn't pay off for small blocks
+    static constexpr std::size_t MIN_PAIRS_INPUT = 64 * 1024;
+
+    enum class Mode {
+        SingleSymbol,
+        SymbolPairs
+    };
+
+public:
+    explicit EncodeTable(const HuffmanDict& dict, std::size_t inputSize);
+    explicit EncodeTable(const HuffmanDict& dict, Mode mode);
+
+    static Mode chooseMode(const HuffmanDict& dict, std::size_t inputSize);
+    // bytes of the tables for at most inputSize bytes of input
+    static std::size_t tablesSize(std::size_t inputSize);
+    Mode mode() const { return mode_; }
+
+    // can be called for consecutive pieces of data with the same writer
+    void encode(const std::uint8_t* first, const std::uint8_t* last, BitWriter& writer) const;
+
+private:
+    static std::uint64_t pack(std::uint64_t code, unsigned count) { return (code << 8) | count; }
+    static std::uint64_t code(std::uint64_t entry) { return entry >> 8; }
+    static unsigned count(std::uint64_t entry) { return entry & 0xFF; }
+
+private:
+    Mode mode_ = Mode::SingleSymbol;
+    TableBuffer<std::uint64_t> codes_;
+    TableBuffer<std::uint64_t> pairs_;
+};
+
+#endif // ENCODETABLE_HPP
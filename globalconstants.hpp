@@ -3,5 +3,6 @@
 
 constexpr auto BITS_IN_BYTE = 8;
 constexpr auto COUNT_FREQUENCIES = 256;
+constexpr auto DEFAULT_BLOCK_SIZE = 1024 * 1024;
 
 #endif // GLOBALCONSTANTS_HPP
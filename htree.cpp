@@ -1,11 +1,59 @@
 #include "htree.hpp"
 
-#include "priority_queue.hpp"
+#include "stats.hpp"
 
 #include <algorithm>
+#include <numeric>
 #include <cassert>
 
 
+void HTree::setFrequencies(const CharFrequencies& frequencies)
+{
+    clearNodes();
+    huffmanDict_.assign(COUNT_FREQUENCIES, BitsBuffer());
+    frequencies_ = frequencies;
+    rootID_ = 0;
+    nodes_.reserve(2 * COUNT_FREQUENCIES);
+
+    LeafIDs leafs;
+    const auto leafsCount = fillNodes(frequencies_, leafs);
+    if(leafsCount == 0) {
+        return;
+    }
+
+    {
+        StageTimer timer{Stage::BuildTree};
+        buildTree(leafs, leafsCount);
+    }
+    {
+        StageTimer timer{Stage::BuildDict};
+        buildHuffmanDictFromTree(huffmanDict_, leafs, leafsCount);
+    }
+}
+
+std::uint64_t HTree::dataSize() const
+{
+    return std::accumulate(std::cbegin(frequencies_), std::cend(frequencies_), std::uint64_t{0});
+}
+
+std::uint64_t HTree::encodedBitsCount() const
+{
+    std::uint64_t result = 0;
+    for(std::size_t currentSign = 0; currentSign < frequencies_.size(); ++currentSign) {
+        result += std::uint64_t{frequencies_[currentSign]} * huffmanDict_[currentSign].size();
+    }
+    return result;
+}
+
+std::size_t HTree::maxCodeLength() const
+{
+    std::size_t result = 0;
+    for(const auto& bitCode : huffmanDict_) {
+        result = std::max<std::size_t>(result, bitCode.size());
+    }
+    return result;
+}
+
 void HTree::setHuffmanDict(const HuffmanDict& dict) { setHuffmanDict(HuffmanDict(dict)); }
 
 void HTree::setHuffmanDict(HuffmanDict&& dict)
@@ -15,6 +63,7 @@ void HTree::setHuffmanDict(HuffmanDict&& dict)
     clearNodes();
     const int rootNodeID = makeNode();
     huffmanDict_ = std::move(dict);
+    frequencies_.fill(0);
     rootID_ = rootNodeID;
 
     for(std::size_t currentSign = 0; currentSign < huffmanDict_.size(); ++currentSign) {
@@ -61,9 +110,9 @@ int HTree::makeRightNode(int parentID)
     return newNodeID;
 }
 
-HTree::NodeIDs HTree::fillNodes(const CharFrequencies& frequencies)
+std::size_t HTree::fillNodes(const CharFrequencies& frequencies, LeafIDs& leafs)
 {
-    NodeIDs leafsIDs;
+    std::size_t leafsCount = 0;
     for(std::size_t currentSign = 0; currentSign < frequencies.size(); ++currentSign) {
         const std::size_t currSignFrequency = frequencies.at(currentSign);
         if(currSignFrequency <= 0) {
@@ -74,25 +123,45 @@ HTree::NodeIDs HTree::fillNodes(const CharFrequencies& frequencies)
         auto& lastElem = getNode(currNodeID);
         lastElem.sign = static_cast<std::uint8_t>(currentSign);
         lastElem.weight = currSignFrequency;
-        leafsIDs.push_back(currNodeID);
+        leafs[leafsCount++] = currNodeID;
     }
-    return leafsIDs;
+    return leafsCount;
 }
 
-void HTree::buildTree(const NodeIDs& leafs)
+void HTree::buildTree(const LeafIDs& leafs, std::size_t leafsCount)
 {
-    assert(!leafs.empty());
+    assert(leafsCount > 0);
+
+    if(leafsCount == 1) {
+        // single symbol still needs one bit code, otherwise decoder can't advance
+        const int rootID = makeNode();
+        getNode(rootID).leftNodeID = leafs.front();
+        getNode(rootID).weight = getNode(leafs.front()).weight;
+        getNode(leafs.front()).parentNodeID = rootID;
+        rootID_ = rootID;
+        return;
+    }
 
-    const auto comp = [this](const int left, const int right) {
-        return getNode(left).weight < getNode(right).weight;
+    // leafs sorted by weight and parents created in non-decreasing weight order are two queues,
+    // the lightest node is the lighter of their fronts (a leaf on ties - as the sorted queue did)
+    std::array<int, COUNT_FREQUENCIES> sortedLeafs;
+    std::array<int, COUNT_FREQUENCIES> parents;
+    sortByWeight(leafs.data(), leafsCount, sortedLeafs.data());
+
+    std::size_t leafIndex = 0;
+    std::size_t firstParentIndex = 0;
+    std::size_t parentsCount = 0;
+    const auto takeLightest = [&]() {
+        if(leafIndex < leafsCount &&
+           (firstParentIndex == parentsCount || getNode(sortedLeafs[leafIndex]).weight <= getNode(parents[firstParentIndex]).weight)) {
+            return sortedLeafs[leafIndex++];
+        }
+        return parents[firstParentIndex++];
     };
 
-    priority_queue<int, decltype(comp)> freeNodes(leafs.cbegin(), leafs.cend(), comp);
-    while(freeNodes.size() > 1) {
-        const int leftChildID = freeNodes.top();
-        freeNodes.pop();
-        const int rightChildID = freeNodes.top();
-        freeNodes.pop();
+    for(std::size_t mergeIndex = 0; mergeIndex + 1 < leafsCount; ++mergeIndex) {
+        const int leftChildID = takeLightest();
+        const int rightChildID = takeLightest();
 
         const int parentID = makeNode();
         auto& parent = getNode(parentID);
@@ -107,14 +176,47 @@ void HTree::buildTree(const NodeIDs& leafs)
         leftChild.parentNodeID = parentID;
         rightChild.parentNodeID = parentID;
 
-        freeNodes.push(parentID);
+        parents[parentsCount++] = parentID;
+    }
+    rootID_ = parents[parentsCount - 1];
+}
+
+void HTree::sortByWeight(const int* nodeIDs, std::size_t count, int* sortedIDs) const
+{
+    // stable LSD radix sort by bytes of weights, each pass is a counting sort
+    std::array<int, COUNT_FREQUENCIES> buffer;
+    std::copy(nodeIDs, nodeIDs + count, sortedIDs);
+
+    std::size_t maxWeight = 0;
+    for(std::size_t index = 0; index < count; ++index) {
+        maxWeight = std::max(maxWeight, getNode(nodeIDs[index]).weight);
+    }
+
+    int* from = sortedIDs;
+    int* to = buffer.data();
+    for(std::size_t shift = 0; shift < BITS_IN_BYTE * sizeof(std::size_t) && (maxWeight >> shift) != 0; shift += BITS_IN_BYTE) {
+        std::array<std::uint16_t, 256 + 1> offsets{0};
+        for(std::size_t index = 0; index < count; ++index) {
+            ++offsets[((getNode(from[index]).weight >> shift) & 0xFF) + 1];
+        }
+        for(std::size_t digit = 1; digit < offsets.size(); ++digit) {
+            offsets[digit] += offsets[digit - 1];
+        }
+        for(std::size_t index = 0; index < count; ++index) {
+            to[offsets[(getNode(from[index]).weight >> shift) & 0xFF]++] = from[index];
+        }
+        std::swap(from, to);
+    }
+
+    if(from != sortedIDs) {
+        std::copy(from, from + count, sortedIDs);
     }
-    rootID_ = freeNodes.top();
 }
 
-void HTree::buildHuffmanDictFromTree(HuffmanDict& dict, const NodeIDs& leafs)
+void HTree::buildHuffmanDictFromTree(HuffmanDict& dict, const LeafIDs& leafs, std::size_t leafsCount)
 {
-    for(const int leafID : leafs) {
+    for(std::size_t leafIndex = 0; leafIndex < leafsCount; ++leafIndex) {
+        const int leafID = leafs[leafIndex];
         const auto sign = getNode(leafID).sign;
         auto& bits = dict.at(static_cast<std::size_t>(sign));
         for(int parentID = leafID; getNode(parentID).parentNodeID >= 0; parentID = getNode(parentID).parentNodeID) {
@@ -1,6 +1,7 @@
 #ifndef HTREE_HPP
 #define HTREE_HPP
 
+#include "bufferalloc.hpp"
 #include "bits_array.hpp"
 #include "utils.hpp"
 
@@ -8,17 +9,29 @@
 #include <array>
 #include <algorithm>
 #include <iostream>
+#include <stdexcept>
 #include <chrono>
 
 
 static_assert (sizeof(char) == sizeof(std::uint8_t), "");
 
-using BytesBuffer = std::vector<std::uint8_t>;
 using BitsBuffer = bits_array<std::uint32_t>;
-using HuffmanDict = std::vector<BitsBuffer>;
+using HuffmanDict = std::vector<BitsBuffer, tracked_allocator<BitsBuffer, AllocSubsystem::Dict>>;
 using CharFrequencies = std::array<std::size_t, COUNT_FREQUENCIES>;
 
+template<class It>
+CharFrequencies count_frequencies(It first, It last)
+{
+    CharFrequencies frequencies{0};
+    std::for_each(first, last, [&frequencies](const std::uint8_t currByte){
+        ++frequencies[currByte];
+    });
+    return frequencies;
+}
+
 struct HTreeNode {
+    bool isLeaf() const { return leftNodeID < 0 && rightNodeID < 0; }
+
     std::size_t weight = 0;
     std::uint8_t sign = 0;
     int leftNodeID = -1;
@@ -29,27 +42,24 @@ struct HTreeNode {
 class HTree {
 public: // types
     using Node = HTreeNode;
-    using Nodes = std::vector<Node>;
-    using NodeIDs = std::vector<int>;
+    using Nodes = std::vector<Node, tracked_allocator<Node, AllocSubsystem::Tree>>;
+    // at most a leaf per symbol, the tree is built on the stack
+    using LeafIDs = std::array<int, COUNT_FREQUENCIES>;
 
 public:
     explicit HTree() : huffmanDict_{COUNT_FREQUENCIES} {}
     HuffmanDict huffmanDict() const { return huffmanDict_; }
+    const CharFrequencies& frequencies() const { return frequencies_; }
 
     template<class It>
-    void setData(It first, It last)
-    {
-        // calculating frequencies
-        CharFrequencies frequencies{0};
-        std::for_each(first, last, [&frequencies](const std::uint8_t currByte){
-            ++frequencies.at(currByte);
-        });
-
-        // building tree
-        const auto leafs = fillNodes(frequencies);
-        buildTree(leafs);
-        buildHuffmanDictFromTree(huffmanDict_, leafs);
-    }
+    void setData(It first, It last) { setFrequencies(count_frequencies(first, last)); }
+    void setFrequencies(const CharFrequencies& frequencies);
+
+    // count of source bytes the frequencies were taken from
+    std::uint64_t dataSize() const;
+    // exact size of the encoded data in bits (without header)
+    std::uint64_t encodedBitsCount() const;
+    std::size_t maxCodeLength() const;
 
     void setHuffmanDict(const HuffmanDict& dict);
     void setHuffmanDict(HuffmanDict&& dict);
@@ -62,7 +72,7 @@ public:
             std::copy(std::cbegin(currBits), std::cend(currBits), outFirst);
         }
 
-        return BITS_IN_BYTE - outFirst.currentBit();
+        return (BITS_IN_BYTE - outFirst.currentBit()) % BITS_IN_BYTE;
     }
 
     template<class BitIt, class ByteIt>
@@ -70,7 +80,7 @@ public:
     {
         for(; first != last; ++outFirst) {
             int currNodeID = rootID_;
-            while(getNode(currNodeID).leftNodeID >= 0 && getNode(currNodeID).rightNodeID >= 0 && first != last) {
+            while(!getNode(currNodeID).isLeaf() && first != last) {
                 if(first.isLastByte() && first.currentBit() > (BITS_IN_BYTE - bitsOffset - 1)) {
                     return;
                 }
@@ -81,6 +91,41 @@ public:
         }
     }
 
+    // decodes exactly count symbols, returns iterator to the first not consumed bit
+    // BitIt must be able to measure distance in bits
+    template<class BitIt, class ByteIt>
+    BitIt decodeSymbols(BitIt first, BitIt last, std::size_t count, ByteIt outFirst) const
+    {
+        const auto maxLength = std::max<std::size_t>(maxCodeLength(), 1);
+        while(count > 0) {
+            // so many symbols can't run out of bits - decoding them without end checks
+            auto safeCount = std::min(count, static_cast<std::size_t>(last - first) / maxLength);
+            if(safeCount == 0) {
+                int currNodeID = rootID_;
+                for(; !getNode(currNodeID).isLeaf(); ++first) {
+                    if(first == last) {
+                        throw std::runtime_error{"Unexpected end of encoded data"};
+                    }
+                    currNodeID = *first ? getNode(currNodeID).rightNodeID : getNode(currNodeID).leftNodeID;
+                }
+                *outFirst = getNode(currNodeID).sign;
+                ++outFirst;
+                --count;
+                continue;
+            }
+
+            count -= safeCount;
+            for(; safeCount > 0; --safeCount, ++outFirst) {
+                int currNodeID = rootID_;
+                for(; !getNode(currNodeID).isLeaf(); ++first) {
+                    currNodeID = *first ? getNode(currNodeID).rightNodeID : getNode(currNodeID).leftNodeID;
+                }
+                *outFirst = getNode(currNodeID).sign;
+            }
+        }
+        return first;
+    }
+
 private:
     int makeNode();
     int makeNode(int parentID);
@@ -89,16 +134,19 @@ private:
 
     Node& getNode(int nodeID) { return nodes_.at(static_cast<std::size_t>(nodeID)); }
     const Node& getNode(int nodeID) const { return nodes_.at(static_cast<std::size_t>(nodeID)); }
-    NodeIDs fillNodes(const CharFrequencies& frequencies);
+    // returns the count of leafs
+    std::size_t fillNodes(const CharFrequencies& frequencies, LeafIDs& leafs);
     void clearNodes() { nodes_.clear(); }
 
-    void buildTree(const NodeIDs& leafs);
-    void buildHuffmanDictFromTree(HuffmanDict& dict, const NodeIDs& leafs);
+    void buildTree(const LeafIDs& leafs, std::size_t leafsCount);
+    void sortByWeight(const int* nodeIDs, std::size_t count, int* sortedIDs) const;
+    void buildHuffmanDictFromTree(HuffmanDict& dict, const LeafIDs& leafs, std::size_t leafsCount);
 
 private:
     Nodes nodes_;
     int rootID_ = 0;
     HuffmanDict huffmanDict_;
+    CharFrequencies frequencies_{0};
 };
 
 #endif // !HTREE_HPP
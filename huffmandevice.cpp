@@ -0,0 +1,149 @@
+#include "huffmandevice.hpp"
+
+#include <exception>
+
+
+namespace {
+
+// one request to the wrapped device, large so the codec works on whole blocks
+constexpr int DEVICE_BUFFER_SIZE = 1024 * 1024;
+
+}
+
+HuffmanCompressDevice::HuffmanCompressDevice(QIODevice* device, const CodecOptions& options, QObject* parent)
+    : QIODevice(parent)
+    , device_{device}
+    , encoder_{options}
+    , buffer_(DEVICE_BUFFER_SIZE, '\0')
+{}
+
+HuffmanCompressDevice::~HuffmanCompressDevice() { close(); }
+
+bool HuffmanCompressDevice::open(OpenMode mode)
+{
+    if(mode.testFlag(ReadOnly) || !mode.testFlag(WriteOnly)) {
+        setErrorString("HuffmanCompressDevice is write only");
+        return false;
+    }
+    if(device_ == nullptr || !device_->isWritable()) {
+        setErrorString("Device is not open for writing");
+        return false;
+    }
+    return QIODevice::open(mode);
+}
+
+void HuffmanCompressDevice::close()
+{
+    if(isOpen()) {
+        encode(nullptr, 0, StreamFlush::Finish);
+    }
+    QIODevice::close();
+}
+
+bool HuffmanCompressDevice::flush() { return isOpen() && encode(nullptr, 0, StreamFlush::Flush); }
+
+qint64 HuffmanCompressDevice::readData(char*, qint64) { return -1; }
+
+qint64 HuffmanCompressDevice::writeData(const char* data, qint64 size)
+{
+    return encode(data, size, StreamFlush::None) ? size : -1;
+}
+
+bool HuffmanCompressDevice::encode(const char* data, qint64 size, StreamFlush flush)
+{
+    StreamBuffers buffers;
+    buffers.nextIn = reinterpret_cast<const std::uint8_t*>(data);
+    buffers.availIn = static_cast<std::size_t>(size);
+    try {
+        while(true) {
+            buffers.nextOut = reinterpret_cast<std::uint8_t*>(buffer_.data());
+            buffers.availOut = static_cast<std::size_t>(buffer_.size());
+            const auto status = encoder_.encode(buffers, flush);
+
+            const auto count = buffer_.size() - static_cast<qint64>(buffers.availOut);
+            if(count > 0 && device_->write(buffer_.constData(), count) != count) {
+                setErrorString(device_->errorString());
+                return false;
+            }
+            // the output isn't full - all is done
+            if(status == StreamStatus::StreamEnd || (buffers.availIn == 0 && buffers.availOut > 0)) {
+                return true;
+            }
+        }
+    }
+    catch(const std::exception& exc) {
+        setErrorString(QString::fromStdString(exc.what()));
+        return false;
+    }
+}
+
+
+HuffmanDecompressDevice::HuffmanDecompressDevice(QIODevice* device, const QString& referencesDirectory, QObject* parent)
+    : QIODevice(parent)
+    , device_{device}
+    , decoder_{referencesDirectory.toStdString()}
+    , buffer_(DEVICE_BUFFER_SIZE, '\0')
+{
+    if(device_ != nullptr) {
+        QObject::connect(device_, &QIODevice::readyRead, this, &QIODevice::readyRead);
+    }
+}
+
+bool HuffmanDecompressDevice::open(OpenMode mode)
+{
+    if(mode.testFlag(WriteOnly) || !mode.testFlag(ReadOnly)) {
+        setErrorString("HuffmanDecompressDevice is read only");
+        return false;
+    }
+    if(device_ == nullptr || !device_->isReadable()) {
+        setErrorString("Device is not open for reading");
+        return false;
+    }
+    return QIODevice::open(mode);
+}
+
+bool HuffmanDecompressDevice::atEnd() const { return finished_ && QIODevice::bytesAvailable() == 0; }
+
+qint64 HuffmanDecompressDevice::readData(char* data, qint64 maxSize)
+{
+    StreamBuffers buffers;
+    buffers.nextOut = reinterpret_cast<std::uint8_t*>(data);
+    buffers.availOut = static_cast<std::size_t>(maxSize);
+    try {
+        while(buffers.availOut > 0 && !finished_) {
+            if(bufferFirst_ == bufferSize_) {
+                const auto count = device_->read(buffer_.data(), buffer_.size());
+                if(count < 0) {
+                    setErrorString("Unexpected end of compressed data");
+                    return -1;
+                }
+                if(count == 0) {
+                    break; // nothing more yet
+                }
+                bufferFirst_ = 0;
+                bufferSize_ = count;
+            }
+
+            buffers.nextIn = reinterpret_cast<const std::uint8_t*>(buffer_.constData() + bufferFirst_);
+            buffers.availIn = static_cast<std::size_t>(bufferSize_ - bufferFirst_);
+            finished_ = (decoder_.decode(buffers) == StreamStatus::StreamEnd);
+            bufferFirst_ = bufferSize_ - static_cast<qint64>(buffers.availIn);
+        }
+    }
+    catch(const std::exception& exc) {
+        setErrorString(QString::fromStdString(exc.what()));
+        return -1;
+    }
+
+    const auto count = maxSize - static_cast<qint64>(buffers.availOut);
+    if(count == 0 && finished_) {
+        return -1;
+    }
+    if(count == 0 && !device_->isSequential() && device_->atEnd()) {
+        setErrorString("Unexpected end of compressed data");
+        return -1;
+    }
+    return count;
+}
+
+qint64 HuffmanDecompressDevice::writeData(const char*, qint64) { return -1; }
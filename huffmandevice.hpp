@@ -0,0 +1,76 @@
+#ifndef HUFFMANDEVICE_HPP
+#define HUFFMANDEVICE_HPP
+
+#include "streamcodec.hpp"
+
+#include <QIODevice>
+#include <QByteArray>
+
+
+// QIODevice adapters over StreamEncoder/StreamDecoder: data goes through the codec on its way
+// to or from any device (QFile, QLocalSocket, QBuffer...) without temporary files.
+// The wrapped device is opened and owned by the caller, it has to outlive the adapter.
+
+// Write only. The data written is compressed to the device, close() finishes the stream
+class HuffmanCompressDevice : public QIODevice
+{
+    Q_OBJECT
+
+public:
+    explicit HuffmanCompressDevice(QIODevice* device, const CodecOptions& options = CodecOptions(), QObject* parent = nullptr);
+
+    HuffmanCompressDevice(const HuffmanCompressDevice&) = delete;
+    HuffmanCompressDevice& operator=(const HuffmanCompressDevice&) = delete;
+
+    ~HuffmanCompressDevice() override;
+
+    bool open(OpenMode mode) override;
+    void close() override;
+    bool isSequential() const override { return true; }
+
+    // encodes the data written so far, so the reader of the device can decompress all of it
+    bool flush();
+
+protected:
+    qint64 readData(char* data, qint64 maxSize) override;
+    qint64 writeData(const char* data, qint64 size) override;
+
+private:
+    bool encode(const char* data, qint64 size, StreamFlush flush);
+
+private:
+    QIODevice* device_ = nullptr;
+    StreamEncoder encoder_;
+    QByteArray buffer_; // encoded data on its way to the device
+};
+
+// Read only. The data of the device is decompressed when read
+class HuffmanDecompressDevice : public QIODevice
+{
+    Q_OBJECT
+
+public:
+    // referenced archives are looked for in referencesDirectory (see dedup.hpp)
+    explicit HuffmanDecompressDevice(QIODevice* device, const QString& referencesDirectory = ".", QObject* parent = nullptr);
+
+    HuffmanDecompressDevice(const HuffmanDecompressDevice&) = delete;
+    HuffmanDecompressDevice& operator=(const HuffmanDecompressDevice&) = delete;
+
+    bool open(OpenMode mode) override;
+    bool isSequential() const override { return true; }
+    bool atEnd() const override;
+
+protected:
+    qint64 readData(char* data, qint64 maxSize) override;
+    qint64 writeData(const char* data, qint64 size) override;
+
+private:
+    QIODevice* device_ = nullptr;
+    StreamDecoder decoder_;
+    QByteArray buffer_; // data read from the device
+    qint64 bufferFirst_ = 0;
+    qint64 bufferSize_ = 0;
+    bool finished_ = false;
+};
+
+#endif // HUFFMANDEVICE_HPP
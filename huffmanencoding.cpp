@@ -1,96 +1,105 @@
 #include "huffmanencoding.hpp"
+#include "blockcodec.hpp"
+#include "bwt.hpp"
+#include "pipeline.hpp"
+#include "paralleldecoder.hpp"
+#include "dedup.hpp"
+#include "memorybudget.hpp"
+#include "autotune.hpp"
+#include "stats.hpp"
+#include "trace.hpp"
 #include "bits_utils.hpp"
 #include "utils.hpp"
 #include "htree.hpp"
 #include "istreambitsiterator.hpp"
-#include "ostreambitsiterator.hpp"
 
 #include <fstream>
-#include <cassert>
 #include <iterator>
+#include <limits>
+#include <memory>
+#include <optional>
 
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
-void write_header(const HTree& tree, std::ostream& outputStream)
-{
-    const auto& dict = tree.huffmanDict();
-
-    // writing header
-    constexpr std::array<std::uint8_t, 4> huffHeader = {'H', 'A', 'F', 'F'};
-    std::copy(std::cbegin(huffHeader), std::cend(huffHeader), std::ostreambuf_iterator<char>(outputStream));
-
-    const auto hasCode = [](const BitsBuffer& bitCode){
-        return !bitCode.empty();
-    };
-
-    // writing count entries
-    const auto countEntries = static_cast<std::uint16_t>(std::count_if(std::cbegin(dict), std::cend(dict), hasCode));
-    write(outputStream, countEntries);
-
-    const auto posOfOffset = outputStream.tellp();
-    outputStream.seekp(posOfOffset + std::ostream::off_type(2));
 
-    // writing entries
-    std::vector<SymbolEntry> entries;
-    entries.reserve(countEntries);
-    for(std::size_t byteIndex = 0; byteIndex < dict.size(); ++byteIndex) {
-        const auto& codeBits = dict.at(byteIndex);
-        assert(codeBits.size() <= std::numeric_limits<std::uint8_t>::max());
+namespace {
 
-        if(codeBits.empty()) {
-            continue;
-        }
-
-        entries.push_back(SymbolEntry{static_cast<std::uint8_t>(byteIndex), static_cast<std::uint8_t>(codeBits.size())});
-    }
+constexpr std::array<std::uint8_t, 4> HUFF_HEADER = {'H', 'A', 'F', 'F'};
+constexpr std::array<std::uint8_t, 4> BLOCKS_HEADER = {'H', 'A', 'F', 'B'};
+constexpr std::size_t STORED_COPY_BUFFER_SIZE = 64 * 1024;
 
-    outputStream.write(reinterpret_cast<const char*>(entries.data()), std::streamsize(sizeof(SymbolEntry) * entries.size()));
+std::uint64_t bits_to_bytes(std::uint64_t countBits) { return (countBits + BITS_IN_BYTE - 1) / BITS_IN_BYTE; }
 
-    // writing bits
-    OstreamBitsIterator outIt(outputStream);
-    for(const auto& bitCode : dict) {
-        std::copy(std::cbegin(bitCode), std::cend(bitCode), outIt);
-    }
-
-    if(outIt.currentBit() > 0) {
-        outIt.flush();
+// the reference is used only if it is smaller than the data
+bool make_reference(PipelineBlock& block, const ChunkLocation& location)
+{
+    write_reference(block.digest, location, block.output);
+    if(block.output.size() >= block.input.size()) {
+        return false;
     }
 
-    const auto dataOffset = outputStream.tellp();
-    outputStream.clear();
-    outputStream.seekp(posOfOffset);
+    block.parts.clear();
+    block.header.type = BlockType::Reference;
+    block.header.rawSize = static_cast<std::uint32_t>(block.input.size());
+    block.header.packedSize = static_cast<std::uint32_t>(block.output.size());
+    block.header.checksum = block_checksum(block.input);
+    return true;
+}
 
-    const auto offset = static_cast<std::uint16_t>(dataOffset);
-    write(outputStream, offset);
+}
 
-    outputStream.clear();
-    outputStream.seekp(dataOffset);
+BlockHeader encode_part(const std::uint8_t* data, std::size_t size, BytesBuffer& output, const CodecOptions& options)
+{
+    BlockHeader header;
+    header.type = encode_block(data, size, output, options.level, options.transform);
+    header.rawSize = static_cast<std::uint32_t>(size);
+    header.packedSize = static_cast<std::uint32_t>(header.type == BlockType::Stored ? size : output.size());
+    header.checksum = block_checksum(data, size);
+    return header;
 }
 
-void compress_data(const HTree& tree, std::istream& inputStream, std::ostream& outputStream)
+std::uint64_t dict_size(const HTree& tree)
 {
-    inputStream.unsetf(std::ios::skipws);
-    outputStream.unsetf(std::ios::skipws);
+    std::uint64_t countEntries = 0;
+    std::uint64_t countCodeBits = 0;
+    for(const auto& bitCode : tree.huffmanDict()) {
+        if(!bitCode.empty()) {
+            ++countEntries;
+            countCodeBits += bitCode.size();
+        }
+    }
 
-    const auto pos = outputStream.tellp();
-    outputStream.clear();
-    outputStream.seekp(pos + std::ostream::off_type(1));
+    return sizeof(SymbolEntry) * countEntries + bits_to_bytes(countCodeBits);
+}
 
-    OstreamBitsIterator outIt(outputStream);
-    const auto offset = tree.encodeBytes(std::istreambuf_iterator<char>(inputStream), std::istreambuf_iterator<char>(), outIt);
-    if(offset > 0) {
-        outIt.flush();
+void copy_stored_data(std::istream& inputStream, std::ostream& outputStream)
+{
+    std::vector<char> buffer(STORED_COPY_BUFFER_SIZE);
+    while(inputStream) {
+        inputStream.read(buffer.data(), std::streamsize(buffer.size()));
+        const auto countRead = inputStream.gcount();
+        if(countRead <= 0) {
+            break;
+        }
+        outputStream.write(buffer.data(), countRead);
     }
-
-    outputStream.clear();
-    outputStream.seekp(pos);
-    write(outputStream, offset);
 }
 
-void read_header(std::istream& inputStream, HTree& tree)
+HuffmanHeader read_header(std::istream& inputStream, HTree& tree)
 {
     // reading header
     HuffmanHeader header;
     read(inputStream, header);
+    if(!inputStream || !std::equal(std::cbegin(HUFF_HEADER), std::cend(HUFF_HEADER), std::cbegin(header.header))) {
+        throw std::runtime_error{"Invalid file format"};
+    }
+
+    if(is_stored(header)) {
+        return header;
+    }
 
     // reading entries
     std::vector<SymbolEntry> entries(header.count);
@@ -116,6 +125,7 @@ void read_header(std::istream& inputStream, HTree& tree)
     }
 
     tree.setHuffmanDict(dict);
+    return header;
 }
 
 void decompress_data(const HTree& tree, std::istream& inputStream, std::ostream& outputStream)
@@ -130,48 +140,538 @@ void decompress_data(const HTree& tree, std::istream& inputStream, std::ostream&
 }
 
 
-void compress_file(const std::string& from, const std::string& to)
+void decompress_data_parallel(const HTree& tree, std::istream& inputStream, std::ostream& outputStream, unsigned threadsCount,
+                              std::uint64_t memoryBudget)
+{
+    auto* collector = StatsScope::current();
+    if(collector != nullptr) {
+        collector->setMemoryBudget(memoryBudget);
+    }
+    if(memoryBudget != 0) {
+        const auto position = inputStream.tellg();
+        const auto endPosition = inputStream.seekg(0, std::ios::end).tellg();
+        inputStream.seekg(position);
+        const auto bitsCount = static_cast<std::uint64_t>(endPosition - position) * BITS_IN_BYTE;
+        if(position != std::istream::pos_type(-1) && parallel_decode_memory(tree.huffmanDict(), bitsCount) > memoryBudget) {
+            // the stream is decoded as it is read
+            decompress_data(tree, inputStream, outputStream);
+            return;
+        }
+    }
+
+    std::uint8_t offset = 0;
+    BytesBuffer data;
+    {
+        StageTimer timer{Stage::Read};
+        read(inputStream, offset);
+        data.assign(std::istreambuf_iterator<char>(inputStream), std::istreambuf_iterator<char>());
+    }
+
+    const auto totalBits = static_cast<std::uint64_t>(data.size()) * BITS_IN_BYTE;
+    if(offset >= BITS_IN_BYTE || offset > totalBits) {
+        throw std::runtime_error{"Corrupted data offset"};
+    }
+    decode_stream_parallel(tree.huffmanDict(), data.data(), totalBits - offset, outputStream, threadsCount);
+}
+
+BlocksHeader compress_blocks(std::istream& inputStream, std::ostream& outputStream, const CodecOptions& requestedOptions,
+                             ChunkIndex* chunkIndex)
+{
+    const auto plan = plan_compression_memory(requestedOptions, chunkIndex != nullptr);
+    auto options = requestedOptions;
+    options.blockSize = plan.blockSize;
+    options.threadsCount = plan.threadsCount;
+
+    auto blocksHeader = make_blocks_header(options);
+    if(chunkIndex != nullptr) {
+        blocksHeader.flags |= BLOCKS_FLAG_REFERENCES;
+    }
+    const auto posOfHeader = outputStream.tellp();
+    write(outputStream, blocksHeader);
+
+    std::uint64_t originalSize = 0;
+    std::uint64_t payloadSize = 0;
+
+    // the chunks are cut in a buffer of its own, the plain blocks are read as is
+    std::optional<ChunkReader> chunkReader;
+    if(chunkIndex != nullptr) {
+        chunkReader.emplace(inputStream, std::min(options.blockSize, CDC_MAX_SIZE));
+    }
+    const auto readBlock = [&](PipelineBlock& block) {
+        StageTimer timer{Stage::Read};
+        if(chunkReader) {
+            return chunkReader->read(block.input);
+        }
+        block.input.resize(options.blockSize);
+        inputStream.read(reinterpret_cast<char*>(block.input.data()), std::streamsize(block.input.size()));
+        block.input.resize(static_cast<std::size_t>(inputStream.gcount()));
+        return !block.input.empty();
+    };
+
+    const auto encodeBlock = [&options, chunkIndex](PipelineBlock& block) {
+        block.parts.clear();
+        if(chunkIndex != nullptr) {
+            ChunkLocation location;
+            {
+                StageTimer timer{Stage::Dedup};
+                block.digest = sha256(block.input.data(), block.input.size());
+            }
+            if(chunkIndex->find(block.digest, location) && make_reference(block, location)) {
+                return;
+            }
+        }
+
+        // the split estimates order-0 entropy, it says nothing of transformed blocks or chunks
+        const auto split = (options.level == CompressionLevel::Max && options.transform == BlockTransform::None && chunkIndex == nullptr);
+        const auto parts = split ? split_block(block.input) : std::vector<std::size_t>{block.input.size()};
+        if(parts.size() == 1) {
+            block.header = encode_part(block.input.data(), block.input.size(), block.output, options);
+            return;
+        }
+
+        // parts are serialized here, the writer writes the output as is
+        BytesBuffer payload;
+        block.output.clear();
+        const auto* partData = block.input.data();
+        for(const auto partSize : parts) {
+            const auto header = encode_part(partData, partSize, payload, options);
+            const auto* first = (header.type == BlockType::Stored) ? partData : payload.data();
+            const auto* headerBytes = reinterpret_cast<const std::uint8_t*>(&header);
+            block.output.insert(block.output.end(), headerBytes, headerBytes + sizeof(header));
+            block.output.insert(block.output.end(), first, first + header.packedSize);
+            block.parts.push_back(header);
+            partData += partSize;
+        }
+    };
+
+    auto* collector = StatsScope::current();
+    PipelineBlock reference;
+    const auto writeBlock = [&](const PipelineBlock& encodedBlock) {
+        StageTimer timer{Stage::Write};
+
+        // a chunk repeated within this archive is in the index only after its first block is written
+        const auto* pBlock = &encodedBlock;
+        if(chunkIndex != nullptr && encodedBlock.header.type != BlockType::Reference) {
+            ChunkLocation location;
+            if(chunkIndex->find(encodedBlock.digest, location)) {
+                reference.input = encodedBlock.input;
+                reference.digest = encodedBlock.digest;
+                if(make_reference(reference, location)) {
+                    pBlock = &reference;
+                }
+            }
+            else {
+                chunkIndex->add(encodedBlock.digest, sizeof(BlocksHeader) + payloadSize);
+            }
+        }
+
+        const auto& block = *pBlock;
+        if(chunkIndex != nullptr && block.header.type == BlockType::Reference) {
+            chunkIndex->addReference(block.digest);
+        }
+        if(block.parts.empty()) {
+            const auto& payload = (block.header.type == BlockType::Stored) ? block.input : block.output;
+            write(outputStream, block.header);
+            outputStream.write(reinterpret_cast<const char*>(payload.data()), std::streamsize(payload.size()));
+        }
+        else {
+            outputStream.write(reinterpret_cast<const char*>(block.output.data()), std::streamsize(block.output.size()));
+        }
+        if(!outputStream) {
+            throw std::runtime_error{"Unable to write compressed data"};
+        }
+
+        const auto countBlock = [&](const BlockHeader& header) {
+            originalSize += header.rawSize;
+            payloadSize += sizeof(BlockHeader) + header.packedSize;
+            if(collector != nullptr) {
+                collector->addBlock(header.type == BlockType::Stored, header.type == BlockType::Reference);
+            }
+        };
+        if(block.parts.empty()) {
+            countBlock(block.header);
+        }
+        for(const auto& header : block.parts) {
+            countBlock(header);
+        }
+    };
+
+    const auto buffersSize = Pipeline(plan.threadsCount, plan.blocksCount, plan.blockSize).run(readBlock, encodeBlock, writeBlock);
+    if(collector != nullptr) {
+        collector->setMemoryBudget(options.memoryBudget);
+        collector->setEstimatedMemory(buffersSize + plan.scratchSize);
+    }
+
+    blocksHeader.originalSize = originalSize;
+    blocksHeader.payloadSize = payloadSize;
+
+    // sizes are known only at the end, back-patching them if the stream allows it
+    if(posOfHeader != std::ostream::pos_type(-1)) {
+        const auto posOfEnd = outputStream.tellp();
+        outputStream.seekp(posOfHeader);
+        write(outputStream, blocksHeader);
+        outputStream.seekp(posOfEnd);
+    }
+
+    return blocksHeader;
+}
+
+BlocksHeader make_blocks_header(const CodecOptions& options)
+{
+    if(options.blockSize == 0 || options.blockSize > std::numeric_limits<std::uint32_t>::max()) {
+        throw std::invalid_argument{"Invalid block size: " + std::to_string(options.blockSize)};
+    }
+    if(options.transform == BlockTransform::Bwt && options.blockSize > BWT_MAX_SIZE) {
+        throw std::invalid_argument{"Invalid block size for BWT: " + std::to_string(options.blockSize)};
+    }
+
+    BlocksHeader blocksHeader;
+    std::copy(std::cbegin(BLOCKS_HEADER), std::cend(BLOCKS_HEADER), std::begin(blocksHeader.header));
+    blocksHeader.blockSize = static_cast<std::uint32_t>(options.blockSize);
+    if(options.transform == BlockTransform::Bwt) {
+        blocksHeader.flags |= BLOCKS_FLAG_BWT;
+    }
+    if(options.transform == BlockTransform::Lz77) {
+        blocksHeader.flags |= BLOCKS_FLAG_LZ77;
+    }
+    if(options.transform == BlockTransform::Words) {
+        blocksHeader.flags |= BLOCKS_FLAG_WORDS;
+    }
+    return blocksHeader;
+}
+
+void check_blocks_header(const BlocksHeader& blocksHeader)
+{
+    if(!std::equal(std::cbegin(BLOCKS_HEADER), std::cend(BLOCKS_HEADER), std::cbegin(blocksHeader.header))) {
+        throw std::runtime_error{"Invalid file format"};
+    }
+    if(blocksHeader.version != BLOCKS_FORMAT_VERSION) {
+        throw std::runtime_error{"Unsupported format version: " + std::to_string(blocksHeader.version)};
+    }
+}
+
+BlocksHeader read_blocks_header(std::istream& inputStream)
+{
+    BlocksHeader blocksHeader;
+    read(inputStream, blocksHeader);
+    if(!inputStream) {
+        throw std::runtime_error{"Invalid file format"};
+    }
+    check_blocks_header(blocksHeader);
+    return blocksHeader;
+}
+
+BlocksHeader decode_blocks(std::istream& inputStream, const CodecOptions& options, const std::string& referencesDirectory,
+                           const Pipeline::ProcessStage& process, const Pipeline::WriteStage& consume)
+{
+    const auto blocksHeader = read_blocks_header(inputStream);
+
+    std::uint64_t originalSize = 0;
+    std::uint64_t payloadSize = 0;
+
+    const auto readBlock = [&](PipelineBlock& block) {
+        StageTimer timer{Stage::Read};
+        if(payloadSize == blocksHeader.payloadSize) {
+            return false;
+        }
+
+        read(inputStream, block.header);
+        if(inputStream.gcount() == 0 && blocksHeader.payloadSize == UNKNOWN_SIZE) {
+            return false;
+        }
+        if(!inputStream || block.header.rawSize > blocksHeader.blockSize || block.header.packedSize > block.header.rawSize) {
+            throw std::runtime_error{"Corrupted block header"};
+        }
+        if(is_end_mark(block.header)) {
+            payloadSize += sizeof(BlockHeader);
+            return false;
+        }
+
+        block.input.resize(block.header.packedSize);
+        inputStream.read(reinterpret_cast<char*>(block.input.data()), std::streamsize(block.input.size()));
+        if(!inputStream) {
+            throw std::runtime_error{"Unexpected end of file"};
+        }
+
+        payloadSize += sizeof(BlockHeader) + block.input.size();
+        return true;
+    };
+
+    const auto decodeBlock = [&](PipelineBlock& block) {
+        if(block.header.type == BlockType::Reference) {
+            decode_reference(block.header, block.input, referencesDirectory, block.output);
+        }
+        else {
+            decode_block(block.header, block.input, block.output);
+        }
+        if(process) {
+            process(block);
+        }
+    };
+
+    auto* collector = StatsScope::current();
+    const auto writeBlock = [&](const PipelineBlock& block) {
+        consume(block);
+        originalSize += block.output.size();
+        if(collector != nullptr) {
+            collector->addBlock(block.header.type == BlockType::Stored, block.header.type == BlockType::Reference);
+        }
+    };
+
+    const auto plan = plan_decompression_memory(options, blocksHeader);
+    const auto buffersSize = Pipeline(plan.threadsCount, plan.blocksCount, plan.blockSize).run(readBlock, decodeBlock, writeBlock);
+    if(collector != nullptr) {
+        collector->setMemoryBudget(options.memoryBudget);
+        collector->setEstimatedMemory(buffersSize + plan.scratchSize);
+    }
+
+    if(blocksHeader.originalSize != UNKNOWN_SIZE && originalSize != blocksHeader.originalSize) {
+        throw std::runtime_error{"Size of decompressed data doesn't match the header"};
+    }
+
+    auto result = blocksHeader;
+    result.originalSize = originalSize;
+    result.payloadSize = payloadSize;
+    return result;
+}
+
+BlocksHeader decompress_blocks(std::istream& inputStream, std::ostream& outputStream, const CodecOptions& options,
+                               const std::string& referencesDirectory)
+{
+    const auto writeBlock = [&outputStream](const PipelineBlock& block) {
+        StageTimer timer{Stage::Write};
+        outputStream.write(reinterpret_cast<const char*>(block.output.data()), std::streamsize(block.output.size()));
+        if(!outputStream) {
+            throw std::runtime_error{"Unable to write decompressed data"};
+        }
+    };
+    return decode_blocks(inputStream, options, referencesDirectory, nullptr, writeBlock);
+}
+
+bool is_blocks_file(const std::string& path)
+{
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    if(!file) {
+        throw std::runtime_error{"Unable to open file: \"" + path + "\" to read"};
+    }
+
+    std::array<std::uint8_t, 4> magic{};
+    read(file, magic);
+    return magic == BLOCKS_HEADER;
+}
+
+
+namespace {
+
+bool use_io_uring(const CodecOptions& options)
+{
+#ifdef HUFFMAN_HAS_IO_URING
+    static const bool supported = io_uring_supported();
+    return options.ioBackend == IoBackend::IoUring && supported;
+#else
+    (void)options;
+    return false;
+#endif
+}
+
+// writes final header to the file which was written by not seekable stream
+void patch_blocks_header(const std::string& to, const BlocksHeader& blocksHeader)
+{
+    std::fstream to_file(to, std::ios::in | std::ios::out | std::ios::binary);
+    write(to_file, blocksHeader);
+    if(!to_file) {
+        throw std::runtime_error{"Unable to write header to file: \"" + to + "\""};
+    }
+}
+
+// reserves disk space for the output, so it is not fragmented (best effort)
+void preallocate_file(const std::string& path, std::uint64_t size)
+{
+#ifdef __linux__
+    if(size == 0 || size == UNKNOWN_SIZE) {
+        return;
+    }
+
+    const int fd = ::open(path.c_str(), O_WRONLY);
+    if(fd >= 0) {
+        (void)fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(size));
+        ::close(fd);
+    }
+#else
+    (void)path;
+    (void)size;
+#endif
+}
+
+BlocksHeader file_blocks_header(const std::string& from)
+{
+    std::ifstream from_file(from, std::ios::in | std::ios::binary);
+    return read_blocks_header(from_file);
+}
+
+CodecStats compress_file_impl(const std::string& from, const std::string& to, const CodecOptions& options, StatsCollector& collector,
+                              ChunkIndex* chunkIndex)
 {
+#ifdef HUFFMAN_HAS_IO_URING
+    if(use_io_uring(options)) {
+        IoUringInputBuf fromBuf(from, options.ioUring);
+        std::istream from_stream(&fromBuf);
+        from_stream.exceptions(std::ios::badbit);
+
+        IoUringOutputBuf toBuf(to, options.ioUring);
+        std::ostream to_stream(&toBuf);
+        to_stream.exceptions(std::ios::badbit);
+
+        const auto blocksHeader = compress_blocks(from_stream, to_stream, options, chunkIndex);
+        {
+            StageTimer timer{Stage::Write};
+            toBuf.close();
+            patch_blocks_header(to, blocksHeader);
+        }
+        return collector.finish(blocksHeader.originalSize, sizeof(BlocksHeader) + blocksHeader.payloadSize);
+    }
+#endif
+
     std::ifstream from_file(from, std::ios::in | std::ios::binary);
-    from_file.unsetf(std::ios::skipws);
     if(!from_file) {
         throw std::runtime_error{"Unable to open file: \"" + from + "\" to read"};
     }
 
-    HTree tree;
-    tree.setData(std::istreambuf_iterator<char>(from_file), std::istreambuf_iterator<char>());
-
     std::ofstream to_file(to, std::ios::out | std::ios::binary);
-    to_file.unsetf(std::ios::skipws);
     if(!to_file) {
         throw std::runtime_error{"Unable to open file: \"" + to + "\" to write"};
     }
-    write_header(tree, to_file);
-    from_file.clear();
-    from_file.seekg(0);
 
-    compress_data(tree, from_file, to_file);
-    from_file.close();
-    to_file.close();
+    const auto blocksHeader = compress_blocks(from_file, to_file, options, chunkIndex);
+    {
+        StageTimer timer{Stage::Write};
+        to_file.close();
+    }
+    return collector.finish(blocksHeader.originalSize, sizeof(BlocksHeader) + blocksHeader.payloadSize);
 }
 
-void decompress_file(const std::string& from, const std::string& to)
+CodecStats decompress_file_impl(const std::string& from, const std::string& to, const CodecOptions& options, StatsCollector& collector)
 {
+    collector.setDecompression(true);
+
+    const bool isBlocksFile = is_blocks_file(from);
+    std::uint64_t originalSize = UNKNOWN_SIZE;
+    if(isBlocksFile) {
+        // a too small budget is reported before the output file is created
+        const auto blocksHeader = file_blocks_header(from);
+        plan_decompression_memory(options, blocksHeader);
+        originalSize = blocksHeader.originalSize;
+    }
+
+#ifdef HUFFMAN_HAS_IO_URING
+    if(isBlocksFile && use_io_uring(options)) {
+        IoUringInputBuf fromBuf(from, options.ioUring);
+        std::istream from_stream(&fromBuf);
+        from_stream.exceptions(std::ios::badbit);
+
+        IoUringOutputBuf toBuf(to, options.ioUring);
+        std::ostream to_stream(&toBuf);
+        to_stream.exceptions(std::ios::badbit);
+        preallocate_file(to, originalSize);
+
+        const auto blocksHeader = decompress_blocks(from_stream, to_stream, options, directory_of(from));
+        {
+            StageTimer timer{Stage::Write};
+            toBuf.close();
+        }
+        return collector.finish(sizeof(BlocksHeader) + blocksHeader.payloadSize, blocksHeader.originalSize);
+    }
+#endif
+
     std::ifstream from_huffman_file(from, std::ios::in | std::ios::binary);
     from_huffman_file.unsetf(std::ios::skipws);
     if(!from_huffman_file) {
         throw std::runtime_error{"Unable to open file: \"" + from + "\" to read"};
     }
 
-    HTree tree;
-    read_header(from_huffman_file, tree);
-
     std::ofstream to_file(to, std::ios::out | std::ios::binary);
     to_file.unsetf(std::ios::skipws);
     if(!to_file) {
         throw std::runtime_error{"Unable to open file: \"" + to + "\" to write"};
     }
-    decompress_data(tree, from_huffman_file, to_file);
-    from_huffman_file.close();
-    to_file.close();
+
+    if(isBlocksFile) {
+        preallocate_file(to, originalSize);
+        const auto blocksHeader = decompress_blocks(from_huffman_file, to_file, options, directory_of(from));
+        {
+            StageTimer timer{Stage::Write};
+            to_file.close();
+        }
+        return collector.finish(sizeof(BlocksHeader) + blocksHeader.payloadSize, blocksHeader.originalSize);
+    }
+
+    HTree tree;
+    const auto header = read_header(from_huffman_file, tree);
+    if(is_stored(header)) {
+        copy_stored_data(from_huffman_file, to_file);
+    }
+    else {
+        decompress_data_parallel(tree, from_huffman_file, to_file, options.threadsCount, options.memoryBudget);
+    }
+
+    from_huffman_file.clear();
+    const auto bytesIn = static_cast<std::uint64_t>(from_huffman_file.seekg(0, std::ios::end).tellg());
+    const auto bytesOut = static_cast<std::uint64_t>(to_file.tellp());
+    return collector.finish(bytesIn, bytesOut);
+}
+
+}
+
+CodecStats compress_file(const std::string& from, const std::string& to, const CodecOptions& options)
+{
+    StatsCollector collector;
+    StatsScope statsScope{&collector};
+
+    TraceRecorder recorder;
+    if(!options.tracePath.empty()) {
+        collector.setTraceRecorder(&recorder);
+    }
+
+    CodecOptions tunedOptions = options;
+    if(options.tuneGoal != TuneGoal::None) {
+        const auto tuning = auto_tune(from, options);
+        tunedOptions = tuning.options;
+        collector.setTuning(format_tuning(tuning));
+    }
+
+    // a too small budget is reported before the output file is created
+    plan_compression_memory(tunedOptions, !options.dedupIndex.empty());
+
+    // the index is saved only if the archive is written
+    std::unique_ptr<ChunkIndex> chunkIndex;
+    if(!options.dedupIndex.empty()) {
+        chunkIndex = std::make_unique<ChunkIndex>(options.dedupIndex);
+        chunkIndex->setArchive(file_name(to));
+    }
+
+    const auto stats = compress_file_impl(from, to, tunedOptions, collector, chunkIndex.get());
+    if(chunkIndex != nullptr) {
+        chunkIndex->save();
+    }
+    if(!options.tracePath.empty()) {
+        recorder.save(options.tracePath);
+    }
+    return stats;
+}
+
+CodecStats decompress_file(const std::string& from, const std::string& to, const CodecOptions& options)
+{
+    StatsCollector collector;
+    StatsScope statsScope{&collector};
+
+    TraceRecorder recorder;
+    if(!options.tracePath.empty()) {
+        collector.setTraceRecorder(&recorder);
+    }
+
+    const auto stats = decompress_file_impl(from, to, options, collector);
+    if(!options.tracePath.empty()) {
+        recorder.save(options.tracePath);
+    }
+    return stats;
 }
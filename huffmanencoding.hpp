@@ -1,6 +1,12 @@
 #ifndef HUFFMANENCODING_HPP
 #define HUFFMANENCODING_HPP
 
+#include "globalconstants.hpp"
+#include "blockcodec.hpp"
+#include "iouring.hpp"
+#include "pipeline.hpp"
+#include "stats.hpp"
+
 #include <iostream>
 
 
@@ -8,10 +14,12 @@ static_assert (sizeof(char) == sizeof(std::uint8_t), "");
 
 struct HuffmanHeader {
     std::uint8_t header[4]{'\0'}; // заголовок "HAFF"
-    std::uint16_t count = 0;      // кол-во записей SymbolEntry
+    std::uint16_t count = 0;      // кол-во записей SymbolEntry (0 - данные хранятся без сжатия)
     std::uint16_t offset = 0;     // оффсет до data
 };
 
+inline bool is_stored(const HuffmanHeader& header) { return header.count == 0; }
+
 struct SymbolEntry {
     std::uint8_t symbol = 0;    // символ (байт)
     std::uint8_t count = 0;     // кол-во бит кода символа
@@ -21,15 +29,76 @@ struct SymbolEntry {
 // std::uint8_t offset; // (кол-во незначащих бит с конца данных)
 // BitsBuffer           // биты данных
 
+// Stored data (count == 0)
+// std::uint8_t[]       // исходные байты без изменений
+
 class HTree;
 
-void write_header(const HTree& tree, std::ostream& outputStream);
-void compress_data(const HTree& tree, std::istream& inputStream, std::ostream& outputStream);
+// exact size in bytes of the SymbolEntry records and codes bits of the tree
+std::uint64_t dict_size(const HTree& tree);
+
+// the files of a single stream are only read, compress_file writes blocks
+void copy_stored_data(std::istream& inputStream, std::ostream& outputStream);
 
-void read_header(std::istream& inputStream, HTree& tree);
+HuffmanHeader read_header(std::istream& inputStream, HTree& tree);
 void decompress_data(const HTree& tree, std::istream& inputStream, std::ostream& outputStream);
+// the same, the data is read to memory and decoded by threadsCount threads (0 - by the number of cores),
+// see decode_stream_parallel; if that would take more than memoryBudget (not 0) - decompress_data
+void decompress_data_parallel(const HTree& tree, std::istream& inputStream, std::ostream& outputStream, unsigned threadsCount = 0,
+                              std::uint64_t memoryBudget = 0);
+
+enum class IoBackend {
+    Streams,  // std::ifstream/std::ofstream
+    IoUring   // асинхронный io_uring (Linux), иначе Streams
+};
+
+enum class TuneGoal {
+    None,  // параметры как заданы
+    Speed, // наибольшая скорость
+    Ratio  // наилучшее сжатие при скорости не ниже tuneMinSpeed
+};
+
+struct CodecOptions {
+    std::size_t blockSize = DEFAULT_BLOCK_SIZE;
+    CompressionLevel level = CompressionLevel::Default;
+    BlockTransform transform = BlockTransform::None;
+    unsigned threadsCount = 0;      // 0 - по кол-ву ядер
+    IoBackend ioBackend = IoBackend::Streams;
+    IoUringOptions ioUring;
+    std::string tracePath;          // Chrome Trace Event JSON, пусто - без трассировки
+    std::string dedupIndex;         // индекс фрагментов для дедупликации (dedup.hpp), пусто - без неё
+    std::uint64_t memoryBudget = 0; // предел рабочей памяти в байтах (memorybudget.hpp), 0 - без предела
+    TuneGoal tuneGoal = TuneGoal::None; // автонастройка блоков, уровня и преобразования (autotune.hpp)
+    double tuneMinSpeed = 0.0;      // МБ/с для TuneGoal::Ratio, 0 - любая
+};
+
+class ChunkIndex;
+
+// a block (or a part of the split one) of the blocks format, the payload of a stored block is the data itself
+BlockHeader encode_part(const std::uint8_t* data, std::size_t size, BytesBuffer& output, const CodecOptions& options);
+// throws if the block size is out of range
+BlocksHeader make_blocks_header(const CodecOptions& options);
+void check_blocks_header(const BlocksHeader& blocksHeader);
+
+// blocks format (see blockcodec.hpp), processed by the reader -> encoders/decoders -> writer pipeline
+// sizes in the header are back-patched if outputStream is seekable, the final header is returned;
+// with chunkIndex blocks are content defined chunks, the ones in the index become references (see dedup.hpp)
+BlocksHeader compress_blocks(std::istream& inputStream, std::ostream& outputStream, const CodecOptions& options = CodecOptions(),
+                             ChunkIndex* chunkIndex = nullptr);
+BlocksHeader read_blocks_header(std::istream& inputStream);
+// returns the header with actually read sizes, referenced archives are looked for in referencesDirectory
+BlocksHeader decompress_blocks(std::istream& inputStream, std::ostream& outputStream, const CodecOptions& options = CodecOptions(),
+                               const std::string& referencesDirectory = ".");
+// the pipeline of decompress_blocks without the output: process (may be empty) runs on the workers
+// after a block is decoded to block.output, consume gets the decoded blocks in order
+BlocksHeader decode_blocks(std::istream& inputStream, const CodecOptions& options, const std::string& referencesDirectory,
+                           const Pipeline::ProcessStage& process, const Pipeline::WriteStage& consume);
+bool is_blocks_file(const std::string& path);
 
-void compress_file(const std::string& from, const std::string& to);
-void decompress_file(const std::string& from, const std::string& to);
+// with options.dedupIndex the index is updated after the archive is written,
+// with options.tuneGoal the settings are chosen by auto_tune on a sample of the file first
+CodecStats compress_file(const std::string& from, const std::string& to, const CodecOptions& options = CodecOptions());
+// accepts both single stream ("HAFF") and blocks ("HAFB") files
+CodecStats decompress_file(const std::string& from, const std::string& to, const CodecOptions& options = CodecOptions());
 
 #endif // HUFFMANENCODING_HPP
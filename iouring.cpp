@@ -0,0 +1,495 @@
+#include "iouring.hpp"
+
+#ifdef HUFFMAN_HAS_IO_URING
+
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <system_error>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <cassert>
+
+
+namespace {
+
+constexpr std::size_t DIRECT_IO_ALIGNMENT = 4096;
+
+[[noreturn]] void throw_errno(int error, const std::string& what) { throw std::system_error{error, std::generic_category(), what}; }
+
+template<typename T>
+T* ring_ptr(void* ring, unsigned offset) { return reinterpret_cast<T*>(static_cast<std::uint8_t*>(ring) + offset); }
+
+unsigned load_acquire(const unsigned* ptr) { return __atomic_load_n(ptr, __ATOMIC_ACQUIRE); }
+void store_release(unsigned* ptr, unsigned value) { __atomic_store_n(ptr, value, __ATOMIC_RELEASE); }
+
+std::size_t align_up(std::size_t value, std::size_t alignment) { return (value + alignment - 1) / alignment * alignment; }
+
+AlignedBufferPtr make_aligned_buffer(std::size_t size)
+{
+    void* ptr = nullptr;
+    if(posix_memalign(&ptr, DIRECT_IO_ALIGNMENT, size) != 0) {
+        throw std::bad_alloc{};
+    }
+    return AlignedBufferPtr{static_cast<std::uint8_t*>(ptr)};
+}
+
+int open_file(const std::string& path, int flags, bool& directIo)
+{
+    if(directIo) {
+        const int fd = ::open(path.c_str(), flags | O_DIRECT, 0644);
+        if(fd >= 0) {
+            return fd;
+        }
+        if(errno != EINVAL) {
+            throw_errno(errno, "Unable to open file: \"" + path + "\"");
+        }
+        directIo = false; // file system doesn't support O_DIRECT
+    }
+
+    const int fd = ::open(path.c_str(), flags, 0644);
+    if(fd < 0) {
+        throw_errno(errno, "Unable to open file: \"" + path + "\"");
+    }
+    return fd;
+}
+
+std::unique_ptr<IoUring> make_ring(const IoUringOptions& options, std::vector<std::pair<void*, std::size_t>> buffers)
+{
+    auto ring = std::make_unique<IoUring>(options.queueDepth);
+    if(options.registeredBuffers) {
+        ring->registerBuffers(buffers);
+    }
+    return ring;
+}
+
+}
+
+void AlignedFree::operator()(void* ptr) const { std::free(ptr); }
+
+bool io_uring_supported()
+{
+    io_uring_params params{};
+    const auto fd = static_cast<int>(syscall(__NR_io_uring_setup, 1, &params));
+    if(fd < 0) {
+        return false;
+    }
+    ::close(fd);
+    return true;
+}
+
+
+IoUring::IoUring(unsigned entries)
+{
+    io_uring_params params{};
+    ringFd_ = static_cast<int>(syscall(__NR_io_uring_setup, std::max(entries, 1u), &params));
+    if(ringFd_ < 0) {
+        throw_errno(errno, "io_uring_setup");
+    }
+
+    sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingSize_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if(singleMmap) {
+        sqRingSize_ = cqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+    }
+
+    sqRing_ = mmap(nullptr, sqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd_, IORING_OFF_SQ_RING);
+    if(sqRing_ == MAP_FAILED) {
+        sqRing_ = nullptr;
+        const int error = errno;
+        ::close(ringFd_);
+        throw_errno(error, "io_uring mmap");
+    }
+
+    cqRing_ = singleMmap ? sqRing_ : mmap(nullptr, cqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd_, IORING_OFF_CQ_RING);
+    sqesSize_ = params.sq_entries * sizeof(io_uring_sqe);
+    sqes_ = mmap(nullptr, sqesSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd_, IORING_OFF_SQES);
+    if(cqRing_ == MAP_FAILED || sqes_ == MAP_FAILED) {
+        const int error = errno;
+        if(cqRing_ != MAP_FAILED && !singleMmap) munmap(cqRing_, cqRingSize_);
+        if(sqes_ != MAP_FAILED) munmap(sqes_, sqesSize_);
+        munmap(sqRing_, sqRingSize_);
+        ::close(ringFd_);
+        throw_errno(error, "io_uring mmap");
+    }
+
+    sqHead_ = ring_ptr<unsigned>(sqRing_, params.sq_off.head);
+    sqTail_ = ring_ptr<unsigned>(sqRing_, params.sq_off.tail);
+    sqArray_ = ring_ptr<unsigned>(sqRing_, params.sq_off.array);
+    sqMask_ = *ring_ptr<unsigned>(sqRing_, params.sq_off.ring_mask);
+    sqEntries_ = params.sq_entries;
+
+    cqHead_ = ring_ptr<unsigned>(cqRing_, params.cq_off.head);
+    cqTail_ = ring_ptr<unsigned>(cqRing_, params.cq_off.tail);
+    cqMask_ = *ring_ptr<unsigned>(cqRing_, params.cq_off.ring_mask);
+    cqes_ = ring_ptr<void>(cqRing_, params.cq_off.cqes);
+}
+
+IoUring::~IoUring()
+{
+    munmap(sqes_, sqesSize_);
+    if(cqRing_ != sqRing_) {
+        munmap(cqRing_, cqRingSize_);
+    }
+    munmap(sqRing_, sqRingSize_);
+    ::close(ringFd_);
+}
+
+bool IoUring::registerBuffers(const std::vector<std::pair<void*, std::size_t>>& buffers)
+{
+    std::vector<iovec> iovecs;
+    iovecs.reserve(buffers.size());
+    for(const auto& buffer : buffers) {
+        iovecs.push_back(iovec{buffer.first, buffer.second});
+    }
+
+    registeredBuffers_ = syscall(__NR_io_uring_register, ringFd_, IORING_REGISTER_BUFFERS, iovecs.data(), static_cast<unsigned>(iovecs.size())) == 0;
+    return registeredBuffers_;
+}
+
+void IoUring::prepareRead(int fd, void* buffer, unsigned size, std::uint64_t offset, std::uint64_t userData, int bufferIndex)
+{
+    const bool fixed = registeredBuffers_ && bufferIndex >= 0;
+    prepare(fixed ? IORING_OP_READ_FIXED : IORING_OP_READ, fd, buffer, size, offset, userData, bufferIndex);
+}
+
+void IoUring::prepareWrite(int fd, const void* buffer, unsigned size, std::uint64_t offset, std::uint64_t userData, int bufferIndex)
+{
+    const bool fixed = registeredBuffers_ && bufferIndex >= 0;
+    prepare(fixed ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE, fd, buffer, size, offset, userData, bufferIndex);
+}
+
+void IoUring::prepare(std::uint8_t opcode, int fd, const void* buffer, unsigned size, std::uint64_t offset, std::uint64_t userData, int bufferIndex)
+{
+    const unsigned tail = *sqTail_;
+    if(tail - load_acquire(sqHead_) >= sqEntries_) {
+        submit();
+    }
+
+    const unsigned index = tail & sqMask_;
+    auto& sqe = static_cast<io_uring_sqe*>(sqes_)[index];
+    std::memset(&sqe, 0, sizeof(sqe));
+    sqe.opcode = opcode;
+    sqe.fd = fd;
+    sqe.addr = reinterpret_cast<std::uint64_t>(buffer);
+    sqe.len = size;
+    sqe.off = offset;
+    sqe.user_data = userData;
+    if(opcode == IORING_OP_READ_FIXED || opcode == IORING_OP_WRITE_FIXED) {
+        sqe.buf_index = static_cast<std::uint16_t>(bufferIndex);
+    }
+
+    sqArray_[index] = index;
+    store_release(sqTail_, tail + 1);
+    ++toSubmit_;
+}
+
+void IoUring::submit()
+{
+    if(toSubmit_ > 0) {
+        enter(toSubmit_, 0);
+    }
+}
+
+IoUringCompletion IoUring::waitCompletion()
+{
+    for(;;) {
+        const unsigned head = *cqHead_;
+        if(head != load_acquire(cqTail_)) {
+            const auto& cqe = static_cast<const io_uring_cqe*>(cqes_)[head & cqMask_];
+            const IoUringCompletion result{cqe.user_data, cqe.res};
+            store_release(cqHead_, head + 1);
+            return result;
+        }
+
+        enter(toSubmit_, 1);
+    }
+}
+
+void IoUring::enter(unsigned toSubmit, unsigned minComplete)
+{
+    const unsigned flags = minComplete > 0 ? IORING_ENTER_GETEVENTS : 0;
+    for(;;) {
+        const auto submitted = syscall(__NR_io_uring_enter, ringFd_, toSubmit, minComplete, flags, nullptr, 0);
+        if(submitted >= 0) {
+            toSubmit_ -= std::min(toSubmit_, static_cast<unsigned>(submitted));
+            return;
+        }
+        if(errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+            throw_errno(errno, "io_uring_enter");
+        }
+    }
+}
+
+
+IoUringInputBuf::IoUringInputBuf(const std::string& path, const IoUringOptions& options)
+    : options_{options}
+{
+    options_.bufferSize = align_up(std::max<std::size_t>(options_.bufferSize, DIRECT_IO_ALIGNMENT), DIRECT_IO_ALIGNMENT);
+    options_.queueDepth = std::max(options_.queueDepth, 1u);
+
+    fd_ = open_file(path, O_RDONLY, options_.directIo);
+
+    struct stat fileStat{};
+    if(fstat(fd_, &fileStat) != 0) {
+        const int error = errno;
+        ::close(fd_);
+        throw_errno(error, "Unable to get size of file: \"" + path + "\"");
+    }
+    fileSize_ = static_cast<std::uint64_t>(fileStat.st_size);
+
+    slots_.resize(options_.queueDepth);
+    std::vector<std::pair<void*, std::size_t>> buffers;
+    for(auto& slot : slots_) {
+        slot.buffer = make_aligned_buffer(options_.bufferSize);
+        buffers.emplace_back(slot.buffer.get(), options_.bufferSize);
+    }
+
+    try { ring_ = make_ring(options_, std::move(buffers)); }
+    catch(...) { ::close(fd_); throw; }
+}
+
+IoUringInputBuf::~IoUringInputBuf()
+{
+    // buffers mustn't be released while kernel writes to them
+    for(std::size_t slotIndex = 0; slotIndex < slots_.size(); ++slotIndex) {
+        try { waitSlot(slotIndex); }
+        catch(...) {}
+    }
+    ::close(fd_);
+}
+
+void IoUringInputBuf::submitRead(std::size_t slotIndex)
+{
+    auto& slot = slots_[slotIndex];
+    slot.offset = nextOffset_;
+    slot.size = static_cast<unsigned>(nextOffset_ < fileSize_ ? std::min<std::uint64_t>(options_.bufferSize, fileSize_ - nextOffset_) : 0);
+    slot.filled = 0;
+    if(slot.size == 0) {
+        return;
+    }
+
+    // the whole buffer is requested, O_DIRECT needs aligned sizes
+    slot.inFlight = true;
+    ring_->prepareRead(fd_, slot.buffer.get(), static_cast<unsigned>(options_.bufferSize), slot.offset, slotIndex, static_cast<int>(slotIndex));
+    nextOffset_ += options_.bufferSize;
+}
+
+void IoUringInputBuf::prepareRest(std::size_t slotIndex)
+{
+    auto& slot = slots_[slotIndex];
+    slot.inFlight = true;
+    ring_->prepareRead(fd_, slot.buffer.get() + slot.filled, static_cast<unsigned>(options_.bufferSize) - slot.filled,
+                       slot.offset + slot.filled, slotIndex, static_cast<int>(slotIndex));
+}
+
+void IoUringInputBuf::handleCompletion(const IoUringCompletion& completion)
+{
+    const auto slotIndex = static_cast<std::size_t>(completion.userData);
+    auto& slot = slots_.at(slotIndex);
+    slot.inFlight = false;
+    if(completion.result < 0) {
+        throw_errno(-completion.result, "io_uring read");
+    }
+    if(completion.result == 0 && slot.filled < slot.size) {
+        throw std::system_error{EIO, std::generic_category(), "io_uring read: the file was truncated while reading"};
+    }
+
+    // a short read is legal, the rest is read from where it stopped
+    slot.filled += static_cast<unsigned>(completion.result);
+    if(slot.filled < slot.size) {
+        prepareRest(slotIndex);
+    }
+}
+
+void IoUringInputBuf::waitSlot(std::size_t slotIndex)
+{
+    while(slots_[slotIndex].inFlight) {
+        ring_->submit();
+        handleCompletion(ring_->waitCompletion());
+    }
+}
+
+IoUringInputBuf::int_type IoUringInputBuf::underflow()
+{
+    if(gptr() < egptr()) {
+        return traits_type::to_int_type(*gptr());
+    }
+
+    if(!started_) {
+        started_ = true;
+        for(std::size_t slotIndex = 0; slotIndex < slots_.size(); ++slotIndex) {
+            submitRead(slotIndex);
+        }
+    }
+    else {
+        // current buffer is consumed - reuse it for the next read ahead
+        submitRead(currSlot_);
+        currSlot_ = (currSlot_ + 1) % slots_.size();
+    }
+
+    waitSlot(currSlot_);
+    const auto& slot = slots_[currSlot_];
+    if(slot.size == 0) {
+        return traits_type::eof();
+    }
+
+    // the file may have grown, only its size at opening is read
+    auto* first = reinterpret_cast<char*>(slot.buffer.get());
+    setg(first, first, first + slot.size);
+    return traits_type::to_int_type(*gptr());
+}
+
+
+IoUringOutputBuf::IoUringOutputBuf(const std::string& path, const IoUringOptions& options)
+    : options_{options}
+{
+    options_.bufferSize = align_up(std::max<std::size_t>(options_.bufferSize, DIRECT_IO_ALIGNMENT), DIRECT_IO_ALIGNMENT);
+    options_.queueDepth = std::max(options_.queueDepth, 1u);
+
+    directIo_ = options_.directIo;
+    fd_ = open_file(path, O_WRONLY | O_CREAT | O_TRUNC, directIo_);
+
+    slots_.resize(options_.queueDepth);
+    std::vector<std::pair<void*, std::size_t>> buffers;
+    for(auto& slot : slots_) {
+        slot.buffer = make_aligned_buffer(options_.bufferSize);
+        buffers.emplace_back(slot.buffer.get(), options_.bufferSize);
+    }
+
+    try { ring_ = make_ring(options_, std::move(buffers)); }
+    catch(...) { ::close(fd_); throw; }
+
+    setPutArea();
+}
+
+IoUringOutputBuf::~IoUringOutputBuf()
+{
+    try { close(); }
+    catch(...) {}
+}
+
+void IoUringOutputBuf::close()
+{
+    if(fd_ < 0) {
+        return;
+    }
+
+    const auto pendingSize = static_cast<std::size_t>(pptr() - pbase());
+    writtenSize_ += pendingSize;
+    if(pendingSize > 0) {
+        auto& slot = slots_[currSlot_];
+        slot.size = static_cast<unsigned>(directIo_ ? align_up(pendingSize, DIRECT_IO_ALIGNMENT) : pendingSize);
+        std::memset(slot.buffer.get() + pendingSize, 0, slot.size - pendingSize);
+        submitCurrent();
+    }
+    setp(nullptr, nullptr);
+
+    const int fd = fd_;
+    fd_ = -1;
+    try {
+        for(std::size_t slotIndex = 0; slotIndex < slots_.size(); ++slotIndex) {
+            waitSlot(slotIndex);
+        }
+
+        // O_DIRECT tail was padded to the alignment
+        if(directIo_ && ftruncate(fd, static_cast<off_t>(writtenSize_)) != 0) {
+            throw_errno(errno, "ftruncate");
+        }
+    }
+    catch(...) {
+        ::close(fd);
+        throw;
+    }
+
+    if(::close(fd) != 0) {
+        throw_errno(errno, "close");
+    }
+}
+
+void IoUringOutputBuf::setPutArea()
+{
+    auto* first = reinterpret_cast<char*>(slots_[currSlot_].buffer.get());
+    setp(first, first + options_.bufferSize);
+}
+
+void IoUringOutputBuf::submitCurrent()
+{
+    auto& slot = slots_[currSlot_];
+    slot.offset = nextOffset_;
+    slot.written = 0;
+    prepareRest(currSlot_);
+    ring_->submit();
+    nextOffset_ += slot.size;
+}
+
+void IoUringOutputBuf::prepareRest(std::size_t slotIndex)
+{
+    auto& slot = slots_[slotIndex];
+    slot.inFlight = true;
+    ring_->prepareWrite(fd_, slot.buffer.get() + slot.written, slot.size - slot.written, slot.offset + slot.written,
+                        slotIndex, static_cast<int>(slotIndex));
+}
+
+void IoUringOutputBuf::handleCompletion(const IoUringCompletion& completion)
+{
+    const auto slotIndex = static_cast<std::size_t>(completion.userData);
+    auto& slot = slots_.at(slotIndex);
+    slot.inFlight = false;
+    if(completion.result < 0) {
+        throw_errno(-completion.result, "io_uring write");
+    }
+    if(completion.result == 0) {
+        // no progress, resubmitting would spin
+        throw std::system_error{EIO, std::generic_category(), "io_uring write wrote nothing"};
+    }
+
+    // a short write is legal, the rest is written from where it stopped
+    slot.written += static_cast<unsigned>(completion.result);
+    if(slot.written < slot.size) {
+        prepareRest(slotIndex);
+    }
+}
+
+void IoUringOutputBuf::waitSlot(std::size_t slotIndex)
+{
+    while(slots_[slotIndex].inFlight) {
+        ring_->submit();
+        handleCompletion(ring_->waitCompletion());
+    }
+}
+
+IoUringOutputBuf::int_type IoUringOutputBuf::overflow(int_type ch)
+{
+    if(fd_ < 0) {
+        return traits_type::eof();
+    }
+
+    slots_[currSlot_].size = static_cast<unsigned>(pptr() - pbase());
+    writtenSize_ += slots_[currSlot_].size;
+    submitCurrent();
+
+    currSlot_ = (currSlot_ + 1) % slots_.size();
+    waitSlot(currSlot_);
+    setPutArea();
+
+    if(!traits_type::eq_int_type(ch, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+    }
+    return traits_type::not_eof(ch);
+}
+
+#else
+
+bool io_uring_supported() { return false; }
+
+#endif // HUFFMAN_HAS_IO_URING
@@ -0,0 +1,162 @@
+#ifndef IOURING_HPP
+#define IOURING_HPP
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define HUFFMAN_HAS_IO_URING 1
+#endif
+#endif
+
+#include <streambuf>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+
+struct IoUringOptions {
+    unsigned queueDepth = 8;                 // кол-во запросов в полёте
+    std::size_t bufferSize = 1024 * 1024;    // размер одного запроса (кратен 4096)
+    bool directIo = false;                   // O_DIRECT, если файловая система поддерживает
+    bool registeredBuffers = false;          // IORING_REGISTER_BUFFERS, если позволяет RLIMIT_MEMLOCK
+};
+
+// true if the kernel accepts io_uring_setup (it may be disabled by sysctl or seccomp)
+bool io_uring_supported();
+
+#ifdef HUFFMAN_HAS_IO_URING
+
+struct IoUringCompletion {
+    std::uint64_t userData = 0;
+    int result = 0;
+};
+
+// Minimal io_uring wrapper over raw syscalls, not thread safe
+class IoUring {
+public:
+    explicit IoUring(unsigned entries);
+    ~IoUring();
+
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+    bool registerBuffers(const std::vector<std::pair<void*, std::size_t>>& buffers);
+    bool hasRegisteredBuffers() const { return registeredBuffers_; }
+
+    // bufferIndex >= 0 - index of registered buffer (READ_FIXED/WRITE_FIXED)
+    void prepareRead(int fd, void* buffer, unsigned size, std::uint64_t offset, std::uint64_t userData, int bufferIndex = -1);
+    void prepareWrite(int fd, const void* buffer, unsigned size, std::uint64_t offset, std::uint64_t userData, int bufferIndex = -1);
+
+    void submit();
+    IoUringCompletion waitCompletion();
+
+private:
+    void prepare(std::uint8_t opcode, int fd, const void* buffer, unsigned size, std::uint64_t offset, std::uint64_t userData, int bufferIndex);
+    void enter(unsigned toSubmit, unsigned minComplete);
+
+private:
+    int ringFd_ = -1;
+    void* sqRing_ = nullptr;
+    void* cqRing_ = nullptr;
+    void* sqes_ = nullptr;
+    std::size_t sqRingSize_ = 0;
+    std::size_t cqRingSize_ = 0;
+    std::size_t sqesSize_ = 0;
+
+    unsigned* sqHead_ = nullptr;
+    unsigned* sqTail_ = nullptr;
+    unsigned* sqArray_ = nullptr;
+    unsigned sqMask_ = 0;
+    unsigned sqEntries_ = 0;
+
+    unsigned* cqHead_ = nullptr;
+    unsigned* cqTail_ = nullptr;
+    unsigned cqMask_ = 0;
+    void* cqes_ = nullptr;
+
+    unsigned toSubmit_ = 0;
+    bool registeredBuffers_ = false;
+};
+
+
+struct AlignedFree { void operator()(void* ptr) const; };
+using AlignedBufferPtr = std::unique_ptr<std::uint8_t, AlignedFree>;
+
+// Sequential file reading with several reads in flight (read ahead).
+// Short reads are resubmitted for the rest of the buffer, only the end of the file before its size at opening is an error.
+// Errors are thrown as std::system_error, so the stream must have badbit in exceptions().
+class IoUringInputBuf : public std::streambuf {
+public:
+    explicit IoUringInputBuf(const std::string& path, const IoUringOptions& options = IoUringOptions());
+    ~IoUringInputBuf() override;
+
+protected:
+    int_type underflow() override;
+
+private:
+    struct Slot {
+        AlignedBufferPtr buffer;
+        std::uint64_t offset = 0;
+        unsigned size = 0;   // 0 - after the end of the file
+        unsigned filled = 0;
+        bool inFlight = false;
+    };
+
+    void submitRead(std::size_t slotIndex);
+    void prepareRest(std::size_t slotIndex);
+    void waitSlot(std::size_t slotIndex);
+    void handleCompletion(const IoUringCompletion& completion);
+
+private:
+    IoUringOptions options_;
+    int fd_ = -1;
+    std::uint64_t fileSize_ = 0;
+    std::uint64_t nextOffset_ = 0;
+    std::vector<Slot> slots_;
+    std::size_t currSlot_ = 0;
+    bool started_ = false;
+    std::unique_ptr<IoUring> ring_;
+};
+
+// Sequential file writing with several writes in flight, short writes are resubmitted for the rest.
+// close() must be called to flush the tail and check for errors.
+class IoUringOutputBuf : public std::streambuf {
+public:
+    explicit IoUringOutputBuf(const std::string& path, const IoUringOptions& options = IoUringOptions());
+    ~IoUringOutputBuf() override;
+
+    void close();
+
+protected:
+    int_type overflow(int_type ch) override;
+
+private:
+    struct Slot {
+        AlignedBufferPtr buffer;
+        std::uint64_t offset = 0;
+        unsigned size = 0;
+        unsigned written = 0;
+        bool inFlight = false;
+    };
+
+    void submitCurrent();
+    void prepareRest(std::size_t slotIndex);
+    void waitSlot(std::size_t slotIndex);
+    void handleCompletion(const IoUringCompletion& completion);
+    void setPutArea();
+
+private:
+    IoUringOptions options_;
+    int fd_ = -1;
+    bool directIo_ = false;
+    std::uint64_t nextOffset_ = 0;
+    std::uint64_t writtenSize_ = 0;
+    std::vector<Slot> slots_;
+    std::size_t currSlot_ = 0;
+    std::unique_ptr<IoUring> ring_;
+};
+
+#endif // HUFFMAN_HAS_IO_URING
+
+#endif // IOURING_HPP
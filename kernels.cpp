@@ -0,0 +1,201 @@
+#include "kernels.hpp"
+
+#include <array>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+
+#if HUFFMAN_HAS_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+
+namespace {
+
+CpuFeatures detect_cpu_features()
+{
+    CpuFeatures features;
+
+    // the portable kernels can be forced to check them against the specific ones
+    if(std::getenv("HUFFMAN_PORTABLE_KERNELS") != nullptr) {
+        return features;
+    }
+
+#if HUFFMAN_HAS_X86_KERNELS
+    __builtin_cpu_init();
+    features.sse42 = __builtin_cpu_supports("sse4.2");
+    features.avx2 = __builtin_cpu_supports("avx2");
+    features.avx512bw = __builtin_cpu_supports("avx512bw");
+    features.bmi2 = __builtin_cpu_supports("bmi2");
+#endif
+    return features;
+}
+
+template<class Function>
+Kernel<Function> select_kernel(const std::vector<Kernel<Function>>& variants)
+{
+    const auto it = std::find_if(variants.rbegin(), variants.rend(), [](const auto& variant){ return variant.supported; });
+    return *it;
+}
+
+// histogram
+
+void histogram_portable(const std::uint8_t* data, std::size_t size, std::size_t* counts)
+{
+    for(std::size_t byteIndex = 0; byteIndex < size; ++byteIndex) {
+        ++counts[data[byteIndex]];
+    }
+}
+
+// four tables: runs of the same byte don't wait for the previous increment of the same counter
+void histogram_unrolled(const std::uint8_t* data, std::size_t size, std::size_t* counts)
+{
+    constexpr std::size_t MAX_CHUNK_SIZE = std::size_t{1} << 30; // 32-bit counters can't overflow
+    constexpr std::size_t TABLES_COUNT = 4;
+
+    while(size > 0) {
+        const auto chunkSize = std::min(size, MAX_CHUNK_SIZE);
+        std::uint32_t tables[TABLES_COUNT][256]{};
+
+        std::size_t byteIndex = 0;
+        for(; byteIndex + sizeof(std::uint64_t) <= chunkSize; byteIndex += sizeof(std::uint64_t)) {
+            std::uint64_t word = 0;
+            std::memcpy(&word, data + byteIndex, sizeof(word));
+            ++tables[0][word & 0xFF];
+            ++tables[1][(word >> 8) & 0xFF];
+            ++tables[2][(word >> 16) & 0xFF];
+            ++tables[3][(word >> 24) & 0xFF];
+            ++tables[0][(word >> 32) & 0xFF];
+            ++tables[1][(word >> 40) & 0xFF];
+            ++tables[2][(word >> 48) & 0xFF];
+            ++tables[3][word >> 56];
+        }
+        for(; byteIndex < chunkSize; ++byteIndex) {
+            ++tables[0][data[byteIndex]];
+        }
+
+        for(std::size_t symbol = 0; symbol < 256; ++symbol) {
+            counts[symbol] += std::size_t{tables[0][symbol]} + tables[1][symbol] + tables[2][symbol] + tables[3][symbol];
+        }
+
+        data += chunkSize;
+        size -= chunkSize;
+    }
+}
+
+// checksum
+
+constexpr std::uint32_t CRC32C_POLYNOMIAL = 0x82F63B78; // reversed 0x1EDC6F41
+
+using CrcTables = std::array<std::array<std::uint32_t, 256>, 8>;
+
+constexpr CrcTables make_crc_tables()
+{
+    CrcTables tables{};
+    for(std::uint32_t byte = 0; byte < 256; ++byte) {
+        std::uint32_t crc = byte;
+        for(int bitIndex = 0; bitIndex < 8; ++bitIndex) {
+            crc = (crc >> 1) ^ ((crc & 1) ? CRC32C_POLYNOMIAL : 0);
+        }
+        tables[0][byte] = crc;
+    }
+    for(std::size_t tableIndex = 1; tableIndex < tables.size(); ++tableIndex) {
+        for(std::size_t byte = 0; byte < 256; ++byte) {
+            const auto prev = tables[tableIndex - 1][byte];
+            tables[tableIndex][byte] = (prev >> 8) ^ tables[0][prev & 0xFF];
+        }
+    }
+    return tables;
+}
+
+constexpr CrcTables CRC_TABLES = make_crc_tables();
+
+// slicing by 8: eight table lookups per 8 bytes instead of eight dependent ones
+std::uint32_t checksum_portable(std::uint32_t crc, const std::uint8_t* data, std::size_t size)
+{
+    const auto& tables = CRC_TABLES;
+    crc = ~crc;
+    for(; size >= 8; data += 8, size -= 8) {
+        const std::uint32_t low = crc ^ (std::uint32_t{data[0]} | (std::uint32_t{data[1]} << 8) |
+                                         (std::uint32_t{data[2]} << 16) | (std::uint32_t{data[3]} << 24));
+        crc = tables[7][low & 0xFF] ^ tables[6][(low >> 8) & 0xFF] ^ tables[5][(low >> 16) & 0xFF] ^ tables[4][low >> 24] ^
+              tables[3][data[4]] ^ tables[2][data[5]] ^ tables[1][data[6]] ^ tables[0][data[7]];
+    }
+    for(; size > 0; ++data, --size) {
+        crc = (crc >> 8) ^ tables[0][(crc ^ *data) & 0xFF];
+    }
+    return ~crc;
+}
+
+#if HUFFMAN_HAS_X86_KERNELS
+
+__attribute__((target("sse4.2")))
+std::uint32_t checksum_sse42(std::uint32_t crc, const std::uint8_t* data, std::size_t size)
+{
+    std::uint64_t crc64 = ~crc;
+    for(; size >= 8; data += 8, size -= 8) {
+        std::uint64_t word = 0;
+        std::memcpy(&word, data, sizeof(word));
+        crc64 = _mm_crc32_u64(crc64, word);
+    }
+
+    auto crc32 = static_cast<std::uint32_t>(crc64);
+    for(; size > 0; ++data, --size) {
+        crc32 = _mm_crc32_u8(crc32, *data);
+    }
+    return ~crc32;
+}
+
+#endif
+
+}
+
+const CpuFeatures& cpu_features()
+{
+    static const CpuFeatures features = detect_cpu_features();
+    return features;
+}
+
+std::string format_cpu_features(const CpuFeatures& features)
+{
+    std::string result;
+    const auto append = [&result](bool supported, const char* name) {
+        if(supported) {
+            result += result.empty() ? name : std::string{" "} + name;
+        }
+    };
+    append(features.sse42, "sse4.2");
+    append(features.avx2, "avx2");
+    append(features.avx512bw, "avx512bw");
+    append(features.bmi2, "bmi2");
+    return result.empty() ? "portable" : result;
+}
+
+std::vector<Kernel<HistogramKernel>> histogram_kernels()
+{
+    return {
+        {"portable", histogram_portable, true},
+        {"unrolled", histogram_unrolled, true}
+    };
+}
+
+std::vector<Kernel<ChecksumKernel>> checksum_kernels()
+{
+    const auto& features = cpu_features();
+    (void)features;
+    return {
+        {"portable", checksum_portable, true},
+#if HUFFMAN_HAS_X86_KERNELS
+        {"sse4.2", checksum_sse42, features.sse42},
+#endif
+    };
+}
+
+const Kernels& kernels()
+{
+    static const Kernels selected{
+        select_kernel(histogram_kernels()),
+        select_kernel(checksum_kernels())
+    };
+    return selected;
+}
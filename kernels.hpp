@@ -0,0 +1,54 @@
+#ifndef KERNELS_HPP
+#define KERNELS_HPP
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define HUFFMAN_HAS_X86_KERNELS 1
+#else
+#define HUFFMAN_HAS_X86_KERNELS 0
+#endif
+
+struct CpuFeatures {
+    bool sse42 = false;
+    bool avx2 = false;
+    bool avx512bw = false;
+    bool bmi2 = false;
+};
+
+// detected once at the first call
+const CpuFeatures& cpu_features();
+std::string format_cpu_features(const CpuFeatures& features);
+
+// adds counts of bytes to counts[256]
+using HistogramKernel = void (*)(const std::uint8_t* data, std::size_t size, std::size_t* counts);
+// CRC-32C (Castagnoli), crc is the result for the previous data or 0
+using ChecksumKernel = std::uint32_t (*)(std::uint32_t crc, const std::uint8_t* data, std::size_t size);
+
+template<class Function>
+struct Kernel {
+    const char* name = "";
+    Function function = nullptr;
+    bool supported = false; // by this CPU
+};
+
+// all implementations from the portable one to the most specific
+std::vector<Kernel<HistogramKernel>> histogram_kernels();
+std::vector<Kernel<ChecksumKernel>> checksum_kernels();
+
+// the best supported implementations, selected once at the first call
+// (no copy kernel: memcpy of libc selects its implementation for the CPU itself and beats plain vector loops)
+struct Kernels {
+    Kernel<HistogramKernel> histogram;
+    Kernel<ChecksumKernel> checksum;
+};
+const Kernels& kernels();
+
+inline void count_bytes(const std::uint8_t* data, std::size_t size, std::size_t* counts) { kernels().histogram.function(data, size, counts); }
+inline std::uint32_t crc32c(const std::uint8_t* data, std::size_t size, std::uint32_t crc = 0) { return kernels().checksum.function(crc, data, size); }
+
+#endif // KERNELS_HPP
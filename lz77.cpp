@@ -0,0 +1,282 @@
+#include "lz77.hpp"
+
+#include "bitreader.hpp"
+#include "bitwriter.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <cstring>
+#include <cassert>
+
+
+namespace {
+
+void throw_corrupted() { throw std::runtime_error{"Corrupted transformed block"}; }
+
+constexpr unsigned HASH_BITS = 16;
+// codes 0..3 are the values, then two codes for each bit width up to 32
+constexpr unsigned DIRECT_CODES = 4;
+constexpr unsigned CODES_COUNT = 64;
+constexpr unsigned MAX_EXTRA_BITS = 30;
+
+struct Match {
+    std::uint32_t literalsCount;
+    std::uint32_t length;
+    std::uint32_t distance;
+};
+
+unsigned bit_width(std::uint32_t value)
+{
+    unsigned result = 0;
+    for(; value != 0; value >>= 1) {
+        ++result;
+    }
+    return result;
+}
+
+// the top two bits of a value select the code, the rest are extra bits
+void put_value(std::uint32_t value, BytesBuffer& codes, BitWriter& extraBits)
+{
+    if(value < DIRECT_CODES) {
+        codes.push_back(static_cast<std::uint8_t>(value));
+        return;
+    }
+
+    const auto width = bit_width(value);
+    const auto extraCount = width - 2;
+    codes.push_back(static_cast<std::uint8_t>(2 * width - 2 + ((value >> extraCount) & 1)));
+    extraBits.put(value & ((std::uint32_t{1} << extraCount) - 1), extraCount);
+}
+
+std::uint32_t get_value(std::uint8_t code, BitReader& extraBits)
+{
+    if(code < DIRECT_CODES) {
+        return code;
+    }
+    if(code >= CODES_COUNT) {
+        throw_corrupted();
+    }
+
+    const unsigned extraCount = code / 2u - 1;
+    extraBits.refill();
+    const auto extra = extraBits.peek(extraCount);
+    extraBits.skip(extraCount);
+    return ((std::uint32_t{2} | (code & 1u)) << extraCount) | extra;
+}
+
+std::uint32_t load_u32(const std::uint8_t* ptr)
+{
+    std::uint32_t result = 0;
+    std::memcpy(&result, ptr, sizeof(result));
+    return result;
+}
+
+std::size_t match_length(const std::uint8_t* first, const std::uint8_t* candidate, std::size_t limit)
+{
+    std::size_t length = 0;
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+    for(; length + sizeof(std::uint64_t) <= limit; length += sizeof(std::uint64_t)) {
+        std::uint64_t firstWord = 0;
+        std::uint64_t candidateWord = 0;
+        std::memcpy(&firstWord, first + length, sizeof(firstWord));
+        std::memcpy(&candidateWord, candidate + length, sizeof(candidateWord));
+        if(firstWord != candidateWord) {
+            return length + static_cast<std::size_t>(__builtin_ctzll(firstWord ^ candidateWord)) / 8;
+        }
+    }
+#endif
+    for(; length < limit && first[length] == candidate[length]; ++length) {}
+    return length;
+}
+
+// heads of the chains by hash of LZ_MIN_MATCH bytes, positions link to the previous ones with the same hash,
+// links keep position + 1 (0 - the end of the chain)
+class MatchFinder {
+public:
+    MatchFinder(const std::uint8_t* data, std::size_t size, const LzEffort& effort)
+        : data_{data}
+        , size_{size}
+        , effort_{effort}
+        , heads_(std::size_t{1} << HASH_BITS, 0)
+    {
+        std::size_t windowSize = 1;
+        while(windowSize < std::min(size, LZ_WINDOW_SIZE)) {
+            windowSize *= 2;
+        }
+        links_.assign(windowSize, 0);
+        windowMask_ = windowSize - 1;
+    }
+
+    // the longest match for pos (if at least LZ_MIN_MATCH) among the inserted positions
+    std::size_t find(std::size_t pos, std::size_t& distance) const
+    {
+        const auto limit = size_ - pos;
+        if(limit < LZ_MIN_MATCH) {
+            return 0;
+        }
+
+        std::size_t bestLength = LZ_MIN_MATCH - 1;
+        auto candidate = heads_[hash(pos)];
+        for(auto chain = effort_.chainLength; candidate != 0 && chain > 0; --chain) {
+            const std::size_t candidatePos = candidate - 1;
+            // older links are overwritten by newer positions
+            if(pos - candidatePos > windowMask_) {
+                break;
+            }
+
+            if(data_[candidatePos + bestLength] == data_[pos + bestLength]) {
+                const auto length = match_length(data_ + pos, data_ + candidatePos, limit);
+                if(length > bestLength) {
+                    bestLength = length;
+                    distance = pos - candidatePos;
+                    if(length >= effort_.niceLength || length == limit) {
+                        break;
+                    }
+                }
+            }
+            candidate = links_[candidatePos & windowMask_];
+        }
+        return (bestLength >= LZ_MIN_MATCH) ? bestLength : 0;
+    }
+
+    void insert(std::size_t pos)
+    {
+        if(pos + LZ_MIN_MATCH > size_) {
+            return;
+        }
+        auto& head = heads_[hash(pos)];
+        links_[pos & windowMask_] = head;
+        head = static_cast<std::uint32_t>(pos + 1);
+    }
+
+private:
+    std::size_t hash(std::size_t pos) const { return (load_u32(data_ + pos) * 2654435761u) >> (32 - HASH_BITS); }
+
+private:
+    const std::uint8_t* data_;
+    std::size_t size_;
+    LzEffort effort_;
+    std::vector<std::uint32_t> heads_;
+    std::vector<std::uint32_t> links_;
+    std::size_t windowMask_ = 0;
+};
+
+std::vector<Match> find_matches(const std::uint8_t* data, std::size_t size, const LzEffort& effort)
+{
+    std::vector<Match> matches;
+    MatchFinder finder(data, size, effort);
+
+    std::size_t literalsStart = 0;
+    for(std::size_t pos = 0; pos + LZ_MIN_MATCH <= size;) {
+        std::size_t distance = 0;
+        auto length = finder.find(pos, distance);
+        finder.insert(pos);
+        if(length == 0) {
+            ++pos;
+            continue;
+        }
+
+        // lazy matching: while the next position has a longer match the current byte goes as a literal
+        while(effort.lazy && length < effort.niceLength) {
+            std::size_t nextDistance = 0;
+            const auto nextLength = finder.find(pos + 1, nextDistance);
+            if(nextLength <= length) {
+                break;
+            }
+            finder.insert(++pos);
+            length = nextLength;
+            distance = nextDistance;
+        }
+
+        matches.push_back(Match{static_cast<std::uint32_t>(pos - literalsStart), static_cast<std::uint32_t>(length),
+                                static_cast<std::uint32_t>(distance)});
+        for(const auto matchEnd = pos + length; ++pos < matchEnd;) {
+            finder.insert(pos);
+        }
+        literalsStart = pos;
+    }
+    return matches;
+}
+
+void copy_match(std::uint8_t* output, std::size_t distance, std::size_t length)
+{
+    const auto* source = output - distance;
+    if(distance >= length) {
+        std::memcpy(output, source, length);
+        return;
+    }
+    // overlapping match repeats the last distance bytes
+    for(std::size_t index = 0; index < length; ++index) {
+        output[index] = source[index];
+    }
+}
+
+}
+
+void lz_encode(const std::uint8_t* data, std::size_t size, const LzEffort& effort, LzStreams& streams)
+{
+    assert(size < std::numeric_limits<std::uint32_t>::max());
+    const auto matches = find_matches(data, size, effort);
+
+    streams.literals.clear();
+    streams.literalCodes.clear();
+    streams.lengthCodes.clear();
+    streams.distanceCodes.clear();
+    streams.literalCodes.reserve(matches.size());
+    streams.lengthCodes.reserve(matches.size());
+    streams.distanceCodes.reserve(matches.size());
+
+    // the writer stores whole 64-bit words, so there is room for the last one
+    streams.extraBits.resize((matches.size() * 3 * MAX_EXTRA_BITS + BITS_IN_BYTE - 1) / BITS_IN_BYTE + sizeof(std::uint64_t));
+    BitWriter extraBits(streams.extraBits.data());
+
+    std::size_t pos = 0;
+    for(const auto& match : matches) {
+        streams.literals.insert(streams.literals.end(), data + pos, data + pos + match.literalsCount);
+        put_value(match.literalsCount, streams.literalCodes, extraBits);
+        put_value(static_cast<std::uint32_t>(match.length - LZ_MIN_MATCH), streams.lengthCodes, extraBits);
+        put_value(match.distance - 1, streams.distanceCodes, extraBits);
+        pos += match.literalsCount + match.length;
+    }
+    streams.literals.insert(streams.literals.end(), data + pos, data + size);
+    streams.extraBits.resize(static_cast<std::size_t>(extraBits.finish() - streams.extraBits.data()));
+}
+
+void lz_decode(const LzStreams& streams, std::uint8_t* output, std::size_t size)
+{
+    const auto matchesCount = streams.matchesCount();
+    if(streams.literalCodes.size() != matchesCount || streams.distanceCodes.size() != matchesCount || streams.literals.size() > size) {
+        throw_corrupted();
+    }
+
+    BitReader extraBits(streams.extraBits.data(), streams.extraBits.data() + streams.extraBits.size());
+    const auto* literals = streams.literals.data();
+    const auto* literalsEnd = literals + streams.literals.size();
+    std::size_t pos = 0;
+    for(std::size_t matchIndex = 0; matchIndex < matchesCount; ++matchIndex) {
+        const std::size_t literalsCount = get_value(streams.literalCodes[matchIndex], extraBits);
+        const std::size_t length = std::size_t{get_value(streams.lengthCodes[matchIndex], extraBits)} + LZ_MIN_MATCH;
+        const std::size_t distance = std::size_t{get_value(streams.distanceCodes[matchIndex], extraBits)} + 1;
+        if(literalsCount > static_cast<std::size_t>(literalsEnd - literals) || literalsCount > size - pos) {
+            throw_corrupted();
+        }
+        std::copy(literals, literals + literalsCount, output + pos);
+        literals += literalsCount;
+        pos += literalsCount;
+
+        if(distance > pos || length > size - pos) {
+            throw_corrupted();
+        }
+        copy_match(output + pos, distance, length);
+        pos += length;
+    }
+
+    // the rest are trailing literals, only the padding of the last byte of extra bits may remain
+    const auto restCount = static_cast<std::size_t>(literalsEnd - literals);
+    if(restCount != size - pos || extraBits.consumedBits() > extraBits.totalBits() ||
+       extraBits.totalBits() - extraBits.consumedBits() >= BITS_IN_BYTE) {
+        throw_corrupted();
+    }
+    std::copy(literals, literalsEnd, output + pos);
+}
@@ -0,0 +1,42 @@
+#ifndef LZ77_HPP
+#define LZ77_HPP
+
+#include "bufferalloc.hpp"
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+
+// Dictionary matching in front of the Huffman coder (as in deflate):
+// the block becomes a sequence of literal runs each followed by a match (length, distance) back in the block,
+// the trailing literals have no match. Matches are found by hash chains over a sliding window.
+// Numbers are written as codes of two per power of two (like deflate distances) plus extra bits,
+// so literals, literal run codes, length codes and distance codes are separate byte streams,
+// each one gets its own Huffman table.
+
+constexpr std::size_t LZ_MIN_MATCH = 4;
+constexpr std::size_t LZ_WINDOW_SIZE = 1024 * 1024;
+
+// how hard the match finder tries
+struct LzEffort {
+    std::size_t chainLength = 32;   // candidates checked for one position
+    std::size_t niceLength = 128;   // a match that long stops the search
+    bool lazy = true;               // a match is deferred if the next position has a longer one
+};
+
+struct LzStreams {
+    BytesBuffer literals;
+    BytesBuffer literalCodes;   // codes of literal runs before the matches
+    BytesBuffer lengthCodes;    // codes of (length - LZ_MIN_MATCH)
+    BytesBuffer distanceCodes;  // codes of (distance - 1)
+    BytesBuffer extraBits;      // extra bits of the codes in order of the matches (literal run, length, distance)
+
+    std::size_t matchesCount() const { return lengthCodes.size(); }
+};
+
+void lz_encode(const std::uint8_t* data, std::size_t size, const LzEffort& effort, LzStreams& streams);
+// throws if the streams don't decode to exactly size bytes
+void lz_decode(const LzStreams& streams, std::uint8_t* output, std::size_t size);
+
+#endif // LZ77_HPP
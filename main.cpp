@@ -1,11 +1,15 @@
 #include "mainwindow.hpp"
-#include "huffmanencoding.hpp"
+#include "cli.hpp"
 
 #include <QApplication>
 
 
 int main(int argc, char *argv[])
 {
+    if(argc > 1) {
+        return run_cli(argc, argv);
+    }
+
     QApplication a(argc, argv);
     MainWindow w;
     w.show();
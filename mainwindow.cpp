@@ -8,6 +8,7 @@
 #include <QMessageBox>
 #include <QDragEnterEvent>
 #include <QMimeData>
+#include <QFontDatabase>
 
 
 MainWindow::MainWindow(QWidget *parent)
@@ -18,6 +19,7 @@ MainWindow::MainWindow(QWidget *parent)
 {
     ui->setupUi(this);
     setAcceptDrops(true);
+    ui->detailsPlainTextEdit->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
 
     QObject::connect(ui->exitPushButton, &QPushButton::clicked, QCoreApplication::instance(), &QCoreApplication::exit);
     QObject::connect(ui->fromViewPushButton, &QPushButton::clicked, [this] {
@@ -97,11 +99,21 @@ void MainWindow::startProcess()
 
     const auto pathFrom = pathFromFile.toStdString();
     const auto pathTo = pathToFile.toStdString();
+
+    CodecOptions options;
+    options.level = static_cast<CompressionLevel>(ui->levelComboBox->currentIndex());
+    options.transform = static_cast<BlockTransform>(ui->transformComboBox->currentIndex());
+    if(ui->traceCheckBox->isChecked()) {
+        options.tracePath = pathTo + ".trace.json";
+    }
+
+    // written by the task thread, read after taskDone signal
+    lastStats_ = std::make_shared<CodecStats>();
     if(ui->compressRadioButton->isChecked()) {
-        compressingTask_->setTask([pathFrom, pathTo]{ compress_file(pathFrom, pathTo); });
+        compressingTask_->setTask([pathFrom, pathTo, options, pStats = lastStats_]{ *pStats = compress_file(pathFrom, pathTo, options); });
     }
     else {
-        compressingTask_->setTask([pathFrom, pathTo]{ decompress_file(pathFrom, pathTo); });
+        compressingTask_->setTask([pathFrom, pathTo, options, pStats = lastStats_]{ *pStats = decompress_file(pathFrom, pathTo, options); });
     }
 
     beginProcessing();
@@ -112,6 +124,7 @@ void MainWindow::beginProcessing()
 {
     processStarted_ = true;
     blockControls(true);
+    ui->detailsPlainTextEdit->clear();
     setStatusTip("Processing file...");
 }
 
@@ -119,6 +132,7 @@ void MainWindow::endProcessing(bool success)
 {
     if(success) {
         setStatusTip("Done");
+        showStats();
     }
     else {
         const auto pException = compressingTask_->getLastException();
@@ -138,6 +152,13 @@ void MainWindow::endProcessing(bool success)
 
 void MainWindow::showError(const QString& message) { QMessageBox::critical(this, QObject::tr("Error"), message); }
 
+void MainWindow::showStats()
+{
+    if(lastStats_) {
+        ui->detailsPlainTextEdit->setPlainText(QString::fromStdString(format_stats(*lastStats_)));
+    }
+}
+
 void MainWindow::blockControls(bool flag)
 {
     ui->fromLineEdit->setDisabled(flag);
@@ -148,6 +169,9 @@ void MainWindow::blockControls(bool flag)
 
     ui->compressRadioButton->setDisabled(flag);
     ui->decompressRadioButton->setDisabled(flag);
+    ui->levelComboBox->setDisabled(flag);
+    ui->transformComboBox->setDisabled(flag);
+    ui->traceCheckBox->setDisabled(flag);
 
     ui->exitPushButton->setDisabled(flag);
     ui->startPushButton->setDisabled(flag);
@@ -23,6 +23,7 @@ struct QThreadDeleter {
 using QThreadPtr = std::unique_ptr<QThread, QThreadDeleter>;
 
 class PackagedTask;
+struct CodecStats;
 
 class MainWindow : public QMainWindow
 {
@@ -52,6 +53,7 @@ private slots:
 
 private:
     void showError(const QString& message);
+    void showStats();
     void blockControls(bool flag);
 
 private:
@@ -59,6 +61,7 @@ private:
     bool processStarted_ = false;
     QThreadPtr secondTread_;
     PackagedTask* compressingTask_ = nullptr;
+    std::shared_ptr<CodecStats> lastStats_;
 };
 
 #endif // MAINWINDOW_HPP
@@ -0,0 +1,132 @@
+#ifndef MEMORYBITSITERATOR_HPP
+#define MEMORYBITSITERATOR_HPP
+
+#include "bufferalloc.hpp"
+#include "globalconstants.hpp"
+
+#include <vector>
+#include <iterator>
+#include <memory>
+#include <cstdint>
+#include <cassert>
+
+
+// Reads bits (most significant first) from the bytes range [first, last)
+class MemoryBitsIterator
+{
+public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = bool;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const bool*;
+    using reference = bool;
+
+    explicit MemoryBitsIterator() = default;
+    explicit MemoryBitsIterator(const std::uint8_t* first, const std::uint8_t* last)
+        : curr_{ first }
+        , last_{ last }
+    { assert(first <= last); }
+
+    bool isLastByte() const { return curr_ + 1 >= last_; }
+    std::uint8_t currentBit() const { return currBitIndex_; }
+    const std::uint8_t* currentByte() const { return curr_; }
+
+    MemoryBitsIterator& operator++()
+    {
+        assert(curr_ < last_);
+        ++currBitIndex_;
+        if (currBitIndex_ >= BITS_IN_BYTE) {
+            currBitIndex_ = 0;
+            ++curr_;
+        }
+        return *this;
+    }
+    MemoryBitsIterator operator++(int)
+    {
+        auto retval = *this;
+        ++(*this);
+        return retval;
+    }
+
+    // distance in bits
+    std::ptrdiff_t operator-(const MemoryBitsIterator& other) const
+    {
+        return (curr_ - other.curr_) * BITS_IN_BYTE + (currBitIndex_ - other.currBitIndex_);
+    }
+
+    bool operator==(const MemoryBitsIterator& other) const { return curr_ == other.curr_ && currBitIndex_ == other.currBitIndex_; }
+    bool operator!=(const MemoryBitsIterator& other) const { return !(*this == other); }
+
+    bool operator*() const
+    {
+        assert(curr_ < last_);
+        return *curr_ & (1 << (BITS_IN_BYTE - currBitIndex_ - 1));
+    }
+
+private:
+    const std::uint8_t* curr_ = nullptr;
+    const std::uint8_t* last_ = nullptr;
+    std::uint8_t currBitIndex_ = 0;
+};
+
+
+// Appends bits (most significant first) to the end of bytes buffer
+class BufferBitsInserter
+{
+public:
+    using iterator_category = std::output_iterator_tag;
+    using value_type = void;
+    using difference_type = void;
+    using pointer = void;
+    using reference = void;
+
+    explicit BufferBitsInserter(BytesBuffer& buffer)
+        : buffer_{ &buffer }
+        , state_{ std::make_shared<current_state>() }
+    { }
+
+    void flush()
+    {
+        assert(state_ != nullptr);
+        if (state_->currBitIndex > 0) {
+            buffer_->push_back(state_->currByte);
+            state_->currByte = 0;
+            state_->currBitIndex = 0;
+        }
+    }
+    std::uint8_t currentBit() const
+    {
+        assert(state_ != nullptr);
+        return state_->currBitIndex;
+    }
+
+    BufferBitsInserter& operator=(bool value)
+    {
+        state_->currByte |= (value << (BITS_IN_BYTE - state_->currBitIndex - 1));
+        return *this;
+    }
+    BufferBitsInserter& operator*() { return *this; }
+    BufferBitsInserter& operator++()
+    {
+        ++(state_->currBitIndex);
+        if (state_->currBitIndex >= BITS_IN_BYTE) {
+            buffer_->push_back(state_->currByte);
+            state_->currByte = 0;
+            state_->currBitIndex = 0;
+        }
+        return *this;
+    }
+    BufferBitsInserter& operator++(int) { return ++(*this); }
+
+private:
+    struct current_state {
+        std::uint8_t currByte = 0;
+        std::uint8_t currBitIndex = 0;
+    };
+
+private:
+    BytesBuffer* buffer_ = nullptr;
+    std::shared_ptr<current_state> state_;
+};
+
+#endif // MEMORYBITSITERATOR_HPP
@@ -0,0 +1,133 @@
+#include "memorybudget.hpp"
+#include "pipeline.hpp"
+#include "dedup.hpp"
+#include "lz77.hpp"
+#include "encodetable.hpp"
+
+#include <thread>
+#include <algorithm>
+#include <stdexcept>
+
+
+namespace {
+
+// the budget doesn't shrink blocks below it, smaller ones lose too much of the ratio
+constexpr std::size_t MIN_BUDGET_BLOCK_SIZE = 64 * 1024;
+
+// of the transform alone
+std::uint64_t transform_scratch_size(std::size_t blockSize, BlockTransform transform)
+{
+    const auto size = static_cast<std::uint64_t>(blockSize);
+    switch(transform) {
+    case BlockTransform::None:
+        return 0;
+    case BlockTransform::Bwt:
+        // 32-bit text and suffixes of the sort, its recursion, the last column and MTF output
+        return 14 * size;
+    case BlockTransform::Lz77:
+        // hash chains, matches (12 bytes for at most every 4th byte) and the streams
+        return 4 * std::min<std::uint64_t>(size, LZ_WINDOW_SIZE) + 256 * 1024 + 5 * size;
+    case BlockTransform::Words:
+        // frequencies, lengths and codes of the 16-bit alphabet
+        return 2 * 1024 * 1024;
+    }
+    return 0;
+}
+
+// besides the block buffers, for one worker
+std::uint64_t compression_scratch_size(std::size_t blockSize, const CodecOptions& options, bool deduplication)
+{
+    // every transform ends with (or falls back to) the Huffman stage, the split comes before it
+    std::uint64_t result = EncodeTable::tablesSize(blockSize);
+    if(options.level == CompressionLevel::Max && options.transform == BlockTransform::None && !deduplication) {
+        result = std::max(result, split_block_scratch_size(blockSize));
+    }
+    return result + transform_scratch_size(blockSize, options.transform);
+}
+
+std::uint64_t decompression_scratch_size(std::size_t blockSize, std::uint32_t flags)
+{
+    const auto size = static_cast<std::uint64_t>(blockSize);
+    std::uint64_t result = 0;
+    if((flags & BLOCKS_FLAG_BWT) != 0) {
+        // the transformed data, the last column and 32-bit links
+        result = std::max(result, 6 * size);
+    }
+    if((flags & BLOCKS_FLAG_LZ77) != 0) {
+        result = std::max(result, 2 * size); // the streams
+    }
+    if((flags & BLOCKS_FLAG_WORDS) != 0) {
+        result = std::max<std::uint64_t>(result, 512 * 1024); // code lengths and the decoding tables
+    }
+    if((flags & BLOCKS_FLAG_REFERENCES) != 0) {
+        result += size; // the payload of the referenced block
+    }
+    return result;
+}
+
+std::uint64_t io_size(const CodecOptions& options)
+{
+    // input and output
+    return options.ioBackend == IoBackend::IoUring ? 2 * std::uint64_t{options.ioUring.queueDepth} * options.ioUring.bufferSize : 0;
+}
+
+MemoryPlan make_plan(const CodecOptions& options, std::size_t blockSize)
+{
+    MemoryPlan plan;
+    plan.blockSize = blockSize;
+    plan.threadsCount = (options.threadsCount != 0) ? options.threadsCount : std::max(1u, std::thread::hardware_concurrency());
+    plan.blocksCount = Pipeline::defaultBlocksCount(plan.threadsCount);
+    return plan;
+}
+
+// scratchSize(plan) - all but the block buffers
+template<class ScratchSize>
+MemoryPlan fit_budget(MemoryPlan plan, std::uint64_t budget, bool resizeBlocks, const ScratchSize& scratchSize)
+{
+    const auto estimate = [&scratchSize](MemoryPlan& plan) {
+        // a block holds the input and the output of about the same size
+        plan.scratchSize = scratchSize(plan);
+        plan.totalSize = plan.blocksCount * 2 * static_cast<std::uint64_t>(plan.blockSize) + plan.scratchSize;
+    };
+
+    estimate(plan);
+    while(budget != 0 && plan.totalSize > budget) {
+        const auto shallowBlocksCount = static_cast<std::size_t>(plan.threadsCount) + 2;
+        if(plan.blocksCount > shallowBlocksCount) {
+            plan.blocksCount = shallowBlocksCount;
+        }
+        else if(plan.threadsCount > 1) {
+            --plan.threadsCount;
+            plan.blocksCount = static_cast<std::size_t>(plan.threadsCount) + 2;
+        }
+        else if(resizeBlocks && plan.blockSize > MIN_BUDGET_BLOCK_SIZE) {
+            plan.blockSize = std::max(plan.blockSize / 2, MIN_BUDGET_BLOCK_SIZE);
+        }
+        else {
+            const auto fixedBlocks = resizeBlocks ? std::string{} : " (blocks of " + std::to_string(plan.blockSize) + " bytes can't be smaller)";
+            throw std::runtime_error{"Memory budget of " + std::to_string(budget) + " bytes is too small, " +
+                                     std::to_string(plan.totalSize) + " bytes are needed" + fixedBlocks};
+        }
+        estimate(plan);
+    }
+    return plan;
+}
+
+}
+
+MemoryPlan plan_compression_memory(const CodecOptions& options, bool deduplication)
+{
+    // the chunk size limit moves the boundaries of the chunks, smaller chunks wouldn't match the indexed ones
+    const auto blockSize = deduplication ? std::min(options.blockSize, CDC_MAX_SIZE) : options.blockSize;
+    return fit_budget(make_plan(options, blockSize), options.memoryBudget, !deduplication, [&](const MemoryPlan& plan) {
+        const auto readerSize = deduplication ? ChunkReader::bufferSize(plan.blockSize) : 0;
+        return plan.threadsCount * compression_scratch_size(plan.blockSize, options, deduplication) + readerSize + io_size(options);
+    });
+}
+
+MemoryPlan plan_decompression_memory(const CodecOptions& options, const BlocksHeader& blocksHeader)
+{
+    return fit_budget(make_plan(options, blocksHeader.blockSize), options.memoryBudget, false, [&](const MemoryPlan& plan) {
+        return plan.threadsCount * decompression_scratch_size(plan.blockSize, blocksHeader.flags) + io_size(options);
+    });
+}
@@ -0,0 +1,26 @@
+#ifndef MEMORYBUDGET_HPP
+#define MEMORYBUDGET_HPP
+
+#include "huffmanencoding.hpp"
+
+
+// Working memory of the blocks pipeline: every block of the pool holds its input and output,
+// every worker needs scratch for the transform, the encoding tables and the split of Max level,
+// plus the fixed buffers of the reader (chunking, io_uring).
+// With options.memoryBudget the estimate is fitted to the budget: the queues get shallow first,
+// then the threads are fewer, then (only when compressing without deduplication) the blocks get smaller.
+
+struct MemoryPlan {
+    std::size_t blockSize = 0;
+    unsigned threadsCount = 1;
+    std::size_t blocksCount = 0;   // blocks of the pipeline pool
+    std::uint64_t scratchSize = 0; // all but the block buffers
+    std::uint64_t totalSize = 0;   // estimated working memory
+};
+
+// throws if the budget is too small
+MemoryPlan plan_compression_memory(const CodecOptions& options, bool deduplication = false);
+// the block size of the file can't be changed, its flags tell the transforms used
+MemoryPlan plan_decompression_memory(const CodecOptions& options, const BlocksHeader& blocksHeader);
+
+#endif // MEMORYBUDGET_HPP
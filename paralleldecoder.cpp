@@ -0,0 +1,216 @@
+#include "paralleldecoder.hpp"
+#include "decodetable.hpp"
+#include "bitreader.hpp"
+#include "stats.hpp"
+
+#include <ostream>
+#include <thread>
+#include <vector>
+#include <exception>
+#include <algorithm>
+#include <stdexcept>
+#include <limits>
+
+
+namespace {
+
+// smaller chunks are not worth a thread
+constexpr std::uint64_t MIN_CHUNK_BITS = 256 * 1024 * BITS_IN_BYTE;
+// symbol boundaries kept from the start of a chunk, it has to resynchronize within them
+constexpr std::size_t SYNC_SYMBOLS = 1024;
+
+struct Chunk {
+    std::uint64_t firstBit = 0;             // the cut, speculative start
+    std::uint64_t lastBit = 0;              // the cut of the next chunk
+    std::uint64_t endBit = 0;               // after the last decoded symbol
+    std::vector<std::uint64_t> boundaries;  // starts of the first SYNC_SYMBOLS symbols
+    BytesBuffer symbols;
+    bool failed = false;                    // an invalid code, the chunk is decoded again
+};
+
+// reads the stream from any bit, position() is the absolute bit
+class StreamReader {
+public:
+    StreamReader(const std::uint8_t* data, std::uint64_t bytesCount, std::uint64_t firstBit)
+        : reader_{data + firstBit / BITS_IN_BYTE, data + bytesCount}
+        , base_{firstBit - firstBit % BITS_IN_BYTE}
+    {
+        reader_.refill();
+        reader_.skip(static_cast<unsigned>(firstBit % BITS_IN_BYTE));
+    }
+
+    BitReader& reader() { return reader_; }
+    std::uint64_t position() const { return base_ + reader_.consumedBits(); }
+
+    std::uint8_t decodeSymbol(const DecodeTable& table)
+    {
+        reader_.refill();
+        return table.decodeSymbol(reader_);
+    }
+    // decodes while the position is before lastBit
+    void decodeUntil(const DecodeTable& table, std::uint64_t lastBit, BytesBuffer& output)
+    {
+        if(position() < lastBit) {
+            table.decodeBits(reader_, lastBit - base_, output);
+        }
+    }
+
+private:
+    BitReader reader_;
+    std::uint64_t base_ = 0;
+};
+
+void decode_chunk(const DecodeTable& table, const std::uint8_t* data, std::uint64_t bytesCount, Chunk& chunk)
+{
+    StageTimer timer{Stage::Decode};
+    StreamReader stream(data, bytesCount, chunk.firstBit);
+    try {
+        while(stream.position() < chunk.lastBit && chunk.boundaries.size() < SYNC_SYMBOLS) {
+            chunk.boundaries.push_back(stream.position());
+            chunk.symbols.push_back(stream.decodeSymbol(table));
+        }
+        stream.decodeUntil(table, chunk.lastBit, chunk.symbols);
+    }
+    catch(const std::runtime_error&) {
+        chunk.failed = true;
+    }
+    chunk.endBit = stream.position();
+}
+
+// the true decoding from the boundary firstBit up to a boundary seen by the chunk or to the end of the chunk,
+// returns the index of the chunk symbol it met (symbols.size() if none)
+std::size_t resynchronize(const DecodeTable& table, const std::uint8_t* data, std::uint64_t bytesCount,
+                          std::uint64_t& firstBit, const Chunk& chunk, BytesBuffer& output)
+{
+    StreamReader stream(data, bytesCount, firstBit);
+    if(!chunk.failed) {
+        const auto lastBoundary = chunk.boundaries.empty() ? 0 : chunk.boundaries.back();
+        while(!chunk.boundaries.empty() && stream.position() <= lastBoundary) {
+            const auto position = stream.position();
+            const auto it = std::lower_bound(chunk.boundaries.cbegin(), chunk.boundaries.cend(), position);
+            if(*it == position) {
+                firstBit = position;
+                return static_cast<std::size_t>(it - chunk.boundaries.cbegin());
+            }
+            if(position >= chunk.lastBit) {
+                break;
+            }
+            output.push_back(stream.decodeSymbol(table));
+        }
+    }
+
+    stream.decodeUntil(table, chunk.lastBit, output);
+    firstBit = stream.position();
+    return chunk.symbols.size();
+}
+
+void write(std::ostream& outputStream, const std::uint8_t* first, const std::uint8_t* last)
+{
+    StageTimer timer{Stage::Write};
+    outputStream.write(reinterpret_cast<const char*>(first), std::streamsize(last - first));
+    if(!outputStream) {
+        throw std::runtime_error{"Unable to write decompressed data"};
+    }
+}
+
+}
+
+void decode_stream_parallel(const HuffmanDict& dict, const std::uint8_t* data, std::uint64_t bitsCount,
+                            std::ostream& outputStream, unsigned threadsCount)
+{
+    if(bitsCount == 0) {
+        return;
+    }
+
+    const DecodeTable table{dict};
+    const auto bytesCount = (bitsCount + BITS_IN_BYTE - 1) / BITS_IN_BYTE;
+
+    if(threadsCount == 0) {
+        threadsCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    const auto chunksCount = static_cast<std::size_t>(std::max<std::uint64_t>(1, std::min<std::uint64_t>(threadsCount, bitsCount / MIN_CHUNK_BITS)));
+
+    std::vector<Chunk> chunks(chunksCount);
+    for(std::size_t chunkIndex = 0; chunkIndex < chunksCount; ++chunkIndex) {
+        chunks[chunkIndex].firstBit = bitsCount * chunkIndex / chunksCount;
+        chunks[chunkIndex].lastBit = bitsCount * (chunkIndex + 1) / chunksCount;
+    }
+
+    auto* collector = StatsScope::current();
+    if(collector != nullptr) {
+        collector->setThreadsCount(static_cast<unsigned>(chunksCount));
+    }
+
+    // the first chunk starts at the true boundary, it is decoded on this thread
+    std::vector<std::exception_ptr> exceptions(chunksCount);
+    std::vector<std::thread> threads;
+    threads.reserve(chunksCount - 1);
+    for(std::size_t chunkIndex = 1; chunkIndex < chunksCount; ++chunkIndex) {
+        threads.emplace_back([&, chunkIndex]() {
+            StatsScope statsScope{collector};
+            try {
+                decode_chunk(table, data, bytesCount, chunks[chunkIndex]);
+            }
+            catch(...) {
+                exceptions[chunkIndex] = std::current_exception();
+            }
+        });
+    }
+    try {
+        decode_chunk(table, data, bytesCount, chunks.front());
+    }
+    catch(...) {
+        exceptions.front() = std::current_exception();
+    }
+    for(auto& thread : threads) {
+        thread.join();
+    }
+    for(const auto& exception : exceptions) {
+        if(exception) {
+            std::rethrow_exception(exception);
+        }
+    }
+
+    // stitching: position is always the true boundary
+    std::uint64_t position = 0;
+    BytesBuffer serial;
+    for(const auto& chunk : chunks) {
+        serial.clear();
+        std::size_t syncIndex = 0;
+        {
+            StageTimer timer{Stage::Decode};
+            syncIndex = resynchronize(table, data, bytesCount, position, chunk, serial);
+        }
+        write(outputStream, serial.data(), serial.data() + serial.size());
+        if(syncIndex < chunk.symbols.size()) {
+            write(outputStream, chunk.symbols.data() + syncIndex, chunk.symbols.data() + chunk.symbols.size());
+            position = chunk.endBit;
+        }
+    }
+
+    if(position != bitsCount) {
+        throw std::runtime_error{"Unexpected end of encoded data"};
+    }
+
+    if(collector != nullptr) {
+        std::uint64_t memory = bytesCount + serial.capacity();
+        for(const auto& chunk : chunks) {
+            memory += chunk.symbols.capacity() + chunk.boundaries.capacity() * sizeof(std::uint64_t);
+        }
+        collector->setEstimatedMemory(memory);
+    }
+}
+
+std::uint64_t parallel_decode_memory(const HuffmanDict& dict, std::uint64_t bitsCount)
+{
+    std::size_t minCodeSize = std::numeric_limits<std::size_t>::max();
+    for(const auto& code : dict) {
+        if(!code.empty()) {
+            minCodeSize = std::min<std::size_t>(minCodeSize, code.size());
+        }
+    }
+    if(minCodeSize == std::numeric_limits<std::size_t>::max()) {
+        return 0;
+    }
+    return (bitsCount + BITS_IN_BYTE - 1) / BITS_IN_BYTE + bitsCount / minCodeSize;
+}
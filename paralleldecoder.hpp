@@ -0,0 +1,24 @@
+#ifndef PARALLELDECODER_HPP
+#define PARALLELDECODER_HPP
+
+#include "htree.hpp"
+
+#include <iosfwd>
+#include <cstdint>
+
+
+// Speculative parallel decoding of a single Huffman stream without block boundaries (the "HAFF" files).
+// The stream is cut into chunks at arbitrary bits and every chunk is decoded on its own thread from its cut.
+// A wrong start gives garbage at first, but Huffman codes resynchronize: after a few symbols the chunk
+// hits a symbol boundary of the true decoding and stays on them. The true decoding of the previous chunk
+// goes on past its end until it meets a boundary the chunk has seen, the chunk's symbols from there on are kept.
+// A chunk which hasn't resynchronized (or has met an invalid code) is decoded again from the true boundary.
+
+// decodes bitsCount bits of data (the rest is padding) to outputStream, threadsCount 0 - by the number of cores,
+// throws if the codes are invalid or the last one doesn't end at bitsCount
+void decode_stream_parallel(const HuffmanDict& dict, const std::uint8_t* data, std::uint64_t bitsCount,
+                            std::ostream& outputStream, unsigned threadsCount = 0);
+// the most memory decode_stream_parallel may take with the data: the decoded symbols are kept until stitched
+std::uint64_t parallel_decode_memory(const HuffmanDict& dict, std::uint64_t bitsCount);
+
+#endif // PARALLELDECODER_HPP
@@ -0,0 +1,235 @@
+#include "pipeline.hpp"
+#include "bounded_queue.hpp"
+#include "stats.hpp"
+#include "trace.hpp"
+
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <vector>
+#include <exception>
+#include <algorithm>
+#include <string>
+#include <cassert>
+
+
+namespace {
+
+using BlocksQueue = bounded_queue<PipelineBlock*>;
+
+void set_trace_thread_name(StatsCollector* collector, const std::string& name)
+{
+    if(collector != nullptr && collector->traceRecorder() != nullptr) {
+        collector->traceRecorder()->setThreadName(name);
+    }
+}
+
+class PipelineState {
+public:
+    explicit PipelineState(std::size_t blocksCount, unsigned workersCount)
+        : freeBlocks{blocksCount}
+        , readBlocks{blocksCount + workersCount}
+        , processedBlocks{blocksCount}
+    {}
+
+    void fail(std::exception_ptr pException)
+    {
+        std::lock_guard<std::mutex> lock{exceptionMutex_};
+        if(!pException_) {
+            pException_ = pException;
+        }
+        aborted.store(true, std::memory_order_release);
+    }
+    std::exception_ptr exception() const { return pException_; }
+
+    bool isAborted() const { return aborted.load(std::memory_order_acquire); }
+
+    // waits for the value from queue, returns false if pipeline was aborted
+    bool pop(BlocksQueue& queue, PipelineBlock*& pBlock) const
+    {
+        backoff wait;
+        while(!queue.try_pop(pBlock)) {
+            if(isAborted()) {
+                return false;
+            }
+            wait();
+        }
+        return true;
+    }
+    bool push(BlocksQueue& queue, PipelineBlock* pBlock) const
+    {
+        backoff wait;
+        while(!queue.try_push(pBlock)) {
+            if(isAborted()) {
+                return false;
+            }
+            wait();
+        }
+        return true;
+    }
+
+public:
+    BlocksQueue freeBlocks;
+    BlocksQueue readBlocks;
+    BlocksQueue processedBlocks;
+
+    std::atomic<bool> aborted{false};
+    std::atomic<bool> readingDone{false};
+    std::atomic<std::uint64_t> totalBlocks{0};
+
+private:
+    std::mutex exceptionMutex_;
+    std::exception_ptr pException_;
+};
+
+void reader_stage(PipelineState& state, const Pipeline::ReadStage& read, unsigned workersCount, StatsCollector* collector)
+{
+    StatsScope statsScope{collector};
+    set_trace_thread_name(collector, "reader");
+    try {
+        std::uint64_t blockIndex = 0;
+        PipelineBlock* pBlock = nullptr;
+        while(state.pop(state.freeBlocks, pBlock)) {
+            pBlock->index = blockIndex;
+            TraceRecorder::setCurrentBlock(static_cast<std::int64_t>(blockIndex));
+            if(!read(*pBlock)) {
+                state.push(state.freeBlocks, pBlock);
+                break;
+            }
+
+            ++blockIndex;
+            if(!state.push(state.readBlocks, pBlock)) {
+                return;
+            }
+        }
+
+        state.totalBlocks.store(blockIndex, std::memory_order_relaxed);
+        state.readingDone.store(true, std::memory_order_release);
+
+        // one stop signal for each worker
+        for(unsigned i = 0; i < workersCount; ++i) {
+            state.push(state.readBlocks, nullptr);
+        }
+    }
+    catch(...) {
+        state.fail(std::current_exception());
+    }
+}
+
+void worker_stage(PipelineState& state, const Pipeline::ProcessStage& process, StatsCollector* collector, unsigned workerIndex)
+{
+    StatsScope statsScope{collector};
+    set_trace_thread_name(collector, "worker " + std::to_string(workerIndex + 1));
+    try {
+        PipelineBlock* pBlock = nullptr;
+        while(state.pop(state.readBlocks, pBlock) && pBlock != nullptr) {
+            TraceRecorder::setCurrentBlock(static_cast<std::int64_t>(pBlock->index));
+            process(*pBlock);
+            if(!state.push(state.processedBlocks, pBlock)) {
+                return;
+            }
+        }
+    }
+    catch(...) {
+        state.fail(std::current_exception());
+    }
+}
+
+void writer_stage(PipelineState& state, const Pipeline::WriteStage& write, std::size_t blocksCount)
+{
+    try {
+        // blocks come from workers in any order, pending ones are kept until their turn
+        std::vector<PipelineBlock*> pending(blocksCount, nullptr);
+        std::uint64_t nextIndex = 0;
+        backoff wait;
+        while(!state.isAborted()) {
+            if(state.readingDone.load(std::memory_order_acquire) && nextIndex == state.totalBlocks.load(std::memory_order_relaxed)) {
+                return;
+            }
+
+            PipelineBlock* pBlock = nullptr;
+            if(!state.processedBlocks.try_pop(pBlock)) {
+                wait();
+                continue;
+            }
+            wait.reset();
+
+            pending[pBlock->index % blocksCount] = pBlock;
+            while(pending[nextIndex % blocksCount] != nullptr) {
+                auto*& pNext = pending[nextIndex % blocksCount];
+                assert(pNext->index == nextIndex);
+                TraceRecorder::setCurrentBlock(static_cast<std::int64_t>(nextIndex));
+                write(*pNext);
+                state.push(state.freeBlocks, pNext);
+                pNext = nullptr;
+                ++nextIndex;
+            }
+        }
+    }
+    catch(...) {
+        state.fail(std::current_exception());
+    }
+}
+
+}
+
+Pipeline::Pipeline(unsigned workersCount, std::size_t blocksCount, std::size_t bufferSize)
+    : workersCount_{workersCount}
+    , blocksCount_{blocksCount}
+    , bufferSize_{bufferSize}
+{
+    if(workersCount_ == 0) {
+        workersCount_ = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if(blocksCount_ == 0) {
+        blocksCount_ = defaultBlocksCount(workersCount_);
+    }
+}
+
+std::uint64_t Pipeline::run(const ReadStage& read, const ProcessStage& process, const WriteStage& write) const
+{
+    std::vector<PipelineBlock> blocks(blocksCount_);
+    PipelineState state{blocksCount_, workersCount_};
+    for(auto& block : blocks) {
+        // only address space, the pages are taken as the blocks are filled
+        if(bufferSize_ != 0) {
+            block.input.reserve(bufferSize_);
+            block.output.reserve(bufferSize_);
+            advise_huge_pages(block.input.data(), block.input.capacity());
+            advise_huge_pages(block.output.data(), block.output.capacity());
+        }
+        state.freeBlocks.try_push(&block);
+    }
+
+    // stages on the pipeline threads are measured by the caller's collector
+    auto* collector = StatsScope::current();
+    if(collector != nullptr) {
+        collector->setThreadsCount(workersCount_);
+    }
+
+    std::vector<std::thread> threads;
+    threads.reserve(workersCount_ + 1);
+    threads.emplace_back(reader_stage, std::ref(state), std::cref(read), workersCount_, collector);
+    for(unsigned i = 0; i < workersCount_; ++i) {
+        threads.emplace_back(worker_stage, std::ref(state), std::cref(process), collector, i);
+    }
+    set_trace_thread_name(collector, "writer");
+
+    writer_stage(state, write, blocksCount_);
+    TraceRecorder::setCurrentBlock(-1);
+    for(auto& thread : threads) {
+        thread.join();
+    }
+
+    if(state.exception()) {
+        std::rethrow_exception(state.exception());
+    }
+
+    // buffers only grow, so their capacities are the peak
+    std::uint64_t result = 0;
+    for(const auto& block : blocks) {
+        result += block.input.capacity() + block.output.capacity() +
+                  block.parts.capacity() * sizeof(BlockHeader) + block.matches.capacity() * sizeof(std::uint64_t);
+    }
+    return result;
+}
@@ -0,0 +1,53 @@
+#ifndef PIPELINE_HPP
+#define PIPELINE_HPP
+
+#include "blockcodec.hpp"
+#include "sha256.hpp"
+
+#include <functional>
+#include <cstdint>
+
+
+struct PipelineBlock {
+    std::uint64_t index = 0; // порядковый номер блока в потоке
+    BlockHeader header;
+    BytesBuffer input;
+    BytesBuffer output;
+    std::vector<BlockHeader> parts;     // если блок разбит: заголовки частей, output - части с заголовками
+    Sha256Digest digest{};              // при дедупликации: хэш input
+    std::vector<std::uint64_t> matches; // при поиске: смещения совпадений внутри output
+};
+
+// Reader -> workers -> writer pipeline over the pool of reusable blocks.
+// The reader and every worker run on their own threads, the writer runs on the thread calling run(),
+// so I/O overlaps with processing; blocks are written in the order they were read.
+// The first exception thrown by any stage stops the pipeline and is rethrown from run().
+class Pipeline {
+public:
+    using ReadStage = std::function<bool(PipelineBlock&)>; // false - no more data
+    using ProcessStage = std::function<void(PipelineBlock&)>;
+    using WriteStage = std::function<void(const PipelineBlock&)>;
+
+public:
+    // blocksCount 0 - defaultBlocksCount(workersCount);
+    // bufferSize - the input and output of every block are reserved for it before the run (see advise_huge_pages),
+    // so the buffers of the pool don't grow while it runs
+    explicit Pipeline(unsigned workersCount = 0, std::size_t blocksCount = 0, std::size_t bufferSize = 0);
+
+    unsigned workersCount() const { return workersCount_; }
+    std::size_t blocksCount() const { return blocksCount_; }
+
+    // returns the peak memory of the blocks (capacities of their buffers)
+    std::uint64_t run(const ReadStage& read, const ProcessStage& process, const WriteStage& write) const;
+
+    // each worker has one block in processing and one waiting in the queue (double buffering),
+    // plus the block being read and the one being written (on the caller's thread)
+    static std::size_t defaultBlocksCount(unsigned workersCount) { return 2 * std::size_t{workersCount} + 2; }
+
+private:
+    unsigned workersCount_ = 1;
+    std::size_t blocksCount_ = 0;
+    std::size_t bufferSize_ = 0;
+};
+
+#endif // PIPELINE_HPP
@@ -5,6 +5,7 @@
 #include "memory_facilities.hpp"
 
 #include <memory>
+#include <vector>
 #include <stdexcept>
 #include <cassert>
 #include <algorithm>
@@ -60,8 +61,127 @@ namespace priority_queue_impl {
 }
 
 
-template<typename T, typename Comp = std::less<>, typename Alloc = std::allocator<T>>
+// Arity == 0 - sorted array: stable for equal elements, iterating gives them in order, push is linear.
+// Arity >= 2 - d-ary heap: push and pop are logarithmic, equal elements come in unspecified order.
+// In both modes top() is the least element by Comp.
+template<typename T, typename Comp = std::less<>, typename Alloc = std::allocator<T>, std::size_t Arity = 0>
 struct priority_queue {
+    static_assert(Arity >= 2, "d-ary heap needs at least 2 children per node");
+
+    using value_type = T;
+    using size_type = std::size_t;
+    using allocator_type = typename std::allocator_traits<Alloc>::template rebind_alloc<T>;
+    using reference = T&;
+    using const_reference = const T&;
+    using const_iterator = const T*;
+    using difference_type = std::ptrdiff_t;
+
+    static constexpr size_type arity = Arity;
+
+    priority_queue(Comp comp = Comp()) : comp_{comp} {}
+    priority_queue(size_type capacity, Comp comp = Comp()) : comp_{ comp } { data_.reserve(capacity); }
+    template<typename Iter, typename = typename std::iterator_traits<Iter>::iterator_category>
+    priority_queue(Iter first, Iter last, Comp comp = Comp()) : data_(first, last), comp_{ comp } {
+        // heapify: sifting down every parent from the last one
+        const size_type parents_count = data_.size() > 1 ? parent(data_.size() - 1) + 1 : 0;
+        for (size_type index = parents_count; index-- > 0;) {
+            sift_down(index);
+        }
+    }
+
+    T& front() { check_empty(); return data_.front(); }
+    const T& front() const { check_empty(); return data_.front(); }
+
+    T& top() { return front(); }
+    const T& top() const { return front(); }
+
+    inline bool empty() const noexcept { return data_.empty(); }
+    inline size_type size() const noexcept { return data_.size(); }
+    inline size_type capacity() const noexcept { return data_.capacity(); }
+
+    void pop() {
+        check_empty();
+        if (data_.size() > 1) {
+            data_.front() = std::move_if_noexcept(data_.back());
+        }
+        data_.pop_back();
+        if (!data_.empty()) {
+            sift_down(0);
+        }
+    }
+    void push(const T& value) { data_.push_back(value); sift_up(data_.size() - 1); }
+    void push(T&& value) { data_.push_back(std::move(value)); sift_up(data_.size() - 1); }
+
+    template<typename... Args>
+    void emplace(Args&&... args) {
+        data_.emplace_back(std::forward<Args>(args)...);
+        sift_up(data_.size() - 1);
+    }
+
+    void swap(priority_queue& other) noexcept {
+        data_.swap(other.data_);
+        std::swap(comp_, other.comp_);
+    }
+
+    void clear() { data_.clear(); }
+
+    // heap order, not sorted
+    inline const_iterator begin() const noexcept { return data_.data(); }
+    inline const_iterator end() const noexcept { return data_.data() + data_.size(); }
+
+    inline const_iterator cbegin() const noexcept { return begin(); }
+    inline const_iterator cend() const noexcept { return end(); }
+
+private:
+    static constexpr size_type parent(size_type index) noexcept { return (index - 1) / Arity; }
+    static constexpr size_type first_child(size_type index) noexcept { return Arity * index + 1; }
+
+    void check_empty() const { if (data_.empty()) throw std::out_of_range{ "queue was empty" }; }
+
+    void sift_up(size_type index) {
+        T value = std::move_if_noexcept(data_[index]);
+        while (index > 0 && comp_(value, data_[parent(index)])) {
+            data_[index] = std::move_if_noexcept(data_[parent(index)]);
+            index = parent(index);
+        }
+        data_[index] = std::move_if_noexcept(value);
+    }
+
+    void sift_down(size_type index) {
+        const auto count = data_.size();
+        T value = std::move_if_noexcept(data_[index]);
+        for (;;) {
+            const auto first = first_child(index);
+            if (first >= count) {
+                break;
+            }
+
+            // the least of up to Arity children, they are adjacent in memory
+            const auto last = std::min(first + Arity, count);
+            auto least = first;
+            for (auto child = first + 1; child < last; ++child) {
+                if (comp_(data_[child], data_[least])) {
+                    least = child;
+                }
+            }
+
+            if (!comp_(data_[least], value)) {
+                break;
+            }
+            data_[index] = std::move_if_noexcept(data_[least]);
+            index = least;
+        }
+        data_[index] = std::move_if_noexcept(value);
+    }
+
+private:
+    std::vector<T, allocator_type> data_;
+    Comp comp_;
+};
+
+
+template<typename T, typename Comp, typename Alloc>
+struct priority_queue<T, Comp, Alloc, 0> {
     using value_type = T;
     using size_type = std::size_t;
     using allocator_type = typename std::allocator_traits<Alloc>::template rebind_alloc<T>;
@@ -87,7 +207,7 @@ struct priority_queue {
 
     priority_queue(const priority_queue& other) : priority_queue(other.size(), other.comp_) {
         std::uninitialized_copy(other.front_, other.back_, front_);
-        back_ = front_ + size();
+        back_ = front_ + other.size();
     }
     priority_queue& operator=(const priority_queue& other) {
         if (this == &other) {
@@ -119,7 +239,7 @@ struct priority_queue {
         return *this;
     }
 
-    priority_queue(priority_queue&& other) : comp_{ other.comp } { this->swap(other); }
+    priority_queue(priority_queue&& other) : comp_{ other.comp_ } { this->swap(other); }
     priority_queue& operator=(priority_queue&& other) {
         if (this == &other) {
             return *this;
@@ -206,7 +326,7 @@ private:
 
         // if queue hasn't capacity (was in empty state) - allocate storage
         if (begin_capacity_ == nullptr) {
-            priority_queue tmp(DEFAULT_SIZE);
+            priority_queue tmp(DEFAULT_SIZE, comp_);
             this->swap(tmp);
             T* place_to_insert = back_;
             ++back_;
@@ -222,7 +342,7 @@ private:
 
         // if capacity is exceeded - reallocate storage
         if (front_ == begin_capacity_) {
-            priority_queue tmp(curr_size * FACTOR);
+            priority_queue tmp(std::max<size_type>(curr_size * FACTOR, DEFAULT_SIZE), comp_);
             tmp.back_ = tmp.front_ + curr_size + 1;
 
             place_to_insert = priority_queue_impl::copy_and_get_place_to_insertion(front_, back_, tmp.front_, value, comp_);
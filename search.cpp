@@ -0,0 +1,167 @@
+#include "search.hpp"
+#include "dedup.hpp"
+#include "trace.hpp"
+#include "htree.hpp"
+
+#include <fstream>
+#include <algorithm>
+#include <stdexcept>
+
+
+namespace {
+
+// the decompressed data of a single stream file goes to the search instead of a file
+class SearchStreamBuf : public std::streambuf {
+public:
+    SearchStreamBuf(StreamSearch& search, std::vector<std::uint64_t>& offsets)
+        : search_{search}
+        , offsets_{offsets}
+    {}
+
+protected:
+    std::streamsize xsputn(const char* data, std::streamsize count) override
+    {
+        StageTimer timer{Stage::Search};
+        search_.feed(reinterpret_cast<const std::uint8_t*>(data), static_cast<std::size_t>(count), offsets_);
+        return count;
+    }
+
+    int_type overflow(int_type ch) override
+    {
+        if(!traits_type::eq_int_type(ch, traits_type::eof())) {
+            const auto byte = static_cast<std::uint8_t>(ch);
+            search_.feed(&byte, 1, offsets_);
+        }
+        return traits_type::not_eof(ch);
+    }
+
+private:
+    StreamSearch& search_;
+    std::vector<std::uint64_t>& offsets_;
+};
+
+CodecStats search_file_impl(const std::string& from, const std::string& pattern, std::vector<std::uint64_t>& offsets,
+                            const CodecOptions& options, StatsCollector& collector)
+{
+    collector.setDecompression(true);
+
+    const PatternSearcher searcher{pattern};
+    StreamSearch stream{searcher};
+
+    const bool isBlocksFile = is_blocks_file(from);
+    std::ifstream from_file(from, std::ios::in | std::ios::binary);
+    from_file.unsetf(std::ios::skipws);
+    if(!from_file) {
+        throw std::runtime_error{"Unable to open file: \"" + from + "\" to read"};
+    }
+
+    if(isBlocksFile) {
+        const auto findInBlock = [&searcher](PipelineBlock& block) {
+            StageTimer timer{Stage::Search};
+            block.matches.clear();
+            searcher.find(block.output.data(), block.output.size(), 0, block.matches);
+        };
+        const auto collectMatches = [&](const PipelineBlock& block) {
+            StageTimer timer{Stage::Search};
+            const auto base = stream.position();
+            stream.append(block.output.data(), block.output.size(), offsets);
+            for(const auto offset : block.matches) {
+                offsets.push_back(base + offset);
+            }
+        };
+
+        const auto blocksHeader = decode_blocks(from_file, options, directory_of(from), findInBlock, collectMatches);
+        return collector.finish(sizeof(BlocksHeader) + blocksHeader.payloadSize, blocksHeader.originalSize);
+    }
+
+    SearchStreamBuf searchBuf{stream, offsets};
+    std::ostream search_stream(&searchBuf);
+
+    HTree tree;
+    const auto header = read_header(from_file, tree);
+    if(is_stored(header)) {
+        copy_stored_data(from_file, search_stream);
+    }
+    else {
+        decompress_data_parallel(tree, from_file, search_stream, options.threadsCount, options.memoryBudget);
+    }
+
+    from_file.clear();
+    const auto bytesIn = static_cast<std::uint64_t>(from_file.seekg(0, std::ios::end).tellg());
+    return collector.finish(bytesIn, stream.position());
+}
+
+}
+
+PatternSearcher::PatternSearcher(const std::string& pattern)
+    : pattern_(pattern.cbegin(), pattern.cend())
+    , searcher_{pattern_.cbegin(), pattern_.cend()}
+{
+    if(pattern_.empty()) {
+        throw std::runtime_error{"Empty search pattern"};
+    }
+}
+
+void PatternSearcher::find(const std::uint8_t* data, std::size_t size, std::uint64_t base, std::vector<std::uint64_t>& offsets) const
+{
+    const auto* last = data + size;
+    for(auto* it = std::search(data, last, searcher_); it != last; it = std::search(it + 1, last, searcher_)) {
+        offsets.push_back(base + static_cast<std::uint64_t>(it - data));
+    }
+}
+
+StreamSearch::StreamSearch(const PatternSearcher& searcher)
+    : searcher_{searcher}
+{}
+
+void StreamSearch::append(const std::uint8_t* data, std::size_t size, std::vector<std::uint64_t>& offsets)
+{
+    const auto overlap = searcher_.size() - 1;
+
+    // a match starting in the tail ends within the first overlap bytes of the part
+    window_.assign(tail_.cbegin(), tail_.cend());
+    window_.insert(window_.cend(), data, data + std::min(size, overlap));
+    if(!tail_.empty()) {
+        const auto windowPosition = position_ - tail_.size();
+        matches_.clear();
+        searcher_.find(window_.data(), window_.size(), windowPosition, matches_);
+        for(const auto offset : matches_) {
+            if(offset < position_) {
+                offsets.push_back(offset);
+            }
+        }
+    }
+
+    if(size >= overlap) {
+        tail_.assign(data + size - overlap, data + size);
+    }
+    else {
+        tail_.assign(window_.cend() - std::ptrdiff_t(std::min(window_.size(), overlap)), window_.cend());
+    }
+    position_ += size;
+}
+
+void StreamSearch::feed(const std::uint8_t* data, std::size_t size, std::vector<std::uint64_t>& offsets)
+{
+    const auto base = position_;
+    append(data, size, offsets);
+    searcher_.find(data, size, base, offsets);
+}
+
+CodecStats search_file(const std::string& from, const std::string& pattern, std::vector<std::uint64_t>& offsets,
+                       const CodecOptions& options)
+{
+    StatsCollector collector;
+    StatsScope statsScope{&collector};
+
+    TraceRecorder recorder;
+    if(!options.tracePath.empty()) {
+        collector.setTraceRecorder(&recorder);
+    }
+
+    const auto stats = search_file_impl(from, pattern, offsets, options, collector);
+    if(!options.tracePath.empty()) {
+        recorder.save(options.tracePath);
+    }
+    return stats;
+}
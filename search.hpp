@@ -0,0 +1,58 @@
+#ifndef SEARCH_HPP
+#define SEARCH_HPP
+
+#include "huffmanencoding.hpp"
+
+#include <string>
+#include <vector>
+#include <functional>
+
+
+// Search of a byte string in a compressed file without writing the decompressed data.
+// Blocks are decoded to memory and searched by the pipeline workers in parallel,
+// the matches crossing the boundaries of blocks are found by the writer, which sees the blocks in order.
+
+// finds all occurrences of the pattern, overlapping ones too
+class PatternSearcher {
+public:
+    explicit PatternSearcher(const std::string& pattern);
+
+    PatternSearcher(const PatternSearcher&) = delete;
+    PatternSearcher& operator=(const PatternSearcher&) = delete;
+
+    std::size_t size() const { return pattern_.size(); }
+
+    // offsets of the matches within data plus base
+    void find(const std::uint8_t* data, std::size_t size, std::uint64_t base, std::vector<std::uint64_t>& offsets) const;
+
+private:
+    BytesBuffer pattern_;
+    std::boyer_moore_horspool_searcher<BytesBuffer::const_iterator> searcher_;
+};
+
+// follows the data given in parts and finds the matches crossing the boundaries of the parts
+class StreamSearch {
+public:
+    explicit StreamSearch(const PatternSearcher& searcher);
+
+    // the next part, the matches within it are left to PatternSearcher::find
+    void append(const std::uint8_t* data, std::size_t size, std::vector<std::uint64_t>& offsets);
+    // the next part, all matches
+    void feed(const std::uint8_t* data, std::size_t size, std::vector<std::uint64_t>& offsets);
+
+    std::uint64_t position() const { return position_; }
+
+private:
+    const PatternSearcher& searcher_;
+    BytesBuffer tail_;   // the last (pattern size - 1) bytes
+    BytesBuffer window_; // tail_ and the beginning of the part
+    std::vector<std::uint64_t> matches_;
+    std::uint64_t position_ = 0;
+};
+
+// offsets in the uncompressed data of all occurrences of pattern, in increasing order;
+// accepts both single stream ("HAFF") and blocks ("HAFB") files
+CodecStats search_file(const std::string& from, const std::string& pattern, std::vector<std::uint64_t>& offsets,
+                       const CodecOptions& options = CodecOptions());
+
+#endif // SEARCH_HPP
@@ -0,0 +1,115 @@
+#include "sha256.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+
+namespace {
+
+constexpr std::uint32_t ROUND_CONSTANTS[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+constexpr std::uint32_t rotate_right(std::uint32_t value, unsigned count) { return (value >> count) | (value << (32 - count)); }
+
+std::uint32_t load_big_endian(const std::uint8_t* ptr)
+{
+    return (std::uint32_t{ptr[0]} << 24) | (std::uint32_t{ptr[1]} << 16) | (std::uint32_t{ptr[2]} << 8) | ptr[3];
+}
+
+void store_big_endian(std::uint8_t* ptr, std::uint64_t value, std::size_t size)
+{
+    for(std::size_t index = size; index > 0; --index, value >>= 8) {
+        ptr[index - 1] = static_cast<std::uint8_t>(value);
+    }
+}
+
+}
+
+Sha256::Sha256()
+    : state_{0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19}
+{}
+
+void Sha256::update(const std::uint8_t* data, std::size_t size)
+{
+    totalSize_ += size;
+    if(bufferSize_ > 0) {
+        const auto count = std::min(size, buffer_.size() - bufferSize_);
+        std::memcpy(buffer_.data() + bufferSize_, data, count);
+        bufferSize_ += count;
+        data += count;
+        size -= count;
+        if(bufferSize_ < buffer_.size()) {
+            return;
+        }
+        processBlock(buffer_.data());
+        bufferSize_ = 0;
+    }
+
+    for(; size >= buffer_.size(); data += buffer_.size(), size -= buffer_.size()) {
+        processBlock(data);
+    }
+    if(size > 0) {
+        std::memcpy(buffer_.data(), data, size);
+        bufferSize_ = size;
+    }
+}
+
+Sha256Digest Sha256::finish()
+{
+    // 1 bit, zeros up to 56 bytes of the last block and the size in bits
+    const auto sizeInBits = totalSize_ * 8;
+    std::uint8_t padding[72]{0x80};
+    const auto paddingSize = ((bufferSize_ < 56) ? 56 : 120) - bufferSize_;
+    store_big_endian(padding + paddingSize, sizeInBits, sizeof(sizeInBits));
+    update(padding, paddingSize + sizeof(sizeInBits));
+
+    Sha256Digest result;
+    for(std::size_t index = 0; index < state_.size(); ++index) {
+        store_big_endian(result.data() + 4 * index, state_[index], 4);
+    }
+    return result;
+}
+
+void Sha256::processBlock(const std::uint8_t* block)
+{
+    std::uint32_t words[64];
+    for(std::size_t index = 0; index < 16; ++index) {
+        words[index] = load_big_endian(block + 4 * index);
+    }
+    for(std::size_t index = 16; index < 64; ++index) {
+        const auto s0 = rotate_right(words[index - 15], 7) ^ rotate_right(words[index - 15], 18) ^ (words[index - 15] >> 3);
+        const auto s1 = rotate_right(words[index - 2], 17) ^ rotate_right(words[index - 2], 19) ^ (words[index - 2] >> 10);
+        words[index] = words[index - 16] + s0 + words[index - 7] + s1;
+    }
+
+    auto a = state_[0], b = state_[1], c = state_[2], d = state_[3];
+    auto e = state_[4], f = state_[5], g = state_[6], h = state_[7];
+    for(std::size_t index = 0; index < 64; ++index) {
+        const auto s1 = rotate_right(e, 6) ^ rotate_right(e, 11) ^ rotate_right(e, 25);
+        const auto choice = (e & f) ^ (~e & g);
+        const auto temp1 = h + s1 + choice + ROUND_CONSTANTS[index] + words[index];
+        const auto s0 = rotate_right(a, 2) ^ rotate_right(a, 13) ^ rotate_right(a, 22);
+        const auto majority = (a & b) ^ (a & c) ^ (b & c);
+        const auto temp2 = s0 + majority;
+
+        h = g;
+        g = f;
+        f = e;
+        e = d + temp1;
+        d = c;
+        c = b;
+        b = a;
+        a = temp1 + temp2;
+    }
+
+    state_[0] += a; state_[1] += b; state_[2] += c; state_[3] += d;
+    state_[4] += e; state_[5] += f; state_[6] += g; state_[7] += h;
+}
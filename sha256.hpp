@@ -0,0 +1,36 @@
+#ifndef SHA256_HPP
+#define SHA256_HPP
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+
+using Sha256Digest = std::array<std::uint8_t, 32>;
+
+// SHA-256 (FIPS 180-4), incremental
+class Sha256 {
+public:
+    explicit Sha256();
+
+    void update(const std::uint8_t* data, std::size_t size);
+    Sha256Digest finish();
+
+private:
+    void processBlock(const std::uint8_t* block);
+
+private:
+    std::array<std::uint32_t, 8> state_;
+    std::array<std::uint8_t, 64> buffer_{};
+    std::size_t bufferSize_ = 0;
+    std::uint64_t totalSize_ = 0;
+};
+
+inline Sha256Digest sha256(const std::uint8_t* data, std::size_t size)
+{
+    Sha256 hash;
+    hash.update(data, size);
+    return hash.finish();
+}
+
+#endif // SHA256_HPP
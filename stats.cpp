@@ -0,0 +1,212 @@
+#include "stats.hpp"
+#include "trace.hpp"
+
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <ctime>
+
+
+namespace {
+
+thread_local StatsCollector* currentCollector = nullptr;
+
+double to_seconds(std::uint64_t ns) { return static_cast<double>(ns) / 1e9; }
+double to_megabytes(std::uint64_t bytes) { return static_cast<double>(bytes) / (1024.0 * 1024.0); }
+
+}
+
+const char* stage_name(Stage stage)
+{
+    switch(stage) {
+    case Stage::Read: return "read";
+    case Stage::Dedup: return "dedup";
+    case Stage::Transform: return "transform";
+    case Stage::Histogram: return "histogram";
+    case Stage::BuildTree: return "build tree";
+    case Stage::BuildDict: return "build dict";
+    case Stage::Encode: return "encode";
+    case Stage::Decode: return "decode";
+    case Stage::Search: return "search";
+    case Stage::Checksum: return "checksum";
+    case Stage::Write: return "write";
+    case Stage::Count: break;
+    }
+    return "unknown";
+}
+
+double CodecStats::bitsPerSymbol() const
+{
+    return originalSize() == 0 ? 0.0 : 8.0 * static_cast<double>(compressedSize()) / static_cast<double>(originalSize());
+}
+
+double CodecStats::megabytesPerSecond() const
+{
+    return wallNs == 0 ? 0.0 : static_cast<double>(originalSize()) / (1024.0 * 1024.0) / to_seconds(wallNs);
+}
+
+std::string format_stats(const CodecStats& stats)
+{
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(3);
+    out << "bytes in:        " << stats.bytesIn << '\n'
+        << "bytes out:       " << stats.bytesOut << '\n'
+        << "bits per symbol: " << stats.bitsPerSymbol() << '\n'
+        << "blocks:          " << stats.blocks << " (" << stats.storedBlocks << " stored, " << stats.deduplicatedBlocks << " deduplicated)\n"
+        << "threads:         " << stats.threadsCount << '\n'
+        << "wall time:       " << to_seconds(stats.wallNs) << " s (" << std::setprecision(1) << stats.megabytesPerSecond() << " MB/s)\n";
+    // the plan is an estimate, the allocations are measured only with HUFFMAN_ENABLE_ALLOC_STATS
+    if(stats.estimatedMemory != 0) {
+        out << "memory:          ";
+#ifdef HUFFMAN_ENABLE_ALLOC_STATS
+        out << to_megabytes(stats.peakAllocated) << " MB peak allocated, ";
+#endif
+        out << to_megabytes(stats.estimatedMemory) << " MB estimated";
+        if(stats.memoryBudget != 0) {
+            out << " (budget " << to_megabytes(stats.memoryBudget) << " MB)";
+        }
+        out << '\n';
+    }
+    if(!stats.tuning.empty()) {
+        out << "auto tune:       " << stats.tuning << '\n';
+    }
+
+#ifdef HUFFMAN_ENABLE_ALLOC_STATS
+    if(stats.peakRss != 0) {
+        out << "rss:             " << to_megabytes(stats.peakRss) << " MB peak (process max " << to_megabytes(stats.maxRss) << " MB)\n";
+    }
+    else {
+        out << "rss:             unavailable\n";
+    }
+    out << std::left << std::setw(12) << "allocations" << std::right
+        << std::setw(12) << "count" << std::setw(12) << "MB" << std::setw(12) << "peak, MB" << '\n';
+    for(std::size_t subsystemIndex = 0; subsystemIndex < ALLOC_SUBSYSTEMS_COUNT; ++subsystemIndex) {
+        const auto& allocations = stats.allocations[subsystemIndex];
+        out << std::left << std::setw(12) << alloc_subsystem_name(static_cast<AllocSubsystem>(subsystemIndex)) << std::right
+            << std::setw(12) << allocations.allocations
+            << std::setw(12) << to_megabytes(allocations.bytes)
+            << std::setw(12) << to_megabytes(allocations.peakBytes) << '\n';
+    }
+#endif
+
+#ifdef HUFFMAN_ENABLE_STATS
+    out << std::setprecision(3) << std::left << std::setw(12) << "stage" << std::right
+        << std::setw(12) << "wall, s" << std::setw(12) << "cpu, s" << std::setw(10) << "calls" << '\n';
+    for(std::size_t stageIndex = 0; stageIndex < STAGES_COUNT; ++stageIndex) {
+        const auto& stage = stats.stages[stageIndex];
+        if(stage.calls == 0) {
+            continue;
+        }
+        out << std::left << std::setw(12) << stage_name(static_cast<Stage>(stageIndex)) << std::right
+            << std::setw(12) << to_seconds(stage.wallNs)
+            << std::setw(12) << to_seconds(stage.cpuNs)
+            << std::setw(10) << stage.calls << '\n';
+    }
+#else
+    out << "(per stage timings are disabled, build with HUFFMAN_ENABLE_STATS)\n";
+#endif
+    return out.str();
+}
+
+
+StatsCollector::StatsCollector()
+    : start_{std::chrono::steady_clock::now()}
+{
+#ifdef HUFFMAN_ENABLE_ALLOC_STATS
+    reset_allocation_peaks();
+    allocationsStart_ = allocation_snapshot();
+    sampleRss();
+#endif
+}
+
+void StatsCollector::addStage(Stage stage, std::chrono::steady_clock::time_point start, std::uint64_t wallNs, std::uint64_t cpuNs)
+{
+    if(recorder_ != nullptr) {
+        recorder_->addSpan(stage, start, wallNs);
+    }
+
+    auto& stageStats = stages_[static_cast<std::size_t>(stage)];
+    stageStats.wallNs.fetch_add(wallNs, std::memory_order_relaxed);
+    stageStats.cpuNs.fetch_add(cpuNs, std::memory_order_relaxed);
+    stageStats.calls.fetch_add(1, std::memory_order_relaxed);
+}
+
+void StatsCollector::addBlock(bool stored, bool deduplicated)
+{
+    blocks_.fetch_add(1, std::memory_order_relaxed);
+    if(stored) {
+        storedBlocks_.fetch_add(1, std::memory_order_relaxed);
+    }
+    if(deduplicated) {
+        deduplicatedBlocks_.fetch_add(1, std::memory_order_relaxed);
+    }
+#ifdef HUFFMAN_ENABLE_ALLOC_STATS
+    sampleRss();
+#endif
+}
+
+void StatsCollector::sampleRss()
+{
+    const auto rss = current_rss();
+    auto peak = peakRss_.load(std::memory_order_relaxed);
+    while(peak < rss && !peakRss_.compare_exchange_weak(peak, rss, std::memory_order_relaxed)) {
+    }
+}
+
+CodecStats StatsCollector::finish(std::uint64_t bytesIn, std::uint64_t bytesOut) const
+{
+    CodecStats result;
+    for(std::size_t stageIndex = 0; stageIndex < STAGES_COUNT; ++stageIndex) {
+        result.stages[stageIndex].wallNs = stages_[stageIndex].wallNs.load(std::memory_order_relaxed);
+        result.stages[stageIndex].cpuNs = stages_[stageIndex].cpuNs.load(std::memory_order_relaxed);
+        result.stages[stageIndex].calls = stages_[stageIndex].calls.load(std::memory_order_relaxed);
+    }
+
+    const auto wall = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_);
+    result.wallNs = static_cast<std::uint64_t>(wall.count());
+    result.bytesIn = bytesIn;
+    result.bytesOut = bytesOut;
+    result.blocks = blocks_.load(std::memory_order_relaxed);
+    result.storedBlocks = storedBlocks_.load(std::memory_order_relaxed);
+    result.deduplicatedBlocks = deduplicatedBlocks_.load(std::memory_order_relaxed);
+    result.threadsCount = threadsCount_;
+    result.memoryBudget = memoryBudget_;
+    result.estimatedMemory = estimatedMemory_;
+    result.tuning = tuning_;
+#ifdef HUFFMAN_ENABLE_ALLOC_STATS
+    const auto allocations = allocation_snapshot();
+    for(std::size_t subsystemIndex = 0; subsystemIndex < ALLOC_SUBSYSTEMS_COUNT; ++subsystemIndex) {
+        result.allocations[subsystemIndex].allocations = allocations[subsystemIndex].allocations - allocationsStart_[subsystemIndex].allocations;
+        result.allocations[subsystemIndex].bytes = allocations[subsystemIndex].bytes - allocationsStart_[subsystemIndex].bytes;
+        result.allocations[subsystemIndex].peakBytes = allocations[subsystemIndex].peakBytes;
+    }
+    result.peakAllocated = allocation_peak();
+    result.peakRss = std::max(peakRss_.load(std::memory_order_relaxed), current_rss());
+    result.maxRss = max_rss();
+#endif
+    result.decompression = decompression_;
+    return result;
+}
+
+
+StatsScope::StatsScope(StatsCollector* collector)
+    : previous_{currentCollector}
+{
+    currentCollector = collector;
+}
+
+StatsScope::~StatsScope() { currentCollector = previous_; }
+
+StatsCollector* StatsScope::current() { return currentCollector; }
+
+
+std::uint64_t thread_cpu_time_ns()
+{
+#if defined(CLOCK_THREAD_CPUTIME_ID)
+    timespec time{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+    return static_cast<std::uint64_t>(time.tv_sec) * 1000000000ull + static_cast<std::uint64_t>(time.tv_nsec);
+#else
+    return static_cast<std::uint64_t>(std::clock()) * (1000000000ull / CLOCKS_PER_SEC);
+#endif
+}
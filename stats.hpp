@@ -0,0 +1,174 @@
+#ifndef STATS_HPP
+#define STATS_HPP
+
+#include "allocstats.hpp"
+
+#include <array>
+#include <atomic>
+#include <string>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+
+
+// Build with HUFFMAN_ENABLE_STATS defined (CONFIG += huffman_stats) to measure stages,
+// otherwise StageTimer is empty and only byte counters are collected.
+// With HUFFMAN_ENABLE_ALLOC_STATS the allocations of the operation and the process RSS are collected too.
+
+enum class Stage : std::uint8_t {
+    Read,
+    Dedup,
+    Transform,
+    Histogram,
+    BuildTree,
+    BuildDict,
+    Encode,
+    Decode,
+    Search,
+    Checksum,
+    Write,
+    Count
+};
+
+constexpr auto STAGES_COUNT = static_cast<std::size_t>(Stage::Count);
+const char* stage_name(Stage stage);
+
+struct StageStats {
+    std::uint64_t wallNs = 0; // суммарно по всем потокам
+    std::uint64_t cpuNs = 0;
+    std::uint64_t calls = 0;
+};
+
+struct CodecStats {
+    std::array<StageStats, STAGES_COUNT> stages{};
+    std::uint64_t wallNs = 0;          // время всей операции
+    std::uint64_t bytesIn = 0;
+    std::uint64_t bytesOut = 0;
+    std::uint64_t blocks = 0;
+    std::uint64_t storedBlocks = 0;
+    std::uint64_t deduplicatedBlocks = 0;
+    std::uint64_t memoryBudget = 0;    // 0 - без ограничения
+    std::uint64_t estimatedMemory = 0; // рабочая память по плану (memorybudget.hpp), 0 - неизвестна
+    AllocSnapshot allocations{};       // выделения за операцию, по подсистемам
+    std::uint64_t peakAllocated = 0;   // максимум живых выделений всех подсистем вместе
+    std::uint64_t peakRss = 0;         // максимум из замеров RSS за операцию
+    std::uint64_t maxRss = 0;          // максимум RSS процесса за всё время
+    std::string tuning;                // выбор автонастройки (autotune.hpp), пусто - без неё
+    unsigned threadsCount = 0;
+    bool decompression = false;
+
+    const StageStats& stage(Stage s) const { return stages[static_cast<std::size_t>(s)]; }
+    std::uint64_t originalSize() const { return decompression ? bytesOut : bytesIn; }
+    std::uint64_t compressedSize() const { return decompression ? bytesIn : bytesOut; }
+    // bits of compressed data per source symbol (byte)
+    double bitsPerSymbol() const;
+    // throughput by uncompressed data
+    double megabytesPerSecond() const;
+};
+
+std::string format_stats(const CodecStats& stats);
+
+
+class TraceRecorder;
+
+// Thread safe accumulator of CodecStats, optionally forwards stage spans to the trace
+class StatsCollector {
+public:
+    explicit StatsCollector();
+
+    void addStage(Stage stage, std::chrono::steady_clock::time_point start, std::uint64_t wallNs, std::uint64_t cpuNs);
+    void addBlock(bool stored, bool deduplicated = false);
+    void setThreadsCount(unsigned threadsCount) { threadsCount_ = threadsCount; }
+    void setMemoryBudget(std::uint64_t budget) { memoryBudget_ = budget; }
+    void setEstimatedMemory(std::uint64_t memory) { estimatedMemory_ = memory; }
+    void setTuning(const std::string& tuning) { tuning_ = tuning; }
+    void setDecompression(bool decompression) { decompression_ = decompression; }
+    void setTraceRecorder(TraceRecorder* recorder) { recorder_ = recorder; }
+    TraceRecorder* traceRecorder() const { return recorder_; }
+
+    // bytesIn/bytesOut are known by the caller at the end
+    CodecStats finish(std::uint64_t bytesIn, std::uint64_t bytesOut) const;
+
+private:
+    void sampleRss();
+
+    struct AtomicStageStats {
+        std::atomic<std::uint64_t> wallNs{0};
+        std::atomic<std::uint64_t> cpuNs{0};
+        std::atomic<std::uint64_t> calls{0};
+    };
+
+private:
+    std::chrono::steady_clock::time_point start_;
+    std::array<AtomicStageStats, STAGES_COUNT> stages_;
+    std::atomic<std::uint64_t> blocks_{0};
+    std::atomic<std::uint64_t> storedBlocks_{0};
+    std::atomic<std::uint64_t> deduplicatedBlocks_{0};
+    AllocSnapshot allocationsStart_{};
+    std::atomic<std::uint64_t> peakRss_{0};
+    std::uint64_t memoryBudget_ = 0;
+    std::uint64_t estimatedMemory_ = 0;
+    std::string tuning_;
+    unsigned threadsCount_ = 0;
+    bool decompression_ = false;
+    TraceRecorder* recorder_ = nullptr;
+};
+
+// Binds the collector to the current thread while alive, stages measured on this thread go to it
+class StatsScope {
+public:
+    explicit StatsScope(StatsCollector* collector);
+    ~StatsScope();
+
+    StatsScope(const StatsScope&) = delete;
+    StatsScope& operator=(const StatsScope&) = delete;
+
+    static StatsCollector* current();
+
+private:
+    StatsCollector* previous_ = nullptr;
+};
+
+std::uint64_t thread_cpu_time_ns();
+
+#ifdef HUFFMAN_ENABLE_STATS
+
+class StageTimer {
+public:
+    explicit StageTimer(Stage stage)
+        : collector_{StatsScope::current()}
+        , stage_{stage}
+    {
+        if(collector_ != nullptr) {
+            startWall_ = std::chrono::steady_clock::now();
+            startCpu_ = thread_cpu_time_ns();
+        }
+    }
+    ~StageTimer()
+    {
+        if(collector_ != nullptr) {
+            const auto wall = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startWall_);
+            collector_->addStage(stage_, startWall_, static_cast<std::uint64_t>(wall.count()), thread_cpu_time_ns() - startCpu_);
+        }
+    }
+
+    StageTimer(const StageTimer&) = delete;
+    StageTimer& operator=(const StageTimer&) = delete;
+
+private:
+    StatsCollector* collector_ = nullptr;
+    Stage stage_;
+    std::chrono::steady_clock::time_point startWall_;
+    std::uint64_t startCpu_ = 0;
+};
+
+#else
+
+class StageTimer {
+public:
+    explicit StageTimer(Stage) {}
+};
+
+#endif // HUFFMAN_ENABLE_STATS
+
+#endif // STATS_HPP
@@ -0,0 +1,184 @@
+#include "streamcodec.hpp"
+#include "dedup.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+
+
+namespace {
+
+template<class T>
+void append(BytesBuffer& buffer, const T& data)
+{
+    const auto* bytes = reinterpret_cast<const std::uint8_t*>(&data);
+    buffer.insert(buffer.cend(), bytes, bytes + sizeof(T));
+}
+
+// moves what fits to the output, the buffer is cleared when it is taken whole
+void drain(BytesBuffer& buffer, std::size_t& first, StreamBuffers& buffers, std::uint64_t& totalOut)
+{
+    const auto count = std::min(buffer.size() - first, buffers.availOut);
+    std::copy_n(buffer.cbegin() + std::ptrdiff_t(first), count, buffers.nextOut);
+    buffers.nextOut += count;
+    buffers.availOut -= count;
+    totalOut += count;
+
+    first += count;
+    if(first == buffer.size()) {
+        buffer.clear();
+        first = 0;
+    }
+}
+
+// takes at most count bytes of the input to the buffer
+void take(BytesBuffer& buffer, std::size_t count, StreamBuffers& buffers, std::uint64_t& totalIn)
+{
+    count = std::min(count, buffers.availIn);
+    buffer.insert(buffer.cend(), buffers.nextIn, buffers.nextIn + count);
+    buffers.nextIn += count;
+    buffers.availIn -= count;
+    totalIn += count;
+}
+
+}
+
+StreamEncoder::StreamEncoder(const CodecOptions& options)
+    : options_{options}
+{
+    append(pending_, make_blocks_header(options_));
+}
+
+StreamStatus StreamEncoder::encode(StreamBuffers& buffers, StreamFlush flush)
+{
+    while(true) {
+        drain(pending_, pendingFirst_, buffers, totalOut_);
+        if(!pending_.empty()) {
+            return StreamStatus::Ok;
+        }
+        if(finished_) {
+            return StreamStatus::StreamEnd;
+        }
+
+        if(buffers.availIn > 0) {
+            take(block_, options_.blockSize - block_.size(), buffers, totalIn_);
+            if(block_.size() == options_.blockSize) {
+                encodeBlock();
+            }
+            continue;
+        }
+
+        // all input is taken
+        if(flush == StreamFlush::None) {
+            return StreamStatus::Ok;
+        }
+        if(!block_.empty()) {
+            encodeBlock();
+            continue;
+        }
+        if(flush == StreamFlush::Finish) {
+            writeEndMark();
+            finished_ = true;
+            continue;
+        }
+        return StreamStatus::Ok;
+    }
+}
+
+void StreamEncoder::encodeBlock()
+{
+    const auto header = encode_part(block_.data(), block_.size(), payload_, options_);
+    const auto& payload = (header.type == BlockType::Stored) ? block_ : payload_;
+
+    append(pending_, header);
+    pending_.insert(pending_.cend(), payload.cbegin(), payload.cbegin() + std::ptrdiff_t(header.packedSize));
+    block_.clear();
+}
+
+void StreamEncoder::writeEndMark()
+{
+    // the empty stored block, the checksum of no data is 0
+    append(pending_, BlockHeader{});
+}
+
+StreamDecoder::StreamDecoder(const std::string& referencesDirectory)
+    : referencesDirectory_{referencesDirectory}
+{}
+
+StreamStatus StreamDecoder::decode(StreamBuffers& buffers)
+{
+    while(true) {
+        drain(output_, outputFirst_, buffers, totalOut_);
+        if(!output_.empty()) {
+            return StreamStatus::Ok;
+        }
+
+        switch(state_) {
+        case State::BlocksHeader:
+            if(!gather(buffers, sizeof(BlocksHeader))) {
+                return StreamStatus::Ok;
+            }
+            std::memcpy(&blocksHeader_, input_.data(), sizeof(BlocksHeader));
+            input_.clear();
+            check_blocks_header(blocksHeader_);
+            state_ = State::BlockHeader;
+            break;
+
+        case State::BlockHeader:
+            if(payloadSize_ == blocksHeader_.payloadSize) {
+                state_ = State::End;
+                break;
+            }
+            if(!gather(buffers, sizeof(BlockHeader))) {
+                return StreamStatus::Ok;
+            }
+            readBlockHeader();
+            break;
+
+        case State::Payload:
+            if(!gather(buffers, header_.packedSize)) {
+                return StreamStatus::Ok;
+            }
+            decodePayload();
+            break;
+
+        case State::End:
+            if(blocksHeader_.originalSize != UNKNOWN_SIZE && totalOut_ != blocksHeader_.originalSize) {
+                throw std::runtime_error{"Size of decompressed data doesn't match the header"};
+            }
+            return StreamStatus::StreamEnd;
+        }
+    }
+}
+
+bool StreamDecoder::gather(StreamBuffers& buffers, std::size_t size)
+{
+    take(input_, size - input_.size(), buffers, totalIn_);
+    return input_.size() == size;
+}
+
+void StreamDecoder::readBlockHeader()
+{
+    std::memcpy(&header_, input_.data(), sizeof(BlockHeader));
+    input_.clear();
+    if(header_.rawSize > blocksHeader_.blockSize || header_.packedSize > header_.rawSize) {
+        throw std::runtime_error{"Corrupted block header"};
+    }
+
+    payloadSize_ += sizeof(BlockHeader);
+    state_ = is_end_mark(header_) ? State::End : State::Payload;
+}
+
+void StreamDecoder::decodePayload()
+{
+    if(header_.type == BlockType::Reference) {
+        decode_reference(header_, input_, referencesDirectory_, output_);
+    }
+    else {
+        decode_block(header_, input_, output_);
+    }
+    input_.clear();
+
+    payloadSize_ += header_.packedSize;
+    state_ = State::BlockHeader;
+}
@@ -0,0 +1,99 @@
+#ifndef STREAMCODEC_HPP
+#define STREAMCODEC_HPP
+
+#include "huffmanencoding.hpp"
+
+#include <string>
+
+
+// Incremental codec of the blocks format for event loops: no threads and no blocking,
+// input is taken in chunks of any size and output is given to buffers of any size (as zlib z_stream).
+// The state between the calls is the block being gathered and the output not taken yet.
+// The encoded stream has unknown sizes in BlocksHeader and ends with the empty block (see blockcodec.hpp),
+// decompress_blocks reads it as well.
+
+enum class StreamFlush {
+    None,   // blocks are encoded when filled
+    Flush,  // the input given so far is encoded, so the decoder can restore all of it
+    Finish  // the end of the input
+};
+
+enum class StreamStatus {
+    Ok,
+    StreamEnd // the stream is finished and all its output is taken
+};
+
+// the buffers of one call, advanced by the codec
+struct StreamBuffers {
+    const std::uint8_t* nextIn = nullptr;
+    std::size_t availIn = 0;
+    std::uint8_t* nextOut = nullptr;
+    std::size_t availOut = 0;
+};
+
+class StreamEncoder {
+public:
+    // blockSize limits the work of one call too, the pipeline options (threads, io, dedup) are not used
+    explicit StreamEncoder(const CodecOptions& options = CodecOptions());
+
+    // Takes all input unless the output is full. Flush and Finish are done when availOut is left
+    // not zero, otherwise the call is repeated with the same flush and more room for the output
+    StreamStatus encode(StreamBuffers& buffers, StreamFlush flush = StreamFlush::None);
+
+    std::uint64_t totalIn() const { return totalIn_; }
+    std::uint64_t totalOut() const { return totalOut_; }
+
+private:
+    void encodeBlock();
+    void writeEndMark();
+
+private:
+    CodecOptions options_;
+    BytesBuffer block_;       // input of the next block
+    BytesBuffer payload_;
+    BytesBuffer pending_;     // encoded data not taken yet
+    std::size_t pendingFirst_ = 0;
+    std::uint64_t totalIn_ = 0;
+    std::uint64_t totalOut_ = 0;
+    bool finished_ = false;
+};
+
+class StreamDecoder {
+public:
+    // referenced archives are looked for in referencesDirectory (see dedup.hpp)
+    explicit StreamDecoder(const std::string& referencesDirectory = ".");
+
+    // Takes input while there is room in the output, throws on corrupted data.
+    // Accepts the streams of StreamEncoder and blocks files with known sizes.
+    StreamStatus decode(StreamBuffers& buffers);
+
+    std::uint64_t totalIn() const { return totalIn_; }
+    std::uint64_t totalOut() const { return totalOut_; }
+
+private:
+    enum class State {
+        BlocksHeader,
+        BlockHeader,
+        Payload,
+        End
+    };
+
+    // gathers input_ up to size bytes, true when it is complete
+    bool gather(StreamBuffers& buffers, std::size_t size);
+    void readBlockHeader();
+    void decodePayload();
+
+private:
+    std::string referencesDirectory_;
+    State state_ = State::BlocksHeader;
+    BlocksHeader blocksHeader_;
+    BlockHeader header_;
+    BytesBuffer input_;       // the part of the header or payload being gathered
+    BytesBuffer output_;      // decoded data not taken yet
+    std::size_t outputFirst_ = 0;
+    std::uint64_t payloadSize_ = 0;
+    std::uint64_t totalIn_ = 0;
+    std::uint64_t totalOut_ = 0;
+};
+
+#endif // STREAMCODEC_HPP
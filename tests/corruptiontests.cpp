@@ -0,0 +1,152 @@
+#include "testing.hpp"
+#include "testdata.hpp"
+#include "verify.hpp"
+
+#include <cstring>
+
+
+namespace {
+
+CodecOptions make_options(BlockTransform transform)
+{
+    CodecOptions options;
+    options.blockSize = 8 * 1024;
+    options.transform = transform;
+    options.threadsCount = 2;
+    return options;
+}
+
+// an archive with blocks of every type but Reference (see deduptests.cpp)
+std::vector<BytesBuffer> make_archives()
+{
+    return {
+        compress(make_text(30000), make_options(BlockTransform::None)),
+        compress(make_text(30000), make_options(BlockTransform::Bwt)),
+        compress(make_text(30000), make_options(BlockTransform::Lz77)),
+        compress(make_words(30000), make_options(BlockTransform::Words)),
+        compress(make_random(30000), make_options(BlockTransform::None))
+    };
+}
+
+// both decoders must throw
+void check_rejected(const BytesBuffer& archive, const char* text = "")
+{
+    CHECK_THROWS_WITH(decompress(archive), text);
+    CHECK_THROWS_WITH(stream_decompress(archive, 4096, 4096), text);
+}
+
+void set_header(BytesBuffer& archive, const ArchiveBlock& block)
+{
+    std::memcpy(archive.data() + block.offset, &block.header, sizeof(block.header));
+}
+
+}
+
+TEST_CASE(corrupted_payloads_are_rejected)
+{
+    for(const auto& archive : make_archives()) {
+        const auto blocks = archive_blocks(archive);
+        REQUIRE(blocks.size() > 1);
+        for(const auto& block : blocks) {
+            auto corrupted = archive;
+            corrupted[block.offset + sizeof(BlockHeader) + block.header.packedSize / 2] ^= 0x55;
+            check_rejected(corrupted);
+        }
+    }
+}
+
+TEST_CASE(checksum_mismatch_is_rejected)
+{
+    for(const auto& archive : make_archives()) {
+        auto block = archive_blocks(archive).front();
+        block.header.checksum ^= 1;
+        auto corrupted = archive;
+        set_header(corrupted, block);
+        check_rejected(corrupted, "checksum");
+    }
+}
+
+TEST_CASE(corrupted_block_headers_are_rejected)
+{
+    const auto archive = compress(make_text(30000), make_options(BlockTransform::None));
+    const auto first = archive_blocks(archive).front();
+
+    auto block = first;
+    block.header.rawSize = 8 * 1024 + 1; // more than the block size
+    auto corrupted = archive;
+    set_header(corrupted, block);
+    check_rejected(corrupted, "Corrupted block");
+
+    block = first;
+    block.header.type = static_cast<BlockType>(9);
+    corrupted = archive;
+    set_header(corrupted, block);
+    check_rejected(corrupted, "Corrupted block");
+
+    // the other types don't parse as a Huffman payload
+    for(const auto type : {BlockType::Stored, BlockType::Bwt, BlockType::Lz77, BlockType::Words, BlockType::Reference}) {
+        block = first;
+        block.header.type = type;
+        corrupted = archive;
+        set_header(corrupted, block);
+        check_rejected(corrupted);
+    }
+}
+
+TEST_CASE(truncated_archives_are_rejected)
+{
+    const auto archive = compress(make_text(30000), make_options(BlockTransform::Lz77));
+    const auto blocks = archive_blocks(archive);
+    const std::size_t sizes[] = {
+        0,
+        sizeof(BlocksHeader) / 2,
+        sizeof(BlocksHeader),                          // no blocks
+        blocks[1].offset + sizeof(BlockHeader) / 2,    // in a block header
+        blocks[1].offset + sizeof(BlockHeader) + 10,   // in a payload
+        blocks.back().offset,                          // without the last block
+        archive.size() - 1
+    };
+    for(const auto size : sizes) {
+        check_rejected(BytesBuffer(archive.cbegin(), archive.cbegin() + std::ptrdiff_t(size)));
+    }
+}
+
+TEST_CASE(invalid_blocks_headers_are_rejected)
+{
+    const auto archive = compress(make_text(30000), make_options(BlockTransform::None));
+    BlocksHeader blocksHeader;
+    std::memcpy(&blocksHeader, archive.data(), sizeof(blocksHeader));
+
+    auto corrupted = archive;
+    corrupted[0] = 'X';
+    check_rejected(corrupted, "Invalid file format");
+
+    auto header = blocksHeader;
+    header.version = BLOCKS_FORMAT_VERSION + 1;
+    corrupted = archive;
+    std::memcpy(corrupted.data(), &header, sizeof(header));
+    check_rejected(corrupted, "Unsupported format version");
+
+    header = blocksHeader;
+    header.originalSize += 1;
+    corrupted = archive;
+    std::memcpy(corrupted.data(), &header, sizeof(header));
+    check_rejected(corrupted, "doesn't match the header");
+}
+
+TEST_CASE(verify_reports_corrupted_files)
+{
+    TempDirectory directory;
+    auto archive = compress(make_text(30000), make_options(BlockTransform::Bwt));
+    write_file(directory.file("good"), archive);
+    const auto block = archive_blocks(archive).back();
+    archive[block.offset + sizeof(BlockHeader) + block.header.packedSize / 2] ^= 0x55;
+    write_file(directory.file("bad"), archive);
+
+    const auto report = verify_files({directory.file("good"), directory.file("bad"), directory.file("missing")});
+    REQUIRE(report.files.size() == 3);
+    CHECK(report.files[0].passed);
+    CHECK(!report.files[1].passed && !report.files[1].error.empty());
+    CHECK(!report.files[2].passed);
+    CHECK(!report.passed());
+}
@@ -0,0 +1,102 @@
+#include "testing.hpp"
+#include "testdata.hpp"
+#include "dedup.hpp"
+
+
+namespace {
+
+// the archives of nightly snapshots: the second one has an edit in the middle of the first
+struct Snapshots {
+    TempDirectory directory;
+    BytesBuffer first = make_text(1500000);
+    BytesBuffer second;
+    CodecOptions options;
+
+    Snapshots()
+    {
+        second = first;
+        const auto edit = make_random(3000, 7);
+        second.insert(second.begin() + std::ptrdiff_t(second.size() / 2), edit.cbegin(), edit.cend());
+        write_file(directory.file("first"), first);
+        write_file(directory.file("second"), second);
+
+        options.threadsCount = 2;
+        options.dedupIndex = directory.file("index");
+    }
+
+    void compress(const std::string& from, const std::string& to) const
+    {
+        compress_file(directory.file(from), directory.file(to), options);
+    }
+};
+
+BlockHeader reference_header(const BytesBuffer& payload)
+{
+    BlockHeader header;
+    header.type = BlockType::Reference;
+    header.rawSize = 1;
+    header.packedSize = static_cast<std::uint32_t>(payload.size());
+    return header;
+}
+
+}
+
+TEST_CASE(deduplicated_archives_roundtrip)
+{
+    Snapshots snapshots;
+    snapshots.compress("first", "first.haf");
+    snapshots.compress("second", "second.haf");
+
+    const auto firstArchive = read_file(snapshots.directory.file("first.haf"));
+    const auto secondArchive = read_file(snapshots.directory.file("second.haf"));
+    CHECK(!has_block_type(firstArchive, BlockType::Reference));
+    CHECK(has_block_type(secondArchive, BlockType::Reference));
+    CHECK(secondArchive.size() < firstArchive.size() / 4);
+
+    decompress_file(snapshots.directory.file("second.haf"), snapshots.directory.file("second.out"));
+    CHECK(read_file(snapshots.directory.file("second.out")) == snapshots.second);
+    // the referenced archives are looked for next to the archive, not in the current directory
+    CHECK_THROWS_WITH(decompress(secondArchive), "no archive");
+    CHECK(decompress(secondArchive, CodecOptions(), snapshots.directory.path()) == snapshots.second);
+}
+
+TEST_CASE(referenced_archives_are_not_overwritten)
+{
+    Snapshots snapshots;
+    snapshots.compress("first", "first.haf");
+    snapshots.compress("second", "second.haf");
+
+    CHECK_THROWS_WITH(snapshots.compress("second", "first.haf"), "can't be overwritten");
+    // the archive with the references may be replaced
+    snapshots.compress("second", "second.haf");
+
+    decompress_file(snapshots.directory.file("second.haf"), snapshots.directory.file("second.out"));
+    CHECK(read_file(snapshots.directory.file("second.out")) == snapshots.second);
+    CHECK(ChunkIndex{snapshots.directory.file("index")}.chunksCount() > 0);
+}
+
+TEST_CASE(references_to_other_directories_are_rejected)
+{
+    TempDirectory directory;
+    ChunkIndex index{directory.file("index")};
+    for(const char* name : {"../first.haf", "sub/first.haf", "sub\\first.haf", "c:first.haf", ""}) {
+        CHECK_THROWS_WITH(index.setArchive(name), "Invalid archive name");
+
+        ChunkLocation location;
+        location.archive = name;
+        BytesBuffer payload;
+        write_reference(Sha256Digest{}, location, payload);
+        BytesBuffer output;
+        CHECK_THROWS_WITH(decode_reference(reference_header(payload), payload, directory.path(), output), "Invalid block reference");
+    }
+
+    ChunkLocation location;
+    location.archive = "missing.haf";
+    BytesBuffer payload;
+    write_reference(Sha256Digest{}, location, payload);
+    BytesBuffer output;
+    CHECK_THROWS_WITH(decode_reference(reference_header(payload), payload, directory.path(), output), "no archive");
+
+    payload.pop_back();
+    CHECK_THROWS_WITH(decode_reference(reference_header(payload), payload, directory.path(), output), "corrupted");
+}
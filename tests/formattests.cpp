@@ -0,0 +1,141 @@
+#include "testing.hpp"
+#include "testdata.hpp"
+#include "streamcodec.hpp"
+#include "paralleldecoder.hpp"
+#include "encodetable.hpp"
+#include "verify.hpp"
+
+#include <sstream>
+#include <cstddef>
+#include <cstring>
+
+
+// The files of data/ are archives of the released format and must be read by all later builds:
+// sample.haf is sample.bin in blocks of 1024 bytes (Huffman and Stored),
+// transforms-*.haf are transforms.bin in blocks of 1024 bytes with --bwt, --lz77 and --words,
+// sample.haff is sample.bin in a single Huffman stream, as the builds before the blocks format wrote it.
+
+namespace {
+
+BytesBuffer read_data(const std::string& name) { return read_file(std::string{TESTS_DATA_DIR} + '/' + name); }
+
+}
+
+TEST_CASE(layouts_of_the_format)
+{
+    CHECK(BLOCKS_FORMAT_VERSION == 3);
+    CHECK(sizeof(BlocksHeader) == 32);
+    CHECK(sizeof(BlockHeader) == 16);
+
+    CHECK(offsetof(BlocksHeader, version) == 4);
+    CHECK(offsetof(BlocksHeader, blockSize) == 8);
+    CHECK(offsetof(BlocksHeader, flags) == 12);
+    CHECK(offsetof(BlocksHeader, originalSize) == 16);
+    CHECK(offsetof(BlocksHeader, payloadSize) == 24);
+    CHECK(offsetof(BlockHeader, type) == 8);
+    CHECK(offsetof(BlockHeader, checksum) == 12);
+
+    CHECK(static_cast<int>(BlockType::Stored) == 0 && static_cast<int>(BlockType::Huffman) == 1);
+    CHECK(static_cast<int>(BlockType::Bwt) == 2 && static_cast<int>(BlockType::Lz77) == 3);
+    CHECK(static_cast<int>(BlockType::Reference) == 4 && static_cast<int>(BlockType::Words) == 5);
+    CHECK(BLOCKS_FLAG_BWT == 1 && BLOCKS_FLAG_LZ77 == 2 && BLOCKS_FLAG_REFERENCES == 4 && BLOCKS_FLAG_WORDS == 8);
+}
+
+TEST_CASE(archives_of_the_format_are_read)
+{
+    TempDirectory directory;
+    const auto sample = read_data("sample.bin");
+    const auto archive = read_data("sample.haf");
+
+    BlocksHeader blocksHeader;
+    REQUIRE(archive.size() >= sizeof(blocksHeader));
+    std::memcpy(&blocksHeader, archive.data(), sizeof(blocksHeader));
+    CHECK(blocksHeader.blockSize == 1024);
+    CHECK(blocksHeader.flags == 0);
+    CHECK(blocksHeader.originalSize == sample.size());
+    CHECK(blocksHeader.payloadSize == archive.size() - sizeof(BlocksHeader));
+    CHECK(has_block_type(archive, BlockType::Huffman) && has_block_type(archive, BlockType::Stored));
+
+    for(const unsigned threadsCount : {1u, 3u}) {
+        CodecOptions options;
+        options.threadsCount = threadsCount;
+        CHECK(decompress(archive, options) == sample);
+    }
+    CHECK(stream_decompress(archive, 100, 100) == sample);
+
+    write_file(directory.file("sample.haf"), archive);
+    decompress_file(directory.file("sample.haf"), directory.file("output"));
+    CHECK(read_file(directory.file("output")) == sample);
+
+    const auto transforms = read_data("transforms.bin");
+    const std::pair<const char*, BlockType> files[] = {
+        {"transforms-bwt.haf", BlockType::Bwt},
+        {"transforms-lz77.haf", BlockType::Lz77},
+        {"transforms-words.haf", BlockType::Words}
+    };
+    for(const auto& file : files) {
+        const auto transformed = read_data(file.first);
+        CHECK(has_block_type(transformed, file.second));
+        CHECK(decompress(transformed) == transforms);
+        CHECK(stream_decompress(transformed, 100, 100) == transforms);
+    }
+}
+
+TEST_CASE(other_versions_are_rejected)
+{
+    const auto archive = read_data("sample.haf");
+    for(const std::uint16_t version : {0, 1, 2, 4}) {
+        auto corrupted = archive;
+        std::memcpy(corrupted.data() + offsetof(BlocksHeader, version), &version, sizeof(version));
+        CHECK_THROWS_WITH(decompress(corrupted), "Unsupported format version");
+        CHECK_THROWS_WITH(stream_decompress(corrupted, 100, 100), "Unsupported format version");
+    }
+}
+
+TEST_CASE(single_stream_files_are_read)
+{
+    TempDirectory directory;
+    const auto sample = read_data("sample.bin");
+    write_file(directory.file("sample.haff"), read_data("sample.haff"));
+
+    // stored data follows the header without a table
+    const auto random = make_random(5000);
+    HuffmanHeader header;
+    std::memcpy(header.header, "HAFF", sizeof(header.header));
+    header.offset = sizeof(header);
+    BytesBuffer stored(sizeof(header));
+    std::memcpy(stored.data(), &header, sizeof(header));
+    stored.insert(stored.end(), random.cbegin(), random.cend());
+    write_file(directory.file("random.haff"), stored);
+
+    for(const unsigned threadsCount : {1u, 4u}) {
+        CodecOptions options;
+        options.threadsCount = threadsCount;
+        decompress_file(directory.file("sample.haff"), directory.file("sample.out"), options);
+        CHECK(read_file(directory.file("sample.out")) == sample);
+        decompress_file(directory.file("random.haff"), directory.file("random.out"), options);
+        CHECK(read_file(directory.file("random.out")) == random);
+    }
+    CHECK(verify_file(directory.file("sample.haff")).passed);
+}
+
+TEST_CASE(single_streams_are_decoded_in_parallel)
+{
+    // long enough for several parts, decoded speculatively from arbitrary bits
+    const auto text = make_text(3000000);
+    HTree tree;
+    tree.setData(text.cbegin(), text.cend());
+
+    const auto bitsCount = tree.encodedBitsCount();
+    BytesBuffer data((bitsCount + BITS_IN_BYTE - 1) / BITS_IN_BYTE + sizeof(std::uint64_t));
+    BitWriter writer(data.data());
+    EncodeTable{tree.huffmanDict(), text.size()}.encode(text.data(), text.data() + text.size(), writer);
+    writer.finish();
+
+    for(const unsigned threadsCount : {1u, 4u}) {
+        std::ostringstream output(std::ios::out | std::ios::binary);
+        decode_stream_parallel(tree.huffmanDict(), data.data(), bitsCount, output, threadsCount);
+        const auto decoded = output.str();
+        CHECK(BytesBuffer(decoded.cbegin(), decoded.cend()) == text);
+    }
+}
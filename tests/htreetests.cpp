@@ -0,0 +1,83 @@
+#include "testing.hpp"
+#include "testdata.hpp"
+#include "htree.hpp"
+#include "allocstats.hpp"
+
+#include <queue>
+#include <vector>
+#include <functional>
+
+
+namespace {
+
+std::vector<CharFrequencies> make_frequencies()
+{
+    std::vector<CharFrequencies> result;
+    for(const auto& data : {make_text(5000), make_random(5000), make_words(5001), BytesBuffer(100, 'a'), BytesBuffer{'a', 'b'}}) {
+        result.push_back(count_frequencies(data.cbegin(), data.cend()));
+    }
+    // the deepest tree, codes of up to 24 bits
+    CharFrequencies fibonacci{0};
+    fibonacci[0] = fibonacci[1] = 1;
+    for(std::size_t symbol = 2; symbol < 25; ++symbol) {
+        fibonacci[symbol] = fibonacci[symbol - 1] + fibonacci[symbol - 2];
+    }
+    result.push_back(fibonacci);
+    return result;
+}
+
+// the cost of the optimal code by the textbook algorithm
+std::uint64_t optimal_bits_count(const CharFrequencies& frequencies)
+{
+    std::priority_queue<std::uint64_t, std::vector<std::uint64_t>, std::greater<>> weights;
+    for(const auto frequency : frequencies) {
+        if(frequency != 0) {
+            weights.push(frequency);
+        }
+    }
+    if(weights.size() == 1) {
+        return weights.top();
+    }
+    std::uint64_t result = 0;
+    while(weights.size() > 1) {
+        const auto first = weights.top();
+        weights.pop();
+        const auto second = weights.top();
+        weights.pop();
+        result += first + second;
+        weights.push(first + second);
+    }
+    return result;
+}
+
+}
+
+TEST_CASE(trees_have_optimal_codes)
+{
+    for(const auto& frequencies : make_frequencies()) {
+        HTree tree;
+        tree.setFrequencies(frequencies);
+        CHECK(tree.encodedBitsCount() == optimal_bits_count(frequencies));
+    }
+}
+
+TEST_CASE(trees_are_built_without_allocations)
+{
+#ifdef HUFFMAN_ENABLE_ALLOC_STATS
+    const auto frequencies = make_frequencies();
+    HTree tree;
+    // the nodes and the dictionary of the tree are allocated once
+    tree.setFrequencies(frequencies.front());
+
+    const auto before = allocation_snapshot();
+    for(int round = 0; round < 10; ++round) {
+        for(const auto& currentFrequencies : frequencies) {
+            tree.setFrequencies(currentFrequencies);
+        }
+    }
+    const auto after = allocation_snapshot();
+    for(std::size_t subsystemIndex = 0; subsystemIndex < ALLOC_SUBSYSTEMS_COUNT; ++subsystemIndex) {
+        CHECK(after[subsystemIndex].allocations == before[subsystemIndex].allocations);
+    }
+#endif
+}
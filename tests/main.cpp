@@ -0,0 +1,73 @@
+#include "testing.hpp"
+
+#include <iostream>
+#include <vector>
+#include <cstring>
+
+
+namespace {
+
+struct TestCase {
+    const char* name = nullptr;
+    void (*function)() = nullptr;
+};
+
+std::vector<TestCase>& test_cases()
+{
+    static std::vector<TestCase> result;
+    return result;
+}
+
+std::size_t failuresCount = 0;
+
+bool is_selected(const char* name, int argc, char* argv[])
+{
+    for(int argIndex = 1; argIndex < argc; ++argIndex) {
+        if(std::strcmp(name, argv[argIndex]) == 0) {
+            return true;
+        }
+    }
+    return argc < 2;
+}
+
+}
+
+void register_test(const char* name, void (*function)())
+{
+    test_cases().push_back(TestCase{name, function});
+}
+
+void report_failure(const char* file, int line, const std::string& message)
+{
+    ++failuresCount;
+    std::cerr << file << ':' << line << ": " << message << '\n';
+}
+
+int main(int argc, char* argv[])
+{
+    std::size_t testsCount = 0;
+    std::size_t failedCount = 0;
+    for(const auto& testCase : test_cases()) {
+        if(!is_selected(testCase.name, argc, argv)) {
+            continue;
+        }
+
+        ++testsCount;
+        const auto failuresBefore = failuresCount;
+        try {
+            testCase.function();
+        }
+        catch(const TestAbort&) {
+        }
+        catch(const std::exception& exception) {
+            report_failure(testCase.name, 0, std::string{"unexpected exception: "} + exception.what());
+        }
+
+        const bool passed = (failuresCount == failuresBefore);
+        failedCount += passed ? 0 : 1;
+        std::cout << (passed ? "ok   " : "FAIL ") << testCase.name << std::endl;
+    }
+
+    std::cout << testsCount - failedCount << " of " << testsCount << " tests passed" << std::endl;
+    return (failedCount == 0 && testsCount > 0) ? 0 : 1;
+}
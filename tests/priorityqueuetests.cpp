@@ -0,0 +1,114 @@
+#include "testing.hpp"
+#include "priority_queue.hpp"
+
+#include <memory>
+#include <random>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <functional>
+
+
+namespace {
+
+std::vector<int> make_values(std::size_t count)
+{
+    std::mt19937 engine{11};
+    std::vector<int> result(count);
+    for(auto& value : result) {
+        // many equal values
+        value = static_cast<int>(engine() % 100);
+    }
+    return result;
+}
+
+template<class Queue>
+std::vector<int> pop_all(Queue& queue)
+{
+    std::vector<int> result;
+    while(!queue.empty()) {
+        result.push_back(queue.top());
+        queue.pop();
+    }
+    return result;
+}
+
+template<std::size_t Arity>
+void check_heap()
+{
+    const auto values = make_values(1000);
+    auto sorted = values;
+    std::sort(sorted.begin(), sorted.end());
+
+    priority_queue<int, std::less<>, std::allocator<int>, Arity> pushed;
+    for(const auto value : values) {
+        pushed.push(value);
+    }
+    CHECK(pushed.size() == values.size());
+    CHECK(pop_all(pushed) == sorted);
+    CHECK_THROWS(pushed.top());
+
+    priority_queue<int, std::less<>, std::allocator<int>, Arity> heapified(values.cbegin(), values.cend());
+    CHECK(pop_all(heapified) == sorted);
+
+    // pushes between pops
+    priority_queue<int, std::greater<>, std::allocator<int>, Arity> interleaved;
+    std::vector<int> popped;
+    for(std::size_t index = 0; index < values.size(); ++index) {
+        interleaved.push(values[index]);
+        if(index % 3 == 2) {
+            popped.push_back(interleaved.top());
+            interleaved.pop();
+        }
+    }
+    auto rest = pop_all(interleaved);
+    CHECK(std::is_sorted(rest.cbegin(), rest.cend(), std::greater<>()));
+    popped.insert(popped.end(), rest.cbegin(), rest.cend());
+    std::sort(popped.begin(), popped.end());
+    CHECK(popped == sorted);
+}
+
+}
+
+TEST_CASE(d_ary_heap_pops_in_order)
+{
+    check_heap<2>();
+    check_heap<4>();
+    check_heap<8>();
+}
+
+TEST_CASE(d_ary_heap_holds_move_only_values)
+{
+    const auto less = [](const std::unique_ptr<int>& left, const std::unique_ptr<int>& right) { return *left < *right; };
+    priority_queue<std::unique_ptr<int>, decltype(less), std::allocator<std::unique_ptr<int>>, 4> queue(less);
+    for(const auto value : make_values(100)) {
+        queue.emplace(std::make_unique<int>(value));
+    }
+    int previous = -1;
+    while(!queue.empty()) {
+        CHECK(*queue.top() >= previous);
+        previous = *queue.top();
+        queue.pop();
+    }
+}
+
+TEST_CASE(sorted_queue_keeps_equal_values_in_order)
+{
+    // pairs are compared by the first value, the second one is the order of the pushes
+    const auto byFirst = [](const std::pair<int, int>& left, const std::pair<int, int>& right) { return left.first < right.first; };
+    priority_queue<std::pair<int, int>, decltype(byFirst)> queue(byFirst);
+    const auto values = make_values(300);
+    for(std::size_t index = 0; index < values.size(); ++index) {
+        queue.push({values[index], static_cast<int>(index)});
+    }
+    CHECK(std::is_sorted(queue.cbegin(), queue.cend(), [](const std::pair<int, int>& left, const std::pair<int, int>& right) {
+        return left.first < right.first || (left.first == right.first && left.second < right.second);
+    }));
+
+    // a copy and a moved queue keep the elements
+    const auto copy = queue;
+    CHECK(std::equal(copy.cbegin(), copy.cend(), queue.cbegin(), queue.cend()));
+    auto moved = std::move(queue);
+    CHECK(moved.size() == values.size());
+    CHECK(std::equal(copy.cbegin(), copy.cend(), moved.cbegin(), moved.cend()));
+}
@@ -0,0 +1,272 @@
+#include "testing.hpp"
+#include "testdata.hpp"
+#include "huffmanencoding.hpp"
+#include "memorybudget.hpp"
+#include "verify.hpp"
+#include "bwt.hpp"
+#include "streamcodec.hpp"
+#include "encodetable.hpp"
+
+#include <filesystem>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+
+namespace {
+
+const BlockTransform TRANSFORMS[] = {BlockTransform::None, BlockTransform::Bwt, BlockTransform::Lz77, BlockTransform::Words};
+const CompressionLevel LEVELS[] = {CompressionLevel::Fast, CompressionLevel::Default, CompressionLevel::Max};
+
+CodecOptions make_options(BlockTransform transform, CompressionLevel level, unsigned threadsCount)
+{
+    CodecOptions options;
+    options.blockSize = 16 * 1024;
+    options.transform = transform;
+    options.level = level;
+    options.threadsCount = threadsCount;
+    return options;
+}
+
+BytesBuffer concat(std::initializer_list<BytesBuffer> parts)
+{
+    BytesBuffer result;
+    for(const auto& part : parts) {
+        result.insert(result.end(), part.cbegin(), part.cend());
+    }
+    return result;
+}
+
+// the edge sizes and every kind of block in one file
+std::vector<BytesBuffer> make_inputs()
+{
+    return {
+        BytesBuffer{},
+        BytesBuffer{'a'},
+        BytesBuffer{'a', 'b'},
+        BytesBuffer(40000, 0),
+        make_text(50001),
+        make_random(20000),
+        make_words(30001),
+        concat({make_text(12345, 2), make_random(17000, 2), make_words(9000, 2), make_text(30000, 3)})
+    };
+}
+
+}
+
+TEST_CASE(roundtrip_every_transform_and_level)
+{
+    const auto inputs = make_inputs();
+    for(const auto transform : TRANSFORMS) {
+        for(const auto level : LEVELS) {
+            for(const unsigned threadsCount : {1u, 3u}) {
+                const auto options = make_options(transform, level, threadsCount);
+                for(const auto& input : inputs) {
+                    const auto archive = compress(input, options);
+                    CHECK(decompress(archive, options) == input);
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE(blocks_of_every_type_are_written)
+{
+    const auto text = make_text(100000);
+    CHECK(has_block_type(compress(text, make_options(BlockTransform::None, CompressionLevel::Default, 2)), BlockType::Huffman));
+    CHECK(has_block_type(compress(text, make_options(BlockTransform::Bwt, CompressionLevel::Default, 2)), BlockType::Bwt));
+    CHECK(has_block_type(compress(text, make_options(BlockTransform::Lz77, CompressionLevel::Default, 2)), BlockType::Lz77));
+
+    const auto words = make_words(100000);
+    CHECK(has_block_type(compress(words, make_options(BlockTransform::Words, CompressionLevel::Default, 2)), BlockType::Words));
+
+    const auto random = make_random(100000);
+    for(const auto transform : TRANSFORMS) {
+        const auto blocks = archive_blocks(compress(random, make_options(transform, CompressionLevel::Default, 2)));
+        CHECK(!blocks.empty());
+        CHECK(std::all_of(blocks.cbegin(), blocks.cend(), [](const ArchiveBlock& block) {
+            return block.header.type == BlockType::Stored && block.header.packedSize == block.header.rawSize;
+        }));
+    }
+}
+
+TEST_CASE(blocks_header_records_sizes_and_flags)
+{
+    const auto text = make_text(70000);
+    const auto options = make_options(BlockTransform::Bwt, CompressionLevel::Default, 2);
+    const auto archive = compress(text, options);
+
+    BlocksHeader blocksHeader;
+    REQUIRE(archive.size() >= sizeof(blocksHeader));
+    std::memcpy(&blocksHeader, archive.data(), sizeof(blocksHeader));
+    CHECK(std::equal(blocksHeader.header, blocksHeader.header + 4, "HAFB"));
+    CHECK(blocksHeader.version == BLOCKS_FORMAT_VERSION);
+    CHECK(blocksHeader.blockSize == options.blockSize);
+    CHECK(blocksHeader.flags == BLOCKS_FLAG_BWT);
+    CHECK(blocksHeader.originalSize == text.size());
+    CHECK(blocksHeader.payloadSize == archive.size() - sizeof(BlocksHeader));
+}
+
+TEST_CASE(invalid_block_sizes_are_rejected)
+{
+    auto options = make_options(BlockTransform::Bwt, CompressionLevel::Default, 1);
+    options.blockSize = BWT_MAX_SIZE;
+    CHECK(make_blocks_header(options).blockSize == BWT_MAX_SIZE);
+    options.blockSize = BWT_MAX_SIZE + 1;
+    CHECK_THROWS_WITH(make_blocks_header(options), "Invalid block size for BWT");
+    CHECK_THROWS_WITH(compress(make_text(1000), options), "Invalid block size for BWT");
+    CHECK_THROWS_WITH(StreamEncoder{options}, "Invalid block size for BWT");
+
+    // the other transforms index the blocks by 32 bits
+    options.transform = BlockTransform::None;
+    CHECK(make_blocks_header(options).blockSize == BWT_MAX_SIZE + 1);
+    options.blockSize = std::size_t{std::numeric_limits<std::uint32_t>::max()} + 1;
+    CHECK_THROWS_WITH(make_blocks_header(options), "Invalid block size");
+    options.blockSize = 0;
+    CHECK_THROWS_WITH(make_blocks_header(options), "Invalid block size");
+}
+
+TEST_CASE(max_level_splits_mixed_blocks)
+{
+    // one block of text and random data is smaller as two parts
+    const auto mixed = concat({make_text(40000), make_random(40000)});
+    auto defaultOptions = make_options(BlockTransform::None, CompressionLevel::Default, 1);
+    auto maxOptions = make_options(BlockTransform::None, CompressionLevel::Max, 1);
+    maxOptions.blockSize = defaultOptions.blockSize = 128 * 1024;
+
+    const auto defaultArchive = compress(mixed, defaultOptions);
+    const auto maxArchive = compress(mixed, maxOptions);
+    CHECK(archive_blocks(defaultArchive).size() == 1);
+    CHECK(archive_blocks(maxArchive).size() > 1);
+    CHECK(maxArchive.size() < defaultArchive.size());
+    CHECK(decompress(maxArchive) == mixed);
+}
+
+TEST_CASE(max_level_split_of_large_blocks_is_bounded)
+{
+    // 256 segments at most, of 256 KiB in a block of 64 MiB
+    constexpr std::size_t segmentSize = 256 * 1024;
+    const auto large = concat({make_text(24 * 1024 * 1024 + 1000), make_random(8 * 1024 * 1024), make_text(32 * 1024 * 1024 - 1000, 2)});
+    const auto parts = split_block(large);
+    CHECK(parts.size() > 1);
+    std::size_t total = 0;
+    for(const auto partSize : parts) {
+        CHECK(total + partSize == large.size() || partSize % segmentSize == 0);
+        total += partSize;
+    }
+    CHECK(total == large.size());
+    CHECK(split_block_scratch_size(std::numeric_limits<std::uint32_t>::max()) < 1024 * 1024);
+
+    auto options = make_options(BlockTransform::None, CompressionLevel::Max, 1);
+    options.blockSize = large.size();
+    const auto archive = compress(large, options);
+    CHECK(archive_blocks(archive).size() == parts.size());
+    CHECK(decompress(archive) == large);
+}
+
+TEST_CASE(block_codec_roundtrip)
+{
+    const std::pair<BlockTransform, BlockType> cases[] = {
+        {BlockTransform::None, BlockType::Huffman},
+        {BlockTransform::Bwt, BlockType::Bwt},
+        {BlockTransform::Lz77, BlockType::Lz77},
+        {BlockTransform::Words, BlockType::Words}
+    };
+    for(const auto& testCase : cases) {
+        for(const auto level : LEVELS) {
+            const auto input = (testCase.first == BlockTransform::Words) ? make_words(10001) : make_text(10001);
+            BytesBuffer payload;
+            BlockHeader header;
+            header.type = encode_block(input, payload, level, testCase.first);
+            header.rawSize = static_cast<std::uint32_t>(input.size());
+            header.packedSize = static_cast<std::uint32_t>(payload.size());
+            header.checksum = block_checksum(input);
+            CHECK(header.type == testCase.second);
+
+            BytesBuffer output;
+            decode_block(header, payload, output);
+            CHECK(output == input);
+        }
+    }
+}
+
+TEST_CASE(memory_budget_roundtrip)
+{
+    auto options = make_options(BlockTransform::Lz77, CompressionLevel::Default, 4);
+    options.blockSize = 256 * 1024;
+    const auto unlimited = plan_compression_memory(options);
+
+    options.memoryBudget = unlimited.totalSize * 2 / 3;
+    const auto plan = plan_compression_memory(options);
+    CHECK(plan.totalSize <= options.memoryBudget);
+
+    const auto text = make_text(1000000);
+    CHECK(decompress(compress(text, options), options) == text);
+
+    options.memoryBudget = 1024;
+    CHECK_THROWS(plan_compression_memory(options));
+
+    // a too small budget doesn't leave an empty output
+    TempDirectory directory;
+    write_file(directory.file("input"), text);
+    CHECK_THROWS_WITH(compress_file(directory.file("input"), directory.file("archive"), options), "too small");
+    CHECK(!std::filesystem::exists(directory.file("archive")));
+}
+
+TEST_CASE(memory_plan_counts_encoding_scratch)
+{
+    // the tables of symbol pairs and the histograms of the split are in every worker
+    auto options = make_options(BlockTransform::None, CompressionLevel::Default, 4);
+    options.blockSize = 1024 * 1024;
+    const auto defaultPlan = plan_compression_memory(options);
+    CHECK(defaultPlan.scratchSize >= 4 * EncodeTable::tablesSize(options.blockSize));
+    CHECK(EncodeTable::tablesSize(options.blockSize) >= 65536 * sizeof(std::uint64_t));
+
+    options.level = CompressionLevel::Max;
+    options.blockSize = 64 * 1024 * 1024;
+    const auto maxPlan = plan_compression_memory(options);
+    CHECK(maxPlan.scratchSize >= 4 * split_block_scratch_size(options.blockSize));
+}
+
+TEST_CASE(stream_codec_roundtrip)
+{
+    const auto input = concat({make_text(30000), make_random(5000), make_words(7001)});
+    for(const auto transform : TRANSFORMS) {
+        const auto options = make_options(transform, CompressionLevel::Default, 1);
+
+        const auto streamed = stream_compress(input, options, 777, 333);
+        CHECK(archive_blocks(streamed).size() > input.size() / options.blockSize + 1);
+        CHECK(stream_decompress(streamed, 555, 999) == input);
+        // the sizes are unknown in the stream, the pipeline reads it up to the end mark
+        CHECK(decompress(streamed) == input);
+        // and the stream decoder reads the files of the pipeline
+        CHECK(stream_decompress(compress(input, options), 1000, 1) == input);
+    }
+
+    const BytesBuffer empty;
+    CHECK(stream_decompress(stream_compress(empty, CodecOptions(), 1, 1), 1, 1).empty());
+}
+
+TEST_CASE(file_roundtrip_every_io_backend)
+{
+    TempDirectory directory;
+    const auto input = concat({make_text(700000), make_random(100000)});
+    write_file(directory.file("input"), input);
+
+    for(const auto backend : {IoBackend::Streams, IoBackend::IoUring}) {
+        CodecOptions options;
+        options.blockSize = 64 * 1024;
+        options.threadsCount = 3;
+        options.ioBackend = backend;
+        // small requests, so there are many of them in flight (the backend falls back to streams if unsupported)
+        options.ioUring.bufferSize = 16 * 1024;
+
+        compress_file(directory.file("input"), directory.file("archive"), options);
+        decompress_file(directory.file("archive"), directory.file("output"), options);
+        CHECK(read_file(directory.file("output")) == input);
+
+        const auto result = verify_file(directory.file("archive"), options);
+        CHECK(result.passed);
+        CHECK(result.stats.originalSize() == input.size());
+    }
+}
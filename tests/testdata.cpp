@@ -0,0 +1,193 @@
+#include "testdata.hpp"
+#include "streamcodec.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <random>
+#include <iterator>
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <cstring>
+
+
+namespace {
+
+// the distributions of <random> differ between the standard libraries, the engine doesn't
+std::uint32_t next_value(std::mt19937& engine, std::uint32_t limit) { return static_cast<std::uint32_t>(engine() % limit); }
+
+}
+
+BytesBuffer make_text(std::size_t size, std::uint32_t seed)
+{
+    static const char* const words[] = {
+        "the", "block", "of", "data", "is", "coded", "with", "a", "tree", "and", "every", "symbol",
+        "gets", "its", "own", "code", "shorter", "for", "frequent", "bytes", "archive", "stream", "header", "index"
+    };
+    constexpr auto wordsCount = sizeof(words) / sizeof(words[0]);
+
+    std::mt19937 engine{seed};
+    BytesBuffer result;
+    result.reserve(size);
+    while(result.size() < size) {
+        // a skewed choice, so some words are much more frequent
+        const auto word = words[next_value(engine, wordsCount) * next_value(engine, wordsCount) / wordsCount];
+        result.insert(result.end(), word, word + std::strlen(word));
+        result.push_back(next_value(engine, 12) == 0 ? '\n' : ' ');
+    }
+    result.resize(size);
+    return result;
+}
+
+BytesBuffer make_random(std::size_t size, std::uint32_t seed)
+{
+    std::mt19937 engine{seed};
+    BytesBuffer result(size);
+    for(auto& byte : result) {
+        byte = static_cast<std::uint8_t>(engine());
+    }
+    return result;
+}
+
+BytesBuffer make_words(std::size_t size, std::uint32_t seed)
+{
+    std::mt19937 engine{seed};
+    BytesBuffer result(size);
+    for(std::size_t pos = 0; pos + 1 < size; pos += 2) {
+        // about a thousand values, the bytes of each alone are close to uniform
+        const auto value = static_cast<std::uint16_t>((next_value(engine, 1024) * next_value(engine, 1024) / 1024) * 61);
+        result[pos] = static_cast<std::uint8_t>(value);
+        result[pos + 1] = static_cast<std::uint8_t>(value >> 8);
+    }
+    if(size % 2 != 0) {
+        result.back() = 'x';
+    }
+    return result;
+}
+
+BytesBuffer compress(const BytesBuffer& data, const CodecOptions& options)
+{
+    std::istringstream input(std::string(data.cbegin(), data.cend()), std::ios::in | std::ios::binary);
+    std::stringstream output(std::ios::in | std::ios::out | std::ios::binary);
+    compress_blocks(input, output, options);
+    const auto archive = output.str();
+    return BytesBuffer(archive.cbegin(), archive.cend());
+}
+
+BytesBuffer decompress(const BytesBuffer& archive, const CodecOptions& options, const std::string& referencesDirectory)
+{
+    std::istringstream input(std::string(archive.cbegin(), archive.cend()), std::ios::in | std::ios::binary);
+    std::ostringstream output(std::ios::out | std::ios::binary);
+    decompress_blocks(input, output, options, referencesDirectory);
+    const auto data = output.str();
+    return BytesBuffer(data.cbegin(), data.cend());
+}
+
+BytesBuffer stream_compress(const BytesBuffer& data, const CodecOptions& options, std::size_t inputChunk, std::size_t outputChunk)
+{
+    StreamEncoder encoder{options};
+    BytesBuffer result;
+    BytesBuffer output(outputChunk);
+    std::size_t pos = 0;
+    while(true) {
+        StreamBuffers buffers;
+        buffers.nextIn = data.data() + pos;
+        buffers.availIn = std::min(inputChunk, data.size() - pos);
+        buffers.nextOut = output.data();
+        buffers.availOut = output.size();
+
+        // a flush in the middle makes a short block
+        const auto flush = (pos + buffers.availIn == data.size()) ? StreamFlush::Finish
+                         : (pos < data.size() / 2 && pos + buffers.availIn >= data.size() / 2) ? StreamFlush::Flush
+                         : StreamFlush::None;
+        const auto status = encoder.encode(buffers, flush);
+        pos = static_cast<std::size_t>(buffers.nextIn - data.data());
+        result.insert(result.end(), output.data(), buffers.nextOut);
+        if(status == StreamStatus::StreamEnd) {
+            return result;
+        }
+    }
+}
+
+BytesBuffer stream_decompress(const BytesBuffer& archive, std::size_t inputChunk, std::size_t outputChunk)
+{
+    StreamDecoder decoder;
+    BytesBuffer result;
+    BytesBuffer output(outputChunk);
+    std::size_t pos = 0;
+    while(true) {
+        StreamBuffers buffers;
+        buffers.nextIn = archive.data() + pos;
+        buffers.availIn = std::min(inputChunk, archive.size() - pos);
+        buffers.nextOut = output.data();
+        buffers.availOut = output.size();
+
+        const auto status = decoder.decode(buffers);
+        const auto taken = static_cast<std::size_t>(buffers.nextIn - archive.data()) - pos;
+        pos += taken;
+        result.insert(result.end(), output.data(), buffers.nextOut);
+        if(status == StreamStatus::StreamEnd) {
+            return result;
+        }
+        if(taken == 0 && buffers.nextOut == output.data()) {
+            throw std::runtime_error{"The stream decoder stopped before the end of the stream"};
+        }
+    }
+}
+
+std::vector<ArchiveBlock> archive_blocks(const BytesBuffer& archive)
+{
+    std::vector<ArchiveBlock> result;
+    for(auto offset = sizeof(BlocksHeader); offset + sizeof(BlockHeader) <= archive.size();) {
+        ArchiveBlock block;
+        block.offset = offset;
+        std::memcpy(&block.header, archive.data() + offset, sizeof(BlockHeader));
+        if(is_end_mark(block.header)) {
+            break;
+        }
+        result.push_back(block);
+        offset += sizeof(BlockHeader) + block.header.packedSize;
+    }
+    return result;
+}
+
+bool has_block_type(const BytesBuffer& archive, BlockType type)
+{
+    const auto blocks = archive_blocks(archive);
+    return std::any_of(blocks.cbegin(), blocks.cend(), [type](const ArchiveBlock& block) { return block.header.type == type; });
+}
+
+BytesBuffer read_file(const std::string& path)
+{
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    if(!file) {
+        throw std::runtime_error{"Unable to open file: \"" + path + "\" to read"};
+    }
+    return BytesBuffer(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+void write_file(const std::string& path, const BytesBuffer& data)
+{
+    std::ofstream file(path, std::ios::out | std::ios::binary);
+    file.write(reinterpret_cast<const char*>(data.data()), std::streamsize(data.size()));
+    if(!file) {
+        throw std::runtime_error{"Unable to write file: \"" + path + "\""};
+    }
+}
+
+TempDirectory::TempDirectory()
+{
+    static std::atomic<unsigned> counter{0};
+    std::random_device device;
+    const auto name = "huffman_tests_" + std::to_string(device()) + '_' + std::to_string(counter++);
+    const auto path = std::filesystem::temp_directory_path() / name;
+    std::filesystem::create_directories(path);
+    path_ = path.string();
+}
+
+TempDirectory::~TempDirectory()
+{
+    std::error_code error;
+    std::filesystem::remove_all(path_, error);
+}
@@ -0,0 +1,57 @@
+#ifndef TESTDATA_HPP
+#define TESTDATA_HPP
+
+#include "huffmanencoding.hpp"
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+
+// Generated inputs (the same for the same seed) and archives in memory for the tests
+
+// words of a small vocabulary with spaces and line breaks, compressible by every transform
+BytesBuffer make_text(std::size_t size, std::uint32_t seed = 1);
+// incompressible
+BytesBuffer make_random(std::size_t size, std::uint32_t seed = 1);
+// 16-bit little endian values of a skewed distribution over a wide alphabet, the Words blocks are smaller for it
+BytesBuffer make_words(std::size_t size, std::uint32_t seed = 1);
+
+BytesBuffer compress(const BytesBuffer& data, const CodecOptions& options = CodecOptions());
+BytesBuffer decompress(const BytesBuffer& archive, const CodecOptions& options = CodecOptions(),
+                       const std::string& referencesDirectory = ".");
+
+// StreamEncoder/StreamDecoder fed by chunks of the sizes, the encoder flushes in the middle of the input;
+// throws if the decoder stops without the end of the stream
+BytesBuffer stream_compress(const BytesBuffer& data, const CodecOptions& options, std::size_t inputChunk, std::size_t outputChunk);
+BytesBuffer stream_decompress(const BytesBuffer& archive, std::size_t inputChunk, std::size_t outputChunk);
+
+struct ArchiveBlock {
+    std::size_t offset = 0; // of the block header
+    BlockHeader header;
+};
+
+// the blocks of an archive with BlocksHeader of the current version, without the end mark
+std::vector<ArchiveBlock> archive_blocks(const BytesBuffer& archive);
+bool has_block_type(const BytesBuffer& archive, BlockType type);
+
+BytesBuffer read_file(const std::string& path);
+void write_file(const std::string& path, const BytesBuffer& data);
+
+// a new directory, removed with the files in it
+class TempDirectory {
+public:
+    TempDirectory();
+    ~TempDirectory();
+
+    TempDirectory(const TempDirectory&) = delete;
+    TempDirectory& operator=(const TempDirectory&) = delete;
+
+    const std::string& path() const { return path_; }
+    std::string file(const std::string& name) const { return path_ + '/' + name; }
+
+private:
+    std::string path_;
+};
+
+#endif // TESTDATA_HPP
@@ -0,0 +1,63 @@
+#ifndef TESTING_HPP
+#define TESTING_HPP
+
+#include <string>
+#include <stdexcept>
+
+
+// Minimal test runner without dependencies: TEST_CASE registers a function, CHECK records a failure
+// and goes on, REQUIRE stops the test case. The runner returns non-zero if anything failed,
+// so "make check" (CONFIG += testcase) fails too. Arguments select the test cases by name.
+
+struct TestAbort {}; // thrown by REQUIRE
+
+void register_test(const char* name, void (*function)());
+void report_failure(const char* file, int line, const std::string& message);
+
+struct TestRegistrar {
+    TestRegistrar(const char* name, void (*function)()) { register_test(name, function); }
+};
+
+#define TEST_CASE(name) \
+    static void name(); \
+    static const TestRegistrar name##_registrar{#name, name}; \
+    static void name()
+
+#define CHECK(condition) \
+    do { \
+        if(!(condition)) { \
+            report_failure(__FILE__, __LINE__, "CHECK(" #condition ")"); \
+        } \
+    } while(false)
+
+#define REQUIRE(condition) \
+    do { \
+        if(!(condition)) { \
+            report_failure(__FILE__, __LINE__, "REQUIRE(" #condition ")"); \
+            throw TestAbort{}; \
+        } \
+    } while(false)
+
+// the message of the exception must contain text
+#define CHECK_THROWS_WITH(expression, text) \
+    do { \
+        std::string message_; \
+        bool thrown_ = false; \
+        try { \
+            (void)(expression); \
+        } \
+        catch(const std::exception& exception_) { \
+            thrown_ = true; \
+            message_ = exception_.what(); \
+        } \
+        if(!thrown_) { \
+            report_failure(__FILE__, __LINE__, "CHECK_THROWS(" #expression ") didn't throw"); \
+        } \
+        else if(message_.find(text) == std::string::npos) { \
+            report_failure(__FILE__, __LINE__, "CHECK_THROWS(" #expression ") threw \"" + message_ + "\""); \
+        } \
+    } while(false)
+
+#define CHECK_THROWS(expression) CHECK_THROWS_WITH(expression, "")
+
+#endif // TESTING_HPP
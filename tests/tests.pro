@@ -0,0 +1,60 @@
+#-------------------------------------------------
+#
+# Roundtrip, corruption and format compatibility tests of the codec (no Qt),
+# "make check" builds and runs them
+#
+#-------------------------------------------------
+
+QT       -= core gui
+
+TARGET = tests
+TEMPLATE = app
+
+CONFIG += console c++17 thread testcase
+CONFIG -= app_bundle
+
+INCLUDEPATH += ..
+
+# archives of the released format (see formattests.cpp)
+DEFINES += TESTS_DATA_DIR=\\\"$$PWD/data\\\"
+# the allocations are counted (see htreetests.cpp)
+DEFINES += HUFFMAN_ENABLE_ALLOC_STATS
+
+SOURCES += \
+        ../allocstats.cpp \
+        ../analysis.cpp \
+        ../autotune.cpp \
+        ../blockcodec.cpp \
+        ../bufferalloc.cpp \
+        ../bwt.cpp \
+        ../decodetable.cpp \
+        ../decodetree.cpp \
+        ../dedup.cpp \
+        ../encodetable.cpp \
+        ../htree.cpp \
+        ../huffmanencoding.cpp \
+        ../iouring.cpp \
+        ../kernels.cpp \
+        ../lz77.cpp \
+        ../memorybudget.cpp \
+        ../paralleldecoder.cpp \
+        ../pipeline.cpp \
+        ../search.cpp \
+        ../sha256.cpp \
+        ../stats.cpp \
+        ../streamcodec.cpp \
+        ../trace.cpp \
+        ../verify.cpp \
+        ../wordcodec.cpp \
+        corruptiontests.cpp \
+        deduptests.cpp \
+        formattests.cpp \
+        htreetests.cpp \
+        main.cpp \
+        priorityqueuetests.cpp \
+        roundtriptests.cpp \
+        testdata.cpp
+
+HEADERS += \
+        testdata.hpp \
+        testing.hpp
@@ -0,0 +1,77 @@
+#include "trace.hpp"
+#include "stats.hpp"
+
+#include <fstream>
+#include <atomic>
+#include <iomanip>
+#include <stdexcept>
+
+
+namespace {
+
+std::atomic<int> nextThreadID{1};
+thread_local const int currentThreadID = nextThreadID++;
+thread_local std::int64_t currentBlock = -1;
+
+}
+
+TraceRecorder::TraceRecorder() : start_{std::chrono::steady_clock::now()} {}
+
+void TraceRecorder::addSpan(Stage stage, std::chrono::steady_clock::time_point start, std::uint64_t wallNs)
+{
+    const auto startNs = std::chrono::duration_cast<std::chrono::nanoseconds>(start - start_).count();
+
+    std::lock_guard<std::mutex> lock{mutex_};
+    spans_.push_back(Span{stage, currentThreadID, currentBlock, static_cast<std::uint64_t>(std::max<decltype(startNs)>(startNs, 0)), wallNs});
+}
+
+void TraceRecorder::setThreadName(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock{mutex_};
+    threadNames_.emplace_back(currentThreadID, name);
+}
+
+void TraceRecorder::setCurrentBlock(std::int64_t blockIndex) { currentBlock = blockIndex; }
+
+void TraceRecorder::save(const std::string& path) const
+{
+    std::ofstream out(path, std::ios::out | std::ios::trunc);
+    if(!out) {
+        throw std::runtime_error{"Unable to open file: \"" + path + "\" to write"};
+    }
+
+    std::lock_guard<std::mutex> lock{mutex_};
+    out << std::fixed << std::setprecision(3);
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+    bool first = true;
+    const auto separator = [&first, &out] {
+        if(!first) {
+            out << ",\n";
+        }
+        first = false;
+    };
+
+    for(const auto& threadName : threadNames_) {
+        separator();
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << threadName.first
+            << ",\"args\":{\"name\":\"" << threadName.second << "\"}}";
+    }
+
+    for(const auto& span : spans_) {
+        separator();
+        out << "{\"name\":\"" << stage_name(span.stage) << "\",\"cat\":\"codec\",\"ph\":\"X\",\"pid\":1"
+            << ",\"tid\":" << span.threadID
+            << ",\"ts\":" << static_cast<double>(span.startNs) / 1000.0
+            << ",\"dur\":" << static_cast<double>(span.durationNs) / 1000.0;
+        if(span.blockIndex >= 0) {
+            out << ",\"args\":{\"block\":" << span.blockIndex << '}';
+        }
+        out << '}';
+    }
+
+    out << "\n]}\n";
+    if(!out) {
+        throw std::runtime_error{"Unable to write trace to file: \"" + path + "\""};
+    }
+}
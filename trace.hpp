@@ -0,0 +1,44 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <vector>
+#include <string>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+
+
+enum class Stage : std::uint8_t;
+
+// Collects stage spans and saves them as Chrome Trace Event JSON
+// (chrome://tracing, https://ui.perfetto.dev). Spans come from StageTimer,
+// so tracing needs HUFFMAN_ENABLE_STATS as well.
+class TraceRecorder {
+public:
+    explicit TraceRecorder();
+
+    void addSpan(Stage stage, std::chrono::steady_clock::time_point start, std::uint64_t wallNs);
+    void setThreadName(const std::string& name);
+
+    void save(const std::string& path) const;
+
+    // block processed by the current thread, attached to its spans (-1 - none)
+    static void setCurrentBlock(std::int64_t blockIndex);
+
+private:
+    struct Span {
+        Stage stage;
+        int threadID = 0;
+        std::int64_t blockIndex = -1;
+        std::uint64_t startNs = 0;
+        std::uint64_t durationNs = 0;
+    };
+
+private:
+    std::chrono::steady_clock::time_point start_;
+    mutable std::mutex mutex_;
+    std::vector<Span> spans_;
+    std::vector<std::pair<int, std::string>> threadNames_;
+};
+
+#endif // TRACE_HPP
@@ -0,0 +1,184 @@
+#include "verify.hpp"
+#include "dedup.hpp"
+#include "htree.hpp"
+#include "kernels.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <stdexcept>
+
+
+namespace {
+
+// the decompressed data of a single stream file is only hashed
+class ChecksumStreamBuf : public std::streambuf {
+public:
+    std::uint32_t checksum() const { return checksum_; }
+    std::uint64_t size() const { return size_; }
+
+protected:
+    std::streamsize xsputn(const char* data, std::streamsize count) override
+    {
+        StageTimer timer{Stage::Checksum};
+        add(reinterpret_cast<const std::uint8_t*>(data), static_cast<std::size_t>(count));
+        return count;
+    }
+
+    int_type overflow(int_type ch) override
+    {
+        if(!traits_type::eq_int_type(ch, traits_type::eof())) {
+            const auto byte = static_cast<std::uint8_t>(ch);
+            add(&byte, 1);
+        }
+        return traits_type::not_eof(ch);
+    }
+
+private:
+    void add(const std::uint8_t* data, std::size_t size)
+    {
+        checksum_ = crc32c(data, size, checksum_);
+        size_ += size;
+    }
+
+private:
+    std::uint32_t checksum_ = 0;
+    std::uint64_t size_ = 0;
+};
+
+CodecStats verify_file_impl(const std::string& path, const CodecOptions& options, StatsCollector& collector, std::uint32_t& checksum)
+{
+    collector.setDecompression(true);
+
+    const bool isBlocksFile = is_blocks_file(path);
+    std::ifstream from_file(path, std::ios::in | std::ios::binary);
+    from_file.unsetf(std::ios::skipws);
+    if(!from_file) {
+        throw std::runtime_error{"Unable to open file: \"" + path + "\" to read"};
+    }
+
+    if(isBlocksFile) {
+        // block checksums are checked by the workers, the hash of the whole data needs the order
+        const auto hashBlock = [&checksum](const PipelineBlock& block) {
+            StageTimer timer{Stage::Checksum};
+            checksum = crc32c(block.output.data(), block.output.size(), checksum);
+        };
+
+        const auto blocksHeader = decode_blocks(from_file, options, directory_of(path), {}, hashBlock);
+        return collector.finish(sizeof(BlocksHeader) + blocksHeader.payloadSize, blocksHeader.originalSize);
+    }
+
+    ChecksumStreamBuf checksumBuf;
+    std::ostream checksum_stream(&checksumBuf);
+
+    HTree tree;
+    const auto header = read_header(from_file, tree);
+    if(is_stored(header)) {
+        copy_stored_data(from_file, checksum_stream);
+    }
+    else {
+        decompress_data_parallel(tree, from_file, checksum_stream, options.threadsCount, options.memoryBudget);
+    }
+    checksum = checksumBuf.checksum();
+
+    from_file.clear();
+    const auto bytesIn = static_cast<std::uint64_t>(from_file.seekg(0, std::ios::end).tellg());
+    return collector.finish(bytesIn, checksumBuf.size());
+}
+
+double to_megabytes(std::uint64_t bytes) { return static_cast<double>(bytes) / (1024.0 * 1024.0); }
+
+}
+
+bool VerifyReport::passed() const
+{
+    return std::all_of(files.cbegin(), files.cend(), [](const VerifyResult& result) { return result.passed; });
+}
+
+std::uint64_t VerifyReport::originalSize() const
+{
+    std::uint64_t result = 0;
+    for(const auto& file : files) {
+        result += file.passed ? file.stats.originalSize() : 0;
+    }
+    return result;
+}
+
+VerifyResult verify_file(const std::string& path, const CodecOptions& options)
+{
+    VerifyResult result;
+    result.path = path;
+
+    StatsCollector collector;
+    StatsScope statsScope{&collector};
+    try {
+        result.stats = verify_file_impl(path, options, collector, result.checksum);
+        result.passed = true;
+    }
+    catch(const std::exception& exc) {
+        result.error = exc.what();
+    }
+    return result;
+}
+
+VerifyReport verify_files(const std::vector<std::string>& paths, const CodecOptions& options)
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    VerifyReport report;
+    report.files.resize(paths.size());
+
+    // every file gets its share of the threads, a file of blocks uses them for its pipeline
+    const auto threadsCount = (options.threadsCount != 0) ? options.threadsCount : std::max(1u, std::thread::hardware_concurrency());
+    const auto filesCount = static_cast<unsigned>(std::max<std::size_t>(std::min<std::size_t>(paths.size(), threadsCount), 1));
+    CodecOptions fileOptions = options;
+    fileOptions.threadsCount = std::max(1u, threadsCount / filesCount);
+    fileOptions.memoryBudget = options.memoryBudget / filesCount;
+    fileOptions.tracePath.clear();
+
+    std::atomic<std::size_t> nextFile{0};
+    const auto verifyNext = [&]() {
+        for(auto fileIndex = nextFile++; fileIndex < paths.size(); fileIndex = nextFile++) {
+            report.files[fileIndex] = verify_file(paths[fileIndex], fileOptions);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for(unsigned threadIndex = 1; threadIndex < filesCount; ++threadIndex) {
+        threads.emplace_back(verifyNext);
+    }
+    verifyNext();
+    for(auto& thread : threads) {
+        thread.join();
+    }
+
+    const auto wall = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    report.wallNs = static_cast<std::uint64_t>(wall.count());
+    return report;
+}
+
+std::string format_verify_report(const VerifyReport& report)
+{
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1);
+    std::size_t failedCount = 0;
+    for(const auto& file : report.files) {
+        if(!file.passed) {
+            ++failedCount;
+            out << file.path << ": FAILED (" << file.error << ")\n";
+            continue;
+        }
+        out << file.path << ": ok, " << to_megabytes(file.stats.originalSize()) << " MB, "
+            << file.stats.megabytesPerSecond() << " MB/s, crc32c "
+            << std::hex << std::setw(8) << std::setfill('0') << file.checksum << std::dec << std::setfill(' ') << '\n';
+    }
+
+    const auto seconds = static_cast<double>(report.wallNs) / 1e9;
+    out << report.files.size() - failedCount << " passed, " << failedCount << " failed, "
+        << to_megabytes(report.originalSize()) << " MB in " << std::setprecision(3) << seconds << " s ("
+        << std::setprecision(1) << (seconds > 0.0 ? to_megabytes(report.originalSize()) / seconds : 0.0) << " MB/s)\n";
+    return out.str();
+}
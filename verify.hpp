@@ -0,0 +1,38 @@
+#ifndef VERIFY_HPP
+#define VERIFY_HPP
+
+#include "huffmanencoding.hpp"
+
+#include <string>
+#include <vector>
+
+
+// Test of compressed files without writing the decompressed data: the files are decoded
+// as by decompress_file (block checksums included), the data only goes through CRC-32C.
+
+struct VerifyResult {
+    std::string path;
+    bool passed = false;
+    std::string error;          // причина ошибки, если не прошёл
+    std::uint32_t checksum = 0; // CRC-32C распакованных данных
+    CodecStats stats;
+};
+
+struct VerifyReport {
+    std::vector<VerifyResult> files;
+    std::uint64_t wallNs = 0; // время проверки всех файлов
+
+    bool passed() const;
+    std::uint64_t originalSize() const;
+};
+
+// broken or missing file is a failed result, not an exception;
+// accepts both single stream ("HAFF") and blocks ("HAFB") files
+VerifyResult verify_file(const std::string& path, const CodecOptions& options = CodecOptions());
+// the files are tested concurrently, the threads and the memory budget of options are shared among them
+VerifyReport verify_files(const std::vector<std::string>& paths, const CodecOptions& options = CodecOptions());
+
+// a line per file and the total
+std::string format_verify_report(const VerifyReport& report);
+
+#endif // VERIFY_HPP
@@ -0,0 +1,256 @@
+#include "wordcodec.hpp"
+
+#include <string>
+#include <algorithm>
+#include <stdexcept>
+
+
+namespace {
+
+[[noreturn]] void throw_invalid_lengths() { throw std::runtime_error{"Invalid code lengths"}; }
+
+// the leaves are the symbols in increasing order of frequency, lengths get their depths in the Huffman tree
+void huffman_depths(const WordFrequencies& frequencies, const std::vector<std::uint32_t>& leaves, std::vector<unsigned>& lengths)
+{
+    // two queues: the leaves and the internal nodes, the nodes are made in increasing order of weight
+    const auto leavesCount = leaves.size();
+    std::vector<std::uint64_t> weights(2 * leavesCount - 1);
+    std::vector<std::uint32_t> parents(weights.size(), 0);
+    for(std::size_t leafIndex = 0; leafIndex < leavesCount; ++leafIndex) {
+        weights[leafIndex] = frequencies[leaves[leafIndex]];
+    }
+
+    std::size_t nextLeaf = 0;
+    std::size_t nextNode = leavesCount;
+    const auto takeLeast = [&](std::size_t nodesEnd) {
+        if(nextLeaf < leavesCount && (nextNode == nodesEnd || weights[nextLeaf] <= weights[nextNode])) {
+            return nextLeaf++;
+        }
+        return nextNode++;
+    };
+    for(auto node = leavesCount; node < weights.size(); ++node) {
+        const auto first = takeLeast(node);
+        const auto second = takeLeast(node);
+        weights[node] = weights[first] + weights[second];
+        parents[first] = static_cast<std::uint32_t>(node);
+        parents[second] = static_cast<std::uint32_t>(node);
+    }
+
+    // a parent is made after its children, the root is the last node
+    std::vector<unsigned> depths(weights.size(), 0);
+    for(auto node = weights.size() - 1; node-- > 0;) {
+        depths[node] = depths[parents[node]] + 1;
+    }
+    lengths.assign(depths.cbegin(), depths.cbegin() + std::ptrdiff_t(leavesCount));
+}
+
+// the clamped lengths overfill the code space: the least frequent of the shorter codes are lengthened
+// until it is repaid, the space left over goes back to the most frequent codes
+void limit_lengths(std::vector<unsigned>& lengths, unsigned maxLength)
+{
+    const auto capacity = std::uint64_t{1} << maxLength;
+    std::uint64_t kraftSum = 0;
+    for(auto& length : lengths) {
+        length = std::min(length, maxLength);
+        kraftSum += capacity >> length;
+    }
+
+    while(kraftSum > capacity) {
+        for(std::size_t leafIndex = 0; leafIndex < lengths.size() && kraftSum > capacity; ++leafIndex) {
+            if(lengths[leafIndex] < maxLength) {
+                ++lengths[leafIndex];
+                kraftSum -= capacity >> lengths[leafIndex];
+            }
+        }
+    }
+
+    for(auto leafIndex = lengths.size(); leafIndex-- > 0;) {
+        while(lengths[leafIndex] > 1 && kraftSum + (capacity >> lengths[leafIndex]) <= capacity) {
+            kraftSum += capacity >> lengths[leafIndex];
+            --lengths[leafIndex];
+        }
+    }
+}
+
+}
+
+void count_words(const std::uint8_t* data, std::size_t wordsCount, WordFrequencies& frequencies)
+{
+    frequencies.assign(WORD_ALPHABET_SIZE, 0);
+    for(std::size_t wordIndex = 0; wordIndex < wordsCount; ++wordIndex) {
+        ++frequencies[load_word(data + 2 * wordIndex)];
+    }
+}
+
+CodeLengths build_code_lengths(const WordFrequencies& frequencies, unsigned maxLength)
+{
+    CodeLengths result(frequencies.size(), 0);
+
+    std::vector<std::uint32_t> leaves;
+    for(std::size_t symbol = 0; symbol < frequencies.size(); ++symbol) {
+        if(frequencies[symbol] != 0) {
+            leaves.push_back(static_cast<std::uint32_t>(symbol));
+        }
+    }
+    if(leaves.empty()) {
+        return result;
+    }
+    if(leaves.size() == 1) {
+        result[leaves.front()] = 1;
+        return result;
+    }
+    if(maxLength == 0 || maxLength > WORD_MAX_CODE_LENGTH || (std::uint64_t{1} << maxLength) < leaves.size()) {
+        throw std::invalid_argument{"Codes of " + std::to_string(maxLength) + " bits can't be given to " +
+                                    std::to_string(leaves.size()) + " symbols"};
+    }
+
+    std::stable_sort(leaves.begin(), leaves.end(), [&frequencies](std::uint32_t left, std::uint32_t right) {
+        return frequencies[left] < frequencies[right];
+    });
+
+    std::vector<unsigned> lengths;
+    huffman_depths(frequencies, leaves, lengths);
+    if(*std::max_element(lengths.cbegin(), lengths.cend()) > maxLength) {
+        limit_lengths(lengths, maxLength);
+    }
+
+    for(std::size_t leafIndex = 0; leafIndex < leaves.size(); ++leafIndex) {
+        result[leaves[leafIndex]] = static_cast<std::uint8_t>(lengths[leafIndex]);
+    }
+    return result;
+}
+
+std::vector<std::uint32_t> canonical_codes(const CodeLengths& lengths)
+{
+    std::uint32_t counts[WORD_MAX_CODE_LENGTH + 1]{0};
+    for(const auto length : lengths) {
+        if(length > WORD_MAX_CODE_LENGTH) {
+            throw_invalid_lengths();
+        }
+        if(length != 0) {
+            ++counts[length];
+        }
+    }
+
+    // the codes of a length follow the last code of the shorter lengths extended by zeros
+    std::uint32_t nextCodes[WORD_MAX_CODE_LENGTH + 1]{0};
+    std::uint32_t code = 0;
+    for(unsigned length = 1; length <= WORD_MAX_CODE_LENGTH; ++length) {
+        code = (code + counts[length - 1]) << 1;
+        nextCodes[length] = code;
+        if(code + counts[length] > (std::uint32_t{1} << length)) {
+            throw_invalid_lengths();
+        }
+    }
+
+    std::vector<std::uint32_t> result(lengths.size(), 0);
+    for(std::size_t symbol = 0; symbol < lengths.size(); ++symbol) {
+        if(lengths[symbol] != 0) {
+            result[symbol] = nextCodes[lengths[symbol]]++;
+        }
+    }
+    return result;
+}
+
+
+WordEncoder::WordEncoder(const CodeLengths& lengths)
+    : lengths_(lengths)
+    , codes_(canonical_codes(lengths))
+{
+    lengths_.resize(WORD_ALPHABET_SIZE, 0);
+    codes_.resize(WORD_ALPHABET_SIZE, 0);
+}
+
+std::uint64_t WordEncoder::encodedBitsCount(const WordFrequencies& frequencies) const
+{
+    std::uint64_t result = 0;
+    for(std::size_t symbol = 0; symbol < std::min(frequencies.size(), lengths_.size()); ++symbol) {
+        result += frequencies[symbol] * lengths_[symbol];
+    }
+    return result;
+}
+
+
+WordDecoder::WordDecoder(const CodeLengths& lengths)
+    : entries_(std::size_t{1} << PEEK_BITS)
+{
+    if(lengths.size() > WORD_ALPHABET_SIZE) {
+        throw_invalid_lengths();
+    }
+    const auto codes = canonical_codes(lengths);
+
+    for(const auto length : lengths) {
+        if(length != 0) {
+            ++counts_[length];
+            maxLength_ = std::max<unsigned>(maxLength_, length);
+        }
+    }
+    if(maxLength_ == 0) {
+        throw_invalid_lengths();
+    }
+
+    std::uint32_t code = 0;
+    std::uint32_t index = 0;
+    for(unsigned length = 1; length <= WORD_MAX_CODE_LENGTH; ++length) {
+        code = (code + counts_[length - 1]) << 1;
+        firstCodes_[length] = code;
+        firstIndexes_[length] = index;
+        index += counts_[length];
+    }
+
+    symbols_.resize(index);
+    std::uint32_t nextIndexes[WORD_MAX_CODE_LENGTH + 1]{0};
+    std::copy(std::cbegin(firstIndexes_), std::cend(firstIndexes_), std::begin(nextIndexes));
+    for(std::size_t symbol = 0; symbol < lengths.size(); ++symbol) {
+        const auto length = lengths[symbol];
+        if(length == 0) {
+            continue;
+        }
+        symbols_[nextIndexes[length]++] = static_cast<std::uint16_t>(symbol);
+
+        // every window starting with a short code
+        if(length <= PEEK_BITS) {
+            const auto first = std::size_t{codes[symbol]} << (PEEK_BITS - length);
+            const auto last = first + (std::size_t{1} << (PEEK_BITS - length));
+            for(auto window = first; window < last; ++window) {
+                entries_[window].symbol = static_cast<std::uint16_t>(symbol);
+                entries_[window].length = length;
+            }
+        }
+    }
+}
+
+std::uint16_t WordDecoder::decodeSymbol(BitReader& reader) const
+{
+    const auto& entry = entries_[reader.peek(PEEK_BITS)];
+    if(entry.length != 0) {
+        reader.skip(entry.length);
+        return entry.symbol;
+    }
+
+    const auto code = reader.peek(maxLength_);
+    for(auto length = PEEK_BITS + 1; length <= maxLength_; ++length) {
+        const auto prefix = code >> (maxLength_ - length);
+        if(prefix - firstCodes_[length] < counts_[length]) {
+            reader.skip(length);
+            return symbols_[firstIndexes_[length] + prefix - firstCodes_[length]];
+        }
+    }
+    throw std::runtime_error{"Invalid Huffman code"};
+}
+
+std::uint64_t WordDecoder::decode(const std::uint8_t* first, const std::uint8_t* last, std::size_t wordsCount, std::uint8_t* output) const
+{
+    static_assert (2 * WORD_MAX_CODE_LENGTH <= BitReader::MAX_PEEK_BITS, "two codes must fit in a refill");
+
+    BitReader reader(first, last);
+    for(std::size_t wordIndex = 0; wordIndex < wordsCount; ++wordIndex) {
+        if(wordIndex % 2 == 0) {
+            reader.refill();
+        }
+        const auto symbol = decodeSymbol(reader);
+        output[2 * wordIndex] = static_cast<std::uint8_t>(symbol);
+        output[2 * wordIndex + 1] = static_cast<std::uint8_t>(symbol >> 8);
+    }
+    return reader.consumedBits();
+}
@@ -0,0 +1,90 @@
+#ifndef WORDCODEC_HPP
+#define WORDCODEC_HPP
+
+#include "bitreader.hpp"
+#include "bitwriter.hpp"
+#include "bufferalloc.hpp"
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+
+// Huffman coding over an alphabet of 16-bit symbols: the block is read as little endian pairs of bytes,
+// so a repeated sample or token costs one code instead of two.
+// With up to 65536 symbols only code lengths are stored and the codes are canonical (as in deflate):
+// the lengths are built by two queues over the sorted frequencies and limited to WORD_MAX_CODE_LENGTH,
+// the decoder looks up short codes in a table and finds longer ones by the first codes of every length.
+
+constexpr std::size_t WORD_ALPHABET_SIZE = 65536;
+constexpr unsigned WORD_MAX_CODE_LENGTH = 24;
+
+using WordFrequencies = std::vector<std::uint64_t>;
+using CodeLengths = std::vector<std::uint8_t>; // 0 - the symbol has no code
+
+inline std::uint16_t load_word(const std::uint8_t* data) { return static_cast<std::uint16_t>(data[0] | (data[1] << 8)); }
+
+// frequencies gets WORD_ALPHABET_SIZE counters, wordsCount words of data are counted
+void count_words(const std::uint8_t* data, std::size_t wordsCount, WordFrequencies& frequencies);
+
+// lengths of the optimal prefix code for the symbols with non-zero frequency, none longer than maxLength;
+// the only symbol gets length 1
+CodeLengths build_code_lengths(const WordFrequencies& frequencies, unsigned maxLength = WORD_MAX_CODE_LENGTH);
+
+// canonical codes of lengths, throws if they don't make a prefix code
+std::vector<std::uint32_t> canonical_codes(const CodeLengths& lengths);
+
+class WordEncoder {
+public:
+    explicit WordEncoder(const CodeLengths& lengths);
+
+    // exact size in bits of the codes of the counted words
+    std::uint64_t encodedBitsCount(const WordFrequencies& frequencies) const;
+    // the words must have codes
+    void encode(const std::uint8_t* data, std::size_t wordsCount, BitWriter& writer) const
+    {
+        for(std::size_t wordIndex = 0; wordIndex < wordsCount; ++wordIndex) {
+            const auto symbol = load_word(data + 2 * wordIndex);
+            writer.put(codes_[symbol], lengths_[symbol]);
+        }
+    }
+
+private:
+    CodeLengths lengths_;
+    std::vector<std::uint32_t> codes_;
+};
+
+class WordDecoder {
+public:
+    static constexpr unsigned PEEK_BITS = 11;
+
+    // throws if the lengths don't make a prefix code
+    explicit WordDecoder(const CodeLengths& lengths);
+
+    // decodes exactly wordsCount words (little endian) to output, returns count of consumed bits
+    // (greater than (last - first) * 8 if the data is truncated)
+    std::uint64_t decode(const std::uint8_t* first, const std::uint8_t* last, std::size_t wordsCount, std::uint8_t* output) const;
+
+private:
+    // the reader must be refilled
+    std::uint16_t decodeSymbol(BitReader& reader) const;
+
+private:
+    struct Entry {
+        std::uint16_t symbol = 0;
+        std::uint8_t length = 0; // 0 - the code is longer than the window
+        std::uint8_t reserved = 0;
+    };
+    static_assert (sizeof(Entry) == 4, "");
+
+private:
+    unsigned maxLength_ = 0;
+    TableBuffer<Entry> entries_;
+    // canonical decoding of the longer codes: the codes of a length are consecutive from its first code
+    std::uint32_t firstCodes_[WORD_MAX_CODE_LENGTH + 1]{0};
+    std::uint32_t counts_[WORD_MAX_CODE_LENGTH + 1]{0};
+    std::uint32_t firstIndexes_[WORD_MAX_CODE_LENGTH + 1]{0};
+    TableBuffer<std::uint16_t> symbols_; // by length, then by symbol
+};
+
+#endif // WORDCODEC_HPP